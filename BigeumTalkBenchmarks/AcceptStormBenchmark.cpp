@@ -0,0 +1,178 @@
+﻿#include "pch.h"
+#include "Service.h"
+#include "Listener.h"
+#include "PacketHandler.h"
+#include "BenchmarkUtils.h"
+#include <fstream>
+#include <sstream>
+#include <poll.h>
+#include <sys/resource.h>
+
+/*
+ * 접속 폭주 벤치마크 [user-013]
+ * 비블로킹 connect를 한번에 CLIENT_COUNT개 보내고 서버가 모두 Accept할 때까지의 접속률과 SYN 백로그 손실을 잽니다.
+ *  - 고정 : minCount = maxCount = FIXED_COUNT, 이전 방식의 고정 AcceptEx 풀
+ *  - 적응 : 기본 AcceptConfig (16 ~ 4096), 요청이 바닥나면 두배로 늘어남
+ * 모두 Accept 된 뒤 IDLE_SECONDS 동안 접속이 없으면 Tick에서 요청 수가 minCount까지 줄어드는지도 확인합니다.
+ * 손실은 /proc/net/netstat의 ListenOverflows, ListenDrops 증가량이며 시스템 전체 값이므로 다른 부하가 없을 때 실행합니다.
+ * 서버는 BigeumTalkServer처럼 샤드 하나에서 Dispatch, ResetArena, Tick을 반복하며 Service::Tick 대신 Listener를 직접 확인합니다.
+ */
+
+namespace
+{
+	enum
+	{
+		PORT = 31002, // 실행마다 다음 포트 사용, 클라이언트가 쓰는 임시 포트 범위(32768~) 밖
+		CLIENT_COUNT = 6000, // 백로그(SOMAXCONN)보다 많게, 클라이언트와 서버 세션이 각각 소켓을 가지므로 열 수 있는 파일 수 안에서
+		FIXED_COUNT = 100,
+		IDLE_SECONDS = 2,
+		TICK_MS = 100,
+	};
+
+	/** \brief /proc/net/netstat의 TcpExt 항목 값을 반환하는 함수 \return 값, 없으면 0 */
+	long long TcpExt(const string& name)
+	{
+		ifstream netstat("/proc/net/netstat");
+		string names;
+		string values;
+		while (getline(netstat, names) && getline(netstat, values))
+		{
+			if (names.rfind("TcpExt:", 0) != 0)
+			{
+				continue;
+			}
+
+			istringstream nameStream(names);
+			istringstream valueStream(values);
+			string key;
+			string value;
+			while (nameStream >> key && valueStream >> value)
+			{
+				if (key == name)
+				{
+					return stoll(value);
+				}
+			}
+		}
+		return 0;
+	}
+
+	/** \brief 리슨 소켓의 Accept 대기열 길이를 반환하는 함수 \return 연결이 끝났지만 Accept 되지 않은 수 */
+	unsigned int AcceptQueueLength(SOCKET listenSocket)
+	{
+		tcp_info info = {};
+		socklen_t size = sizeof(info);
+		getsockopt(listenSocket, IPPROTO_TCP, TCP_INFO, &info, &size);
+		return info.tcpi_unacked;
+	}
+
+	/**
+	 * \brief 서버를 띄우고 접속 폭주를 보내 결과를 출력하는 함수
+	 * \param name 출력할 이름
+	 * \param config 리슨 소켓의 Accept 설정
+	 * \param port 사용할 포트
+	 */
+	void Run(const char* name, const AcceptConfig& config, unsigned short port)
+	{
+		auto iocp = make_shared<Iocp>(Iocp::MAX_BATCH_SIZE);
+		auto service = make_shared<Service>(iocp, L"127.0.0.1", port);
+		service->SetAcceptConfig(config);
+		auto listener = make_shared<Listener>();
+		ASSERT_CRASH(listener->StartAccept(service));
+
+		atomic<bool> stop = false;
+		thread server([&]()
+		{
+			while (stop.load() == false)
+			{
+				iocp->Dispatch(TICK_MS);
+				PacketHandler::ResetArena();
+				listener->CheckAcceptTimeout();
+				listener->UpdateAcceptRate();
+			}
+		});
+
+		SOCKADDR_IN address = {};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+		const long long overflowsBefore = TcpExt("ListenOverflows");
+		const long long dropsBefore = TcpExt("ListenDrops");
+		const auto start = chrono::steady_clock::now();
+
+		// 모든 SYN을 한번에 보냄, 백로그가 가득 차면 커널이 SYN을 버리고 클라이언트는 1초 뒤 재전송
+		vector<pollfd> clients(CLIENT_COUNT);
+		for (pollfd& client : clients)
+		{
+			client.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+			client.events = POLLOUT;
+			ASSERT_CRASH(client.fd != INVALID_SOCKET);
+			connect(client.fd, reinterpret_cast<SOCKADDR*>(&address), sizeof(address));
+		}
+
+		// 모든 connect가 끝나고 Accept 대기열이 빌 때까지 기다림
+		unsigned int connected = 0;
+		unsigned int peakTarget = 0;
+		while (connected < CLIENT_COUNT || AcceptQueueLength(listener->GetHandle()) > 0)
+		{
+			poll(clients.data(), clients.size(), 10);
+			peakTarget = max(peakTarget, listener->GetAcceptStats().targetCount);
+			for (pollfd& client : clients)
+			{
+				if (client.events != 0 && client.revents != 0)
+				{
+					client.events = 0; // 다음 poll에서 제외
+					connected++;
+				}
+				client.revents = 0;
+			}
+		}
+
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		const long long overflows = TcpExt("ListenOverflows") - overflowsBefore;
+		const long long drops = TcpExt("ListenDrops") - dropsBefore;
+
+		// 접속이 끊긴 채로 두어 Tick이 요청 수를 줄이는지 확인
+		this_thread::sleep_for(chrono::seconds(IDLE_SECONDS + 1) + chrono::milliseconds(TICK_MS) * 20);
+		const AcceptStats idleStats = listener->GetAcceptStats();
+
+		const double acceptsPerSecond = static_cast<double>(CLIENT_COUNT) / seconds;
+		printf("%-10s %12.0f %10lld %10lld %12u %8u/%-8u\n", name, acceptsPerSecond, overflows, drops, peakTarget,
+		       idleStats.outstanding, idleStats.targetCount);
+
+		// 서버가 연결 종료를 처리하여 세션 소켓을 닫을 때까지 기다림
+		for (pollfd& client : clients)
+		{
+			closesocket(client.fd);
+		}
+		this_thread::sleep_for(chrono::milliseconds(TICK_MS) * 10);
+
+		stop.store(true);
+		server.join();
+	}
+}
+
+int main()
+{
+	// 클라이언트와 서버 소켓을 한 프로세스에서 열므로 파일 수 제한을 최대로 올림
+	rlimit limit = {};
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	AcceptConfig fixed;
+	fixed.minCount = FIXED_COUNT;
+	fixed.maxCount = FIXED_COUNT;
+	fixed.idleSeconds = IDLE_SECONDS;
+
+	AcceptConfig adaptive;
+	adaptive.idleSeconds = IDLE_SECONDS;
+
+	printf("%d connects at once, backlog %d, idle check after %ds\n", CLIENT_COUNT, SOMAXCONN, IDLE_SECONDS);
+	printf("%-10s %12s %10s %10s %12s %17s\n", "pool", "accepts/s", "overflows", "drops", "peak target",
+	       "idle out/target");
+	Run("fixed", fixed, PORT);
+	Run("adaptive", adaptive, PORT + 1);
+	return 0;
+}
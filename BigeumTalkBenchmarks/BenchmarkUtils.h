@@ -0,0 +1,43 @@
+﻿#pragma once
+#include <chrono>
+#include <cstdio>
+
+/*
+ * 벤치마크 공용 도구
+ * 벤치마크는 프레임워크 없이 실행 파일 하나로 동작하며 결과를 표로 출력합니다. Release 빌드에서 실행합니다.
+ */
+
+
+/**
+ * \brief 컴파일러가 값을 계산하지 않고 지우지 못하게 하는 함수
+ */
+template <typename T>
+inline void KeepAlive(const T& value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+
+/**
+ * \brief 함수를 반복 실행하여 한번에 걸린 시간을 재는 함수
+ * \details 먼저 몇번 실행하여 캐시와 풀을 데운 뒤 잽니다.
+ * \param iterations 잴 반복 횟수
+ * \param func 잴 함수
+ * \return 한번 실행에 걸린 나노초
+ */
+template <typename Func>
+double MeasureNanoseconds(int iterations, Func&& func)
+{
+	for (int i = 0; i < iterations / 10 + 1; i++)
+	{
+		func();
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		func();
+	}
+	const auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
@@ -0,0 +1,154 @@
+﻿#include "pch.h"
+#include "PacketCompressor.h"
+#include "PacketHandler.h"
+#include "BenchmarkUtils.h"
+#include <random>
+
+/*
+ * 패킷 압축 벤치마크 [user-025]
+ * 메시지 종류마다 압축률과 압축, 해제에 드는 CPU 시간을 재고 아낀 바이트당 비용을 출력합니다.
+ * 비교를 위해 같은 패킷을 protobuf로 직렬화하는 시간도 함께 잽니다.
+ */
+
+namespace
+{
+	enum
+	{
+		ITERATIONS = 20000,
+	};
+
+	mt19937 R(1);
+
+	string Nickname()
+	{
+		static const char* names[] = {"user", "player", "\xEB\xB9\x85\xEC\x9D\x8C", "guest", "alice", "bob"};
+		return names[R() % size(names)] + to_string(R() % 100000);
+	}
+
+	Protocol::S_ROOM_LIST RoomList(int roomCount)
+	{
+		static const char* names[] = {"general chat", "\xEC\x9E\xA1\xEB\x8B\xB4\xEB\xB0\xA9", "study group", "game lobby"};
+		Protocol::S_ROOM_LIST pkt;
+		pkt.set_roomcount(roomCount);
+		for (int i = 0; i < roomCount; i++)
+		{
+			auto room = pkt.add_rooms();
+			room->set_id(i + 1);
+			room->set_roomname(string(names[R() % size(names)]) + ' ' + to_string(i));
+			room->set_hostname(Nickname());
+			room->set_maxuser(100);
+			room->set_usercount(R() % 100);
+		}
+		return pkt;
+	}
+
+	Protocol::S_ENTER_ROOM EnterRoom(int userCount)
+	{
+		Protocol::S_ENTER_ROOM pkt;
+		pkt.set_success(true);
+		auto room = pkt.mutable_roomdata();
+		room->set_id(1);
+		room->set_roomname("general chat");
+		room->set_hostname(Nickname());
+		room->set_maxuser(100);
+		room->set_usercount(userCount);
+		for (int i = 0; i < userCount; i++)
+		{
+			auto user = pkt.add_users();
+			user->set_id(1000 + R() % 100000);
+			user->set_nickname(Nickname());
+		}
+		return pkt;
+	}
+
+	Protocol::S_CHAT Chat(size_t length, bool text)
+	{
+		static const char* words[] = {"hello ", "the ", "server ", "room ", "\xEC\x95\x88\xEB\x85\x95 ", "lol ", "ok "};
+		string msg;
+		while (msg.size() < length)
+		{
+			msg += text ? words[R() % size(words)] : string(1, static_cast<char>('!' + R() % 90));
+		}
+
+		Protocol::S_CHAT pkt;
+		pkt.mutable_user()->set_id(7);
+		pkt.mutable_user()->set_nickname(Nickname());
+		pkt.set_msg(msg);
+		pkt.set_timestamp(1.76e9);
+		return pkt;
+	}
+
+	template <typename PacketType>
+	void Run(const char* name, PacketType& pkt, SendBufferRef (*makeBuffer)(PacketType&))
+	{
+		SendBufferRef sendBuffer = makeBuffer(pkt);
+		const double serialize = MeasureNanoseconds(ITERATIONS, [&]()
+		{
+			KeepAlive(makeBuffer(pkt));
+		});
+
+		SendBufferRef compressed = PacketCompressor::Compress(sendBuffer);
+		const double compress = MeasureNanoseconds(ITERATIONS, [&]()
+		{
+			KeepAlive(PacketCompressor::Compress(sendBuffer));
+		});
+
+		const unsigned int packetSize = sendBuffer->PacketSize();
+		if (compressed == nullptr)
+		{
+			printf("%-24s %7u %7s %6s %9.0f %9.0f %9s %9s\n", name, packetSize, "raw", "-", serialize, compress, "-", "-");
+			return;
+		}
+
+		// 압축한 패킷의 헤더와 원본 크기 뒤가 LZ 블록
+		const string wire = [&]()
+		{
+			string out;
+			for (SendBuffer* segment = compressed.get(); segment != nullptr; segment = segment->Next())
+			{
+				out.append(reinterpret_cast<char*>(segment->Buffer()), segment->WriteSize());
+			}
+			return out;
+		}();
+		const size_t headerSize = reinterpret_cast<const PacketHeader*>(wire.data())->size == 0 ? sizeof(PacketHeaderV2) : sizeof(PacketHeader);
+		unsigned int dataSize;
+		memcpy(&dataSize, wire.data() + headerSize, sizeof(dataSize));
+		const BYTE* block = reinterpret_cast<const BYTE*>(wire.data()) + headerSize + sizeof(dataSize);
+		const unsigned int blockSize = static_cast<unsigned int>(wire.size() - headerSize - sizeof(dataSize));
+
+		vector<BYTE> out(dataSize);
+		const double decompress = MeasureNanoseconds(ITERATIONS, [&]()
+		{
+			KeepAlive(PacketCompressor::Decompress(block, blockSize, out.data(), dataSize));
+		});
+
+		const unsigned int saved = packetSize - compressed->PacketSize();
+		printf("%-24s %7u %7u %5.1f%% %9.0f %9.0f %9.0f %9.2f\n", name, packetSize, compressed->PacketSize(),
+		       100.0 * compressed->PacketSize() / packetSize, serialize, compress, decompress, (compress + decompress) / saved);
+	}
+}
+
+
+int main()
+{
+	printf("%-24s %7s %7s %6s %9s %9s %9s %9s\n", "message", "bytes", "wire", "ratio", "proto ns", "comp ns", "decomp ns",
+	       "ns/saved");
+
+	auto rooms10 = RoomList(10);
+	Run("S_ROOM_LIST 10 rooms", rooms10, &PacketHandler::MakeBuffer_S_ROOM_LIST);
+	auto rooms100 = RoomList(100);
+	Run("S_ROOM_LIST 100 rooms", rooms100, &PacketHandler::MakeBuffer_S_ROOM_LIST);
+	auto users20 = EnterRoom(20);
+	Run("S_ENTER_ROOM 20 users", users20, &PacketHandler::MakeBuffer_S_ENTER_ROOM);
+	auto users100 = EnterRoom(100);
+	Run("S_ENTER_ROOM 100 users", users100, &PacketHandler::MakeBuffer_S_ENTER_ROOM);
+	auto chatText = Chat(1000, true);
+	Run("S_CHAT 1KB text", chatText, &PacketHandler::MakeBuffer_S_CHAT);
+	auto chatLong = Chat(16000, true);
+	Run("S_CHAT 16KB text", chatLong, &PacketHandler::MakeBuffer_S_CHAT);
+	auto chatNoise = Chat(1000, false);
+	Run("S_CHAT 1KB random", chatNoise, &PacketHandler::MakeBuffer_S_CHAT);
+
+	printf("\nSession::Send compresses only packets of %d bytes or more (COMPRESS_THRESHOLD)\n", PacketCompressor::COMPRESS_THRESHOLD);
+	return 0;
+}
@@ -0,0 +1,145 @@
+﻿#include "pch.h"
+#include "PacketHandler.h"
+#include "BenchmarkUtils.h"
+#include <random>
+
+/*
+ * 패킷 디스패치 벤치마크 [user-019]
+ * 이전의 unordered_map<unsigned short, std::function> 조회와 PacketHandlerTable 배열 조회의 패킷당 비용을 비교합니다.
+ * 파싱 비용을 빼고 디스패치만 재도록 두 방식 모두 같은 빈 처리 함수를 부르며, 도착하는 ID는 무작위로 섞습니다.
+ */
+
+namespace
+{
+	enum
+	{
+		PACKET_COUNT = 4096, // 한번에 디스패치할 패킷 수, 2의 거듭제곱
+		ITERATIONS = 2000,
+	};
+
+	/**
+	 * \brief 벤치마크용 테이블 항목
+	 * \details 파싱하지 않고 첫 바이트와 길이만 보는 처리 함수이며 인라인되지 않도록 막습니다.
+	 */
+	template <unsigned short Id>
+	struct NopEntry
+	{
+		static constexpr unsigned short ID = Id;
+
+		__attribute__((noinline)) static bool Handle(shared_ptr<Session>&, BYTE* buffer, int len)
+		{
+			return buffer[0] + len != 0;
+		}
+	};
+
+	using NopTable = PacketHandlerTable<
+		NopEntry<Protocol::PACKET_ID_C_LOGIN>,
+		NopEntry<Protocol::PACKET_ID_C_CREATE_ROOM>,
+		NopEntry<Protocol::PACKET_ID_C_ENTER_ROOM>,
+		NopEntry<Protocol::PACKET_ID_C_LEAVE_ROOM>,
+		NopEntry<Protocol::PACKET_ID_C_ROOM_LIST>,
+		NopEntry<Protocol::PACKET_ID_C_CHAT>
+	>;
+
+	constexpr auto GNopHandler = NopTable::Build();
+
+	unordered_map<unsigned short, function<bool(shared_ptr<Session>&, BYTE*, int)>> GMapHandler; // 이전 방식
+
+	void InitMapHandler()
+	{
+		GMapHandler.emplace(Protocol::PACKET_ID_C_LOGIN, [](shared_ptr<Session>& s, BYTE* b, int l) { return NopEntry<Protocol::PACKET_ID_C_LOGIN>::Handle(s, b, l); });
+		GMapHandler.emplace(Protocol::PACKET_ID_C_CREATE_ROOM, [](shared_ptr<Session>& s, BYTE* b, int l) { return NopEntry<Protocol::PACKET_ID_C_CREATE_ROOM>::Handle(s, b, l); });
+		GMapHandler.emplace(Protocol::PACKET_ID_C_ENTER_ROOM, [](shared_ptr<Session>& s, BYTE* b, int l) { return NopEntry<Protocol::PACKET_ID_C_ENTER_ROOM>::Handle(s, b, l); });
+		GMapHandler.emplace(Protocol::PACKET_ID_C_LEAVE_ROOM, [](shared_ptr<Session>& s, BYTE* b, int l) { return NopEntry<Protocol::PACKET_ID_C_LEAVE_ROOM>::Handle(s, b, l); });
+		GMapHandler.emplace(Protocol::PACKET_ID_C_ROOM_LIST, [](shared_ptr<Session>& s, BYTE* b, int l) { return NopEntry<Protocol::PACKET_ID_C_ROOM_LIST>::Handle(s, b, l); });
+		GMapHandler.emplace(Protocol::PACKET_ID_C_CHAT, [](shared_ptr<Session>& s, BYTE* b, int l) { return NopEntry<Protocol::PACKET_ID_C_CHAT>::Handle(s, b, l); });
+	}
+
+	bool DispatchMap(shared_ptr<Session>& session, BYTE* buffer, int len)
+	{
+		auto it = GMapHandler.find(reinterpret_cast<PacketHeader*>(buffer)->id);
+		if (it == GMapHandler.end())
+		{
+			return false;
+		}
+		return it->second(session, buffer, len);
+	}
+
+	bool DispatchTable(shared_ptr<Session>& session, BYTE* buffer, int len)
+	{
+		auto header = reinterpret_cast<PacketHeader*>(buffer);
+		if (header->id >= GNopHandler.size())
+		{
+			return false;
+		}
+		return GNopHandler[header->id](session, buffer, len);
+	}
+
+	/**
+	 * \brief 도착할 패킷 헤더를 만드는 함수
+	 * \param unknownPercent 등록되지 않은 ID의 비율
+	 * \return 헤더 목록
+	 */
+	vector<PacketHeader> MakeHeaders(int unknownPercent)
+	{
+		static const unsigned short clientIds[] = {
+			Protocol::PACKET_ID_C_LOGIN, Protocol::PACKET_ID_C_CREATE_ROOM, Protocol::PACKET_ID_C_ENTER_ROOM,
+			Protocol::PACKET_ID_C_LEAVE_ROOM, Protocol::PACKET_ID_C_ROOM_LIST, Protocol::PACKET_ID_C_CHAT,
+		};
+
+		mt19937 random(1);
+		vector<PacketHeader> headers(PACKET_COUNT);
+		for (PacketHeader& header : headers)
+		{
+			header.size = sizeof(PacketHeader);
+			if (static_cast<int>(random() % 100) < unknownPercent)
+			{
+				header.id = static_cast<unsigned short>(random() % 0x10000);
+			}
+			else
+			{
+				// 실제 트래픽처럼 대부분 채팅
+				header.id = random() % 4 != 0 ? static_cast<unsigned short>(Protocol::PACKET_ID_C_CHAT) : clientIds[random() % size(clientIds)];
+			}
+		}
+		return headers;
+	}
+
+	template <typename Dispatch>
+	double Measure(vector<PacketHeader>& headers, Dispatch dispatch)
+	{
+		shared_ptr<Session> session;
+		const double batch = MeasureNanoseconds(ITERATIONS, [&]()
+		{
+			int handled = 0;
+			for (PacketHeader& header : headers)
+			{
+				handled += dispatch(session, reinterpret_cast<BYTE*>(&header), header.size);
+			}
+			KeepAlive(handled);
+		});
+		return batch / PACKET_COUNT;
+	}
+
+	void Run(const char* name, int unknownPercent)
+	{
+		auto headers = MakeHeaders(unknownPercent);
+		const double mapNs = Measure(headers, &DispatchMap);
+		const double tableNs = Measure(headers, &DispatchTable);
+		printf("%-24s %10.2f %10.2f %8.1fx\n", name, mapNs, tableNs, mapNs / tableNs);
+	}
+}
+
+
+int main()
+{
+	InitMapHandler();
+
+	printf("%-24s %10s %10s %9s\n", "ids", "map ns", "table ns", "speedup");
+	Run("registered only", 0);
+	Run("10% unknown", 10);
+	Run("50% unknown", 50);
+
+	printf("\nns per packet, dispatch only (handlers are empty and not inlined)\n");
+	return 0;
+}
@@ -0,0 +1,314 @@
+﻿#include "pch.h"
+#include "Service.h"
+#include "PacketHandler.h"
+#include <map>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+/*
+ * IO 엔진 시스템 콜 벤치마크 [user-002]
+ * 채팅 메시지 하나를 처리하는 동안 서버가 부르는 시스템 콜 수를 셉니다.
+ * 빌드한 엔진(기본 epoll, USE_IO_URING이면 io_uring)으로 서버를 자식 프로세스에서 실행하고 ptrace로 시스템 콜을 셉니다.
+ * 두 엔진을 비교하려면 두 빌드의 결과를 비교합니다.
+ *  - 서버 : 샤드 하나, BigeumTalkServer와 같은 Dispatch, ResetArena, Tick 반복
+ *  - 클라이언트 : CLIENT_COUNT개가 한 방에 들어간 뒤 모두 채팅 하나씩 보내고 모든 브로드캐스트를 받는 것을 ROUND_COUNT번 반복
+ * 클라이언트는 채팅 구간의 시작과 끝을 SIGUSR1, SIGUSR2로 알리며, 추적하는 쪽은 이 시그널을 서버에 전달하지 않습니다.
+ */
+
+namespace
+{
+	enum
+	{
+		PORT = 37001,
+		CLIENT_COUNT = 20,
+		ROUND_COUNT = 200,
+		TICK_MS = 1000,
+	};
+
+	/* 서버 */
+	[[noreturn]] void RunServer()
+	{
+		auto iocp = make_shared<Iocp>(Iocp::MAX_BATCH_SIZE);
+		auto service = make_shared<Service>(iocp, L"127.0.0.1", PORT);
+		ASSERT_CRASH(service->Start());
+
+		while (true)
+		{
+			iocp->Dispatch(TICK_MS);
+			PacketHandler::ResetArena();
+			service->Tick(0);
+		}
+	}
+
+	/* 클라이언트 */
+	struct Client
+	{
+		SOCKET socket = INVALID_SOCKET;
+		string received;
+	};
+
+	template <typename PacketType>
+	void SendPacket(Client& client, unsigned short id, const PacketType& pkt)
+	{
+		string packet(sizeof(PacketHeader), '\0');
+		pkt.AppendToString(&packet);
+		auto header = reinterpret_cast<PacketHeader*>(packet.data());
+		header->size = static_cast<unsigned short>(packet.size());
+		header->id = id;
+		ASSERT_CRASH(send(client.socket, packet.data(), packet.size(), 0) == static_cast<ssize_t>(packet.size()));
+	}
+
+	/**
+	 * \brief id 패킷이 올 때까지 받는 함수
+	 * \return 받은 패킷의 본문
+	 */
+	string RecvPacket(Client& client, unsigned short id)
+	{
+		while (true)
+		{
+			if (client.received.size() >= sizeof(PacketHeader))
+			{
+				const PacketHeader header = *reinterpret_cast<const PacketHeader*>(client.received.data());
+				if (client.received.size() >= header.size)
+				{
+					string body = client.received.substr(sizeof(PacketHeader), header.size - sizeof(PacketHeader));
+					client.received.erase(0, header.size);
+					if (header.id == id)
+					{
+						return body;
+					}
+					continue;
+				}
+			}
+
+			char buffer[0x10000];
+			const ssize_t received = recv(client.socket, buffer, sizeof(buffer), 0);
+			ASSERT_CRASH(received > 0);
+			client.received.append(buffer, received);
+		}
+	}
+
+	Client Connect()
+	{
+		Client client;
+		client.socket = socket(AF_INET, SOCK_STREAM, 0);
+		SOCKADDR_IN address = {};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(PORT);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		while (connect(client.socket, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) != 0)
+		{
+			// 서버가 아직 리슨하지 않음
+			close(client.socket);
+			this_thread::sleep_for(chrono::milliseconds(50));
+			client.socket = socket(AF_INET, SOCK_STREAM, 0);
+		}
+
+		const int noDelay = 1;
+		setsockopt(client.socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+		timeval timeout = {10, 0};
+		setsockopt(client.socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		return client;
+	}
+
+	[[noreturn]] void RunClients(pid_t server)
+	{
+		vector<Client> clients;
+		for (int i = 0; i < CLIENT_COUNT; i++)
+		{
+			clients.push_back(Connect());
+
+			Protocol::C_LOGIN login;
+			login.mutable_user()->set_nickname("bench" + to_string(i));
+			SendPacket(clients.back(), Protocol::PACKET_ID_C_LOGIN, login);
+			RecvPacket(clients.back(), Protocol::PACKET_ID_S_LOGIN);
+		}
+
+		Protocol::C_CREATE_ROOM create;
+		create.mutable_user()->set_nickname("bench0");
+		create.set_roomname("bench");
+		SendPacket(clients[0], Protocol::PACKET_ID_C_CREATE_ROOM, create);
+		Protocol::S_CREATE_ROOM created;
+		ASSERT_CRASH(created.ParseFromString(RecvPacket(clients[0], Protocol::PACKET_ID_S_CREATE_ROOM)) && created.success());
+
+		for (int i = 1; i < CLIENT_COUNT; i++)
+		{
+			Protocol::C_ENTER_ROOM enter;
+			enter.mutable_user()->set_nickname("bench" + to_string(i));
+			enter.set_roomid(created.room().id());
+			SendPacket(clients[i], Protocol::PACKET_ID_C_ENTER_ROOM, enter);
+			RecvPacket(clients[i], Protocol::PACKET_ID_S_ENTER_ROOM);
+		}
+
+		// 입장 알림이 모두 처리되도록 잠시 기다린 뒤 측정 시작
+		this_thread::sleep_for(chrono::milliseconds(200));
+		kill(server, SIGUSR1);
+		this_thread::sleep_for(chrono::milliseconds(50));
+
+		Protocol::C_CHAT chat;
+		chat.set_msg("hello, this is a chat message of a typical length");
+		for (int round = 0; round < ROUND_COUNT; round++)
+		{
+			for (int i = 0; i < CLIENT_COUNT; i++)
+			{
+				chat.mutable_user()->set_nickname("bench" + to_string(i));
+				SendPacket(clients[i], Protocol::PACKET_ID_C_CHAT, chat);
+			}
+
+			for (Client& client : clients)
+			{
+				for (int i = 0; i < CLIENT_COUNT; i++)
+				{
+					RecvPacket(client, Protocol::PACKET_ID_S_CHAT);
+				}
+			}
+		}
+
+		kill(server, SIGUSR2);
+		_exit(0);
+	}
+
+	/* 시스템 콜 추적 */
+	const char* SyscallName(long long nr)
+	{
+		static const map<long long, const char*> names = {
+			{SYS_read, "read"}, {SYS_write, "write"}, {SYS_readv, "readv"}, {SYS_writev, "writev"},
+			{SYS_recvfrom, "recvfrom"}, {SYS_sendto, "sendto"}, {SYS_recvmsg, "recvmsg"}, {SYS_sendmsg, "sendmsg"},
+			{SYS_epoll_wait, "epoll_wait"}, {SYS_epoll_pwait, "epoll_pwait"}, {SYS_epoll_ctl, "epoll_ctl"},
+			{SYS_io_uring_enter, "io_uring_enter"}, {SYS_futex, "futex"}, {SYS_accept4, "accept4"},
+			{SYS_close, "close"}, {SYS_fcntl, "fcntl"}, {SYS_restart_syscall, "restart_syscall"},
+		};
+		auto it = names.find(nr);
+		return it != names.end() ? it->second : nullptr;
+	}
+
+	/**
+	 * \brief 서버의 모든 쓰레드를 추적하며 측정 구간의 시스템 콜을 세는 함수
+	 * \return 시스템 콜 번호별 호출 수
+	 */
+	map<long long, long long> TraceServer(pid_t server)
+	{
+		map<long long, long long> counts;
+		bool measuring = false;
+		bool measured = false;
+
+		int status = 0;
+		waitpid(server, &status, 0); // PTRACE_TRACEME 뒤의 SIGSTOP
+		ptrace(PTRACE_SETOPTIONS, server, nullptr, PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL);
+		ptrace(PTRACE_SYSCALL, server, nullptr, nullptr);
+
+		while (measured == false)
+		{
+			const pid_t tid = waitpid(-1, &status, __WALL);
+			if (tid < 0)
+			{
+				break;
+			}
+
+			if (WIFEXITED(status) || WIFSIGNALED(status))
+			{
+				if (tid == server)
+				{
+					break;
+				}
+				continue;
+			}
+
+			int signal = 0;
+			const int stopSignal = WSTOPSIG(status);
+			if (stopSignal == (SIGTRAP | 0x80))
+			{
+				__ptrace_syscall_info info = {};
+				ptrace(PTRACE_GET_SYSCALL_INFO, tid, reinterpret_cast<void*>(sizeof(info)), &info);
+				if (measuring && info.op == PTRACE_SYSCALL_INFO_ENTRY)
+				{
+					counts[static_cast<long long>(info.entry.nr)]++;
+				}
+			}
+			else if (stopSignal == SIGTRAP || (stopSignal == SIGSTOP && (status >> 16) == 0 && tid != server))
+			{
+				// 쓰레드 생성 알림, 새 쓰레드의 첫 정지
+			}
+			else if (stopSignal == SIGUSR1)
+			{
+				measuring = true;
+			}
+			else if (stopSignal == SIGUSR2)
+			{
+				measured = true;
+			}
+			else
+			{
+				signal = stopSignal;
+			}
+
+			ptrace(PTRACE_SYSCALL, tid, nullptr, reinterpret_cast<void*>(static_cast<intptr_t>(signal)));
+		}
+
+		kill(server, SIGKILL);
+		return counts;
+	}
+}
+
+
+int main()
+{
+	const pid_t server = fork();
+	if (server == 0)
+	{
+		ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+		raise(SIGSTOP);
+		RunServer();
+	}
+
+	const pid_t clients = fork();
+	if (clients == 0)
+	{
+		RunClients(server);
+	}
+
+	const auto begin = chrono::steady_clock::now();
+	map<long long, long long> counts = TraceServer(server);
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+	int status = 0;
+	waitpid(clients, &status, 0);
+	waitpid(server, nullptr, 0);
+	if (WIFEXITED(status) == false || WEXITSTATUS(status) != 0)
+	{
+		printf("clients failed\n");
+		return 1;
+	}
+
+#ifdef USE_IO_URING
+	const char* engine = "io_uring";
+#else
+	const char* engine = "epoll";
+#endif
+	const long long chatCount = static_cast<long long>(CLIENT_COUNT) * ROUND_COUNT;
+	const long long deliveryCount = chatCount * CLIENT_COUNT;
+
+	long long total = 0;
+	vector<pair<long long, long long>> sorted;
+	for (auto& [nr, count] : counts)
+	{
+		total += count;
+		sorted.emplace_back(count, nr);
+	}
+	sort(sorted.rbegin(), sorted.rend());
+
+	printf("engine %s, %d clients in one room, %lld chats, %lld deliveries (%.1fs under ptrace)\n", engine, CLIENT_COUNT, chatCount,
+	       deliveryCount, seconds);
+	printf("%-18s %10s %12s %14s\n", "syscall", "count", "per chat", "per delivery");
+	for (auto& [count, nr] : sorted)
+	{
+		const char* name = SyscallName(nr);
+		string label = name != nullptr ? name : "syscall " + to_string(nr);
+		printf("%-18s %10lld %12.2f %14.3f\n", label.c_str(), count, static_cast<double>(count) / chatCount,
+		       static_cast<double>(count) / deliveryCount);
+	}
+	printf("%-18s %10lld %12.2f %14.3f\n", "total", total, static_cast<double>(total) / chatCount,
+	       static_cast<double>(total) / deliveryCount);
+	return 0;
+}
@@ -0,0 +1,153 @@
+﻿#include "pch.h"
+#include "Iocp.h"
+#include "BenchmarkUtils.h"
+
+/*
+ * 비동기 IO 참조 벤치마크 [user-005]
+ * 비동기 IO 하나를 요청하고 완료하는 동안 객체 참조에 드는 비용을 이전 방식과 비교합니다.
+ *  - 이전 방식 : 요청할 때 _owner = shared_from_this(), 완료할 때 _owner를 복사하여 처리한 뒤 둘 다 놓음
+ *  - 현재 방식 : 요청할 때 _owner = this와 AddRef, 완료할 때 처리한 뒤 ReleaseRef
+ * 세션은 연결되어 있는 동안 항상 Recv를 걸어두므로 보통은 다른 IO의 참조가 있는 상태에서 참조를 늘리고 줄입니다.
+ * 참조가 0과 1 사이를 오가는 경우(첫 IO와 마지막 IO)는 자기 shared_ptr을 잡고 놓으므로 따로 잽니다.
+ */
+
+namespace
+{
+	enum
+	{
+		ITERATIONS = 5000000,
+	};
+
+	/* 이전 방식 */
+	class OldObject : public enable_shared_from_this<OldObject>
+	{
+	public:
+		__attribute__((noinline)) void Dispatch(int numOfBytes) { _received += numOfBytes; }
+
+		long long _received = 0;
+	};
+
+	struct OldEvent
+	{
+		shared_ptr<OldObject> _owner;
+	};
+
+	void OldRoundTrip(OldObject* object, OldEvent& iocpEvent)
+	{
+		// RegisterRecv
+		iocpEvent._owner = object->shared_from_this();
+
+		// Dispatch, 완료 패킷의 이벤트에서 꺼낸 뒤 이벤트의 참조를 놓음
+		shared_ptr<OldObject> owner = iocpEvent._owner;
+		iocpEvent._owner = nullptr;
+		owner->Dispatch(1);
+	}
+
+	/* 현재 방식 */
+	class NewObject : public IocpObject
+	{
+	public:
+		HANDLE GetHandle() override { return reinterpret_cast<HANDLE>(INVALID_SOCKET); }
+		__attribute__((noinline)) void Dispatch(IocpEvent*, int numOfBytes) override { _received += numOfBytes; }
+
+		long long _received = 0;
+	};
+
+	void NewRoundTrip(NewObject* object, IocpEvent& iocpEvent)
+	{
+		// RegisterRecv
+		iocpEvent._owner = object;
+		object->AddRef();
+
+		// Iocp::Dispatch
+		IocpObject* owner = iocpEvent._owner;
+		owner->Dispatch(&iocpEvent, 1);
+		owner->ReleaseRef();
+	}
+
+	/**
+	 * \brief 한 쓰레드에서 IO 하나의 참조 비용을 재는 함수
+	 * \param armed 다른 IO가 참조를 가지고 있는 상태인지 여부
+	 */
+	void RunSingle(const char* name, bool armed)
+	{
+		auto oldObject = make_shared<OldObject>();
+		OldEvent oldEvent;
+		OldEvent armedOldEvent;
+		if (armed)
+		{
+			armedOldEvent._owner = oldObject->shared_from_this();
+		}
+		const double oldNs = MeasureNanoseconds(ITERATIONS, [&]() { OldRoundTrip(oldObject.get(), oldEvent); });
+
+		auto newObject = make_shared<NewObject>();
+		RecvEvent newEvent;
+		if (armed)
+		{
+			newObject->AddRef();
+		}
+		const double newNs = MeasureNanoseconds(ITERATIONS, [&]() { NewRoundTrip(newObject.get(), newEvent); });
+		if (armed)
+		{
+			newObject->ReleaseRef();
+		}
+
+		KeepAlive(oldObject->_received + newObject->_received);
+		printf("%-30s %10.2f %10.2f\n", name, oldNs, newNs);
+	}
+
+	/**
+	 * \brief 두 쓰레드가 한 객체에 동시에 IO를 요청하고 완료하는 비용을 재는 함수
+	 * \details Recv 완료를 처리하는 쓰레드와 Send를 요청하는 쓰레드가 같은 세션의 참조를 늘리고 줄이는 상황입니다.
+	 */
+	template <typename Object, typename Event, typename RoundTrip>
+	double RunShared(RoundTrip roundTrip)
+	{
+		auto object = make_shared<Object>();
+		atomic<bool> start = false;
+		vector<thread> threads;
+		for (int t = 0; t < 2; t++)
+		{
+			threads.emplace_back([&]()
+			{
+				Event iocpEvent;
+				while (start.load() == false)
+				{
+					this_thread::yield();
+				}
+				for (int i = 0; i < ITERATIONS; i++)
+				{
+					roundTrip(object.get(), iocpEvent);
+				}
+			});
+		}
+
+		const auto begin = chrono::steady_clock::now();
+		start.store(true);
+		for (thread& t : threads)
+		{
+			t.join();
+		}
+		const auto end = chrono::steady_clock::now();
+		return chrono::duration<double, nano>(end - begin).count() / (ITERATIONS * 2.0);
+	}
+}
+
+
+int main()
+{
+	printf("%-30s %10s %10s\n", "case", "old ns", "new ns");
+	RunSingle("other IO pending (steady)", true);
+	RunSingle("no other IO (first/last IO)", false);
+
+	const double oldShared = RunShared<OldObject, OldEvent>(&OldRoundTrip);
+	const double newShared = RunShared<NewObject, RecvEvent>(&NewRoundTrip);
+	printf("%-30s %10.2f %10.2f\n", "two threads, one object", oldShared, newShared);
+
+	printf("\natomic read-modify-writes per IO\n");
+	printf("  old: 4 on the shared_ptr control block (shared_from_this, copy, two releases)\n");
+	printf("  new steady: 2 on _refCount (AddRef, ReleaseRef)\n");
+	printf("  new first/last IO: 2 on _refCount plus 2 on the control block (_self taken and dropped)\n");
+	printf("hardware threads: %u\n", thread::hardware_concurrency());
+	return 0;
+}
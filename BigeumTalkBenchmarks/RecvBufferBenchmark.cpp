@@ -0,0 +1,194 @@
+﻿#include "pch.h"
+#include "RecvBuffer.h"
+#include "BenchmarkUtils.h"
+#include <random>
+
+/*
+ * 수신 버퍼 벤치마크 [user-011]
+ * 연속으로 도착하는 패킷을 수신하고 파싱하는 동안 수신 버퍼가 데이터를 옮기는 비용을 이전 Clean 정책과 비교합니다.
+ *  - 이전 방식 : 0x10000 * 10 크기의 vector, 남은 공간이 0x10000보다 작아지면 남은 데이터를 앞으로 옮김
+ *  - 현재 방식 : RecvBuffer, 작은 패킷은 4KB 선형 슬랩(남은 잘린 패킷을 옮김), 큰 패킷은 미러링 슬랩(옮기지 않음)
+ * 수신 한번에 받는 양은 TCP 세그먼트가 쌓인 것처럼 무작위로 정하며, 두 방식 모두 같은 바이트열을 같은 크기로 나누어 받습니다.
+ * 데이터를 옮긴 양은 처리하지 않은 데이터가 남은 채 읽을 위치의 주소가 바뀐 경우를 세어 구합니다.
+ */
+
+namespace
+{
+	enum
+	{
+		STREAM_SIZE = 0x1000000, // 한번의 실행에서 받는 바이트 수
+		MAX_RECV_SIZE = 0x4000, // 수신 한번에 도착해 있는 최대 바이트 수
+		ROUNDS = 5,
+	};
+
+	/**
+	 * \brief 이전 방식의 수신 버퍼
+	 */
+	class OldRecvBuffer
+	{
+		enum
+		{
+			BUFFER_SIZE = 0x10000,
+			BUFFER_COUNT = 10,
+		};
+
+	public:
+		OldRecvBuffer() : _buffer(BUFFER_SIZE * BUFFER_COUNT)
+		{
+		}
+
+		void Clean()
+		{
+			const int dataSize = DataSize();
+			if (dataSize == 0)
+			{
+				_readPos = _writePos = 0;
+			}
+			else if (FreeSize() < BUFFER_SIZE)
+			{
+				memcpy(&_buffer[0], &_buffer[_readPos], dataSize);
+				_readPos = 0;
+				_writePos = dataSize;
+			}
+		}
+
+		bool Reserve(int packetSize) { return packetSize <= static_cast<int>(_buffer.size()); }
+		void OnRead(int numOfBytes) { _readPos += numOfBytes; }
+		void OnWrite(int numOfBytes) { _writePos += numOfBytes; }
+		BYTE* ReadPos() { return &_buffer[_readPos]; }
+		BYTE* WritePos() { return &_buffer[_writePos]; }
+		int DataSize() { return _writePos - _readPos; }
+		int FreeSize() { return static_cast<int>(_buffer.size()) - _writePos; }
+
+	private:
+		vector<BYTE> _buffer;
+		int _readPos = 0;
+		int _writePos = 0;
+	};
+
+	/**
+	 * \brief 도착할 패킷 바이트열과 수신 크기를 만드는 함수
+	 * \param minSize 가장 작은 패킷 크기
+	 * \param maxSize 가장 큰 패킷 크기
+	 */
+	void MakeStream(int minSize, int maxSize, OUT string& stream, OUT vector<int>& recvSizes)
+	{
+		mt19937 random(7);
+		stream.clear();
+		while (stream.size() < STREAM_SIZE)
+		{
+			const int packetSize = minSize + static_cast<int>(random() % (maxSize - minSize + 1));
+			const size_t offset = stream.size();
+			stream.resize(offset + packetSize, 'x');
+			auto header = reinterpret_cast<PacketHeader*>(&stream[offset]);
+			header->size = static_cast<unsigned short>(packetSize);
+			header->id = 1;
+		}
+
+		recvSizes.clear();
+		for (size_t received = 0; received < stream.size();)
+		{
+			const int recvSize = 1 + static_cast<int>(random() % MAX_RECV_SIZE);
+			recvSizes.push_back(recvSize);
+			received += recvSize;
+		}
+	}
+
+	/**
+	 * \brief 바이트열을 모두 받아 패킷으로 나누는 함수, Session::ProcessRecv와 같은 순서로 수신 버퍼를 사용
+	 * \param movedBytes 수신 버퍼가 옮긴 바이트 수
+	 * \return 처리한 패킷 수
+	 */
+	template <typename Buffer>
+	long long Receive(Buffer& recvBuffer, const string& stream, const vector<int>& recvSizes, OUT long long& movedBytes)
+	{
+		long long packetCount = 0;
+		size_t received = 0;
+		size_t recvIndex = 0;
+		int arrived = 0; // 도착해 있지만 아직 받지 않은 바이트 수
+		recvBuffer.Reserve(sizeof(PacketHeader));
+		while (received < stream.size())
+		{
+			if (arrived == 0)
+			{
+				arrived = recvSizes[recvIndex++];
+			}
+
+			const int recvSize = static_cast<int>(min<size_t>({static_cast<size_t>(arrived), static_cast<size_t>(recvBuffer.FreeSize()), stream.size() - received}));
+			memcpy(recvBuffer.WritePos(), &stream[received], recvSize);
+			recvBuffer.OnWrite(recvSize);
+			received += recvSize;
+			arrived -= recvSize;
+
+			int processLen = 0;
+			int pendingSize = 0;
+			const int dataSize = recvBuffer.DataSize();
+			while (dataSize - processLen >= static_cast<int>(sizeof(PacketHeader)))
+			{
+				const int packetSize = reinterpret_cast<PacketHeader*>(recvBuffer.ReadPos() + processLen)->size;
+				if (dataSize - processLen < packetSize)
+				{
+					pendingSize = packetSize;
+					break;
+				}
+				processLen += packetSize;
+				packetCount++;
+			}
+			recvBuffer.OnRead(processLen);
+
+			const int remain = recvBuffer.DataSize();
+			const BYTE* readPos = recvBuffer.ReadPos();
+			recvBuffer.Clean();
+			recvBuffer.Reserve(max<int>(pendingSize, sizeof(PacketHeader)));
+			if (remain > 0 && recvBuffer.ReadPos() != readPos)
+			{
+				movedBytes += remain;
+			}
+		}
+		return packetCount;
+	}
+
+	template <typename Buffer>
+	void Measure(const string& stream, const vector<int>& recvSizes, OUT double& mbPerSecond, OUT double& movedPerMb)
+	{
+		double bestSeconds = 1e9;
+		long long movedBytes = 0;
+		for (int round = 0; round < ROUNDS; round++)
+		{
+			Buffer recvBuffer;
+			movedBytes = 0;
+			const auto begin = chrono::steady_clock::now();
+			KeepAlive(Receive(recvBuffer, stream, recvSizes, OUT movedBytes));
+			const auto end = chrono::steady_clock::now();
+			bestSeconds = min(bestSeconds, chrono::duration<double>(end - begin).count());
+		}
+
+		const double mb = static_cast<double>(stream.size()) / (1 << 20);
+		mbPerSecond = mb / bestSeconds;
+		movedPerMb = movedBytes / mb;
+	}
+
+	void Run(const char* name, int minSize, int maxSize)
+	{
+		string stream;
+		vector<int> recvSizes;
+		MakeStream(minSize, maxSize, OUT stream, OUT recvSizes);
+
+		double oldRate = 0, oldMoved = 0, newRate = 0, newMoved = 0;
+		Measure<OldRecvBuffer>(stream, recvSizes, OUT oldRate, OUT oldMoved);
+		Measure<RecvBuffer>(stream, recvSizes, OUT newRate, OUT newMoved);
+		printf("%-22s %10.0f %10.0f %14.0f %14.0f\n", name, oldRate, newRate, oldMoved, newMoved);
+	}
+}
+
+
+int main()
+{
+	printf("%-22s %10s %10s %14s %14s\n", "packets", "old MB/s", "new MB/s", "old moved/MB", "new moved/MB");
+	Run("chat 32B-512B", 32, 512);
+	Run("mixed 32B-8KB", 32, 0x2000);
+	Run("large 4KB-60KB", 0x1000, 0xF000);
+
+	printf("\nreceive and frame only, no packet handling. mirrored slabs mapped: %d\n", GRecvBufferPool->MirroredCount());
+	return 0;
+}
@@ -0,0 +1,84 @@
+﻿#include "pch.h"
+#include "Session.h"
+#include "RecvBuffer.h"
+#include "BenchmarkUtils.h"
+#include <fstream>
+
+/*
+ * 유휴 연결 메모리 벤치마크 [user-009]
+ * 연결마다 상주하는 메모리(RSS)를 잽니다. 같은 수의 객체를 만들기 전후의 RSS 차이를 객체 수로 나눕니다.
+ *  - 이전 방식 : 세션마다 BUFFER_SIZE(0x10000) * BUFFER_COUNT(10) 크기의 vector<BYTE> 수신 버퍼
+ *  - Session 객체 : Listener가 미리 만들어 두는 세션, 수신 버퍼를 빌리지 않음
+ *  - 연결된 유휴 세션 : 첫 수신을 요청하며 가장 작은 슬랩을 빌리고 데이터가 한번 쓰인 상태
+ *  - 0 바이트 수신 모드의 유휴 세션은 슬랩을 반납하므로 Session 객체와 같음
+ */
+
+namespace
+{
+	enum
+	{
+		CONNECTION_COUNT = 5000, // 세션마다 소켓을 하나씩 만들므로 열 수 있는 파일 수보다 작게
+		OLD_BUFFER_SIZE = 0x10000 * 10,
+	};
+
+	/** \brief 현재 프로세스의 상주 메모리 크기를 반환하는 함수 \return 바이트 */
+	long long ResidentBytes()
+	{
+		long long sizePages = 0;
+		long long residentPages = 0;
+		ifstream statm("/proc/self/statm");
+		statm >> sizePages >> residentPages;
+		return residentPages * sysconf(_SC_PAGESIZE);
+	}
+
+	/**
+	 * \brief 객체를 CONNECTION_COUNT개 만들어 하나당 늘어난 상주 메모리를 출력하는 함수
+	 * \param make 객체 하나를 만들어 반환하는 함수
+	 */
+	template <typename Make>
+	void Run(const char* name, Make make)
+	{
+		using Object = decltype(make());
+		vector<Object> objects;
+		objects.reserve(CONNECTION_COUNT);
+
+		const long long before = ResidentBytes();
+		for (int i = 0; i < CONNECTION_COUNT; i++)
+		{
+			objects.push_back(make());
+		}
+		const long long after = ResidentBytes();
+
+		KeepAlive(objects);
+		printf("%-32s %12.0f\n", name, static_cast<double>(after - before) / CONNECTION_COUNT);
+	}
+}
+
+
+int main()
+{
+	printf("%-32s %12s\n", "connection", "bytes/conn");
+
+	Run("old: vector recv buffer", []()
+	{
+		return make_unique<vector<BYTE>>(OLD_BUFFER_SIZE);
+	});
+
+	Run("Session (pre-created, idle)", []()
+	{
+		return make_shared<Session>();
+	});
+
+	Run("RecvBuffer after first recv", []()
+	{
+		auto recvBuffer = make_unique<RecvBuffer>();
+		recvBuffer->Reserve(sizeof(PacketHeader));
+		recvBuffer->WritePos()[0] = 1;
+		recvBuffer->OnWrite(1);
+		return recvBuffer;
+	});
+
+	printf("\nconnected idle session = Session + RecvBuffer after first recv, or Session alone with zero-byte recv\n");
+	printf("smallest slab: %d bytes\n", GRecvBufferPool->SlabSize(0));
+	return 0;
+}
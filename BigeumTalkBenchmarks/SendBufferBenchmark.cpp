@@ -0,0 +1,203 @@
+﻿#include "pch.h"
+#include "SendBuffer.h"
+#include "BenchmarkUtils.h"
+#include <new>
+
+/*
+ * SendBuffer 청크 풀 벤치마크 [user-015]
+ * 여러 쓰레드가 동시에 GSendBufferManager->Open으로 패킷 크기의 버퍼를 받고 놓을 때의 처리량을 잽니다.
+ * 비교를 위해 이전 방식(mutex로 보호한 전역 vector, 반납마다 shared_ptr을 새로 만드는 삭제자, 버퍼마다 make_shared)을
+ * 이 파일 안에 그대로 옮겨 같은 부하로 잽니다.
+ * 각 쓰레드는 송신 중인 패킷처럼 최근 버퍼 WINDOW개를 들고 있다가 가장 오래된 것부터 놓습니다.
+ */
+
+namespace
+{
+	enum
+	{
+		OPEN_COUNT = 1 << 20, // 쓰레드마다 받을 버퍼 수
+		WINDOW = 64, // 쓰레드가 동시에 들고 있는 버퍼 수
+	};
+
+	atomic<long long> GAllocCount = 0; // operator new 호출 수
+}
+
+void* operator new(size_t size)
+{
+	GAllocCount.fetch_add(1, memory_order_relaxed);
+	if (void* p = malloc(size))
+	{
+		return p;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace
+{
+	/* 이전 방식 */
+	struct OldChunk : enable_shared_from_this<OldChunk>
+	{
+		OldChunk() { buffer.resize(0x2000); }
+
+		vector<BYTE> buffer;
+		unsigned int usedSize = 0;
+	};
+
+	struct OldSendBuffer
+	{
+		OldSendBuffer(shared_ptr<OldChunk> owner, BYTE* buffer, unsigned int allocSize) : owner(move(owner)), buffer(buffer), allocSize(allocSize)
+		{
+		}
+
+		shared_ptr<OldChunk> owner;
+		BYTE* buffer;
+		unsigned int allocSize;
+	};
+
+	class OldSendBufferManager
+	{
+	public:
+		shared_ptr<OldChunk> Pop()
+		{
+			lock_guard<mutex> guard(_mutex);
+			if (_chunks.empty() == false)
+			{
+				shared_ptr<OldChunk> chunk = _chunks.back();
+				_chunks.pop_back();
+				return chunk;
+			}
+			return shared_ptr<OldChunk>(new OldChunk, PushGlobal);
+		}
+
+		void Push(shared_ptr<OldChunk> chunk)
+		{
+			lock_guard<mutex> guard(_mutex);
+			_chunks.push_back(chunk);
+		}
+
+		static void PushGlobal(OldChunk* chunk);
+
+	private:
+		mutex _mutex;
+		vector<shared_ptr<OldChunk>> _chunks;
+	};
+
+	OldSendBufferManager* GOldSendBufferManager = new OldSendBufferManager(); // 쓰레드 종료 후에도 반납받도록 해제하지 않음
+	thread_local shared_ptr<OldChunk> LOldChunk;
+
+	void OldSendBufferManager::PushGlobal(OldChunk* chunk)
+	{
+		GOldSendBufferManager->Push(shared_ptr<OldChunk>(chunk, PushGlobal));
+	}
+
+	shared_ptr<OldSendBuffer> OldOpen(unsigned int size)
+	{
+		if (LOldChunk == nullptr || LOldChunk->buffer.size() - LOldChunk->usedSize < size)
+		{
+			LOldChunk = GOldSendBufferManager->Pop();
+			LOldChunk->usedSize = 0;
+		}
+
+		auto sendBuffer = make_shared<OldSendBuffer>(LOldChunk->shared_from_this(), &LOldChunk->buffer[LOldChunk->usedSize], size);
+		LOldChunk->usedSize += size;
+		return sendBuffer;
+	}
+
+	/* 현재 방식 */
+	SendBufferRef NewOpen(unsigned int size)
+	{
+		SendBufferRef sendBuffer = GSendBufferManager->Open(size);
+		sendBuffer->Close(size);
+		return sendBuffer;
+	}
+
+	/**
+	 * \brief 쓰레드마다 버퍼를 받고 놓는 부하를 실행하는 함수
+	 * \param threadCount 동시에 실행할 쓰레드 수
+	 * \param open 버퍼를 받는 함수
+	 * \return 초당 받은 버퍼 수 (백만)
+	 */
+	template <typename Open>
+	double Run(int threadCount, Open open)
+	{
+		atomic<int> ready = 0;
+		atomic<bool> start = false;
+		vector<thread> threads;
+		for (int t = 0; t < threadCount; t++)
+		{
+			threads.emplace_back([&, t]()
+			{
+				using Buffer = decltype(open(0u));
+				vector<Buffer> window(WINDOW);
+				unsigned int size = 64 + t * 8;
+
+				ready.fetch_add(1);
+				while (start.load() == false)
+				{
+					this_thread::yield();
+				}
+
+				for (int i = 0; i < OPEN_COUNT; i++)
+				{
+					// 채팅 패킷 크기인 64 ~ 512 바이트를 돌아가며 받음
+					size = 64 + (size * 7 + 13) % 449;
+					window[i % WINDOW] = open(size);
+				}
+			});
+		}
+
+		while (ready.load() != threadCount)
+		{
+			this_thread::yield();
+		}
+
+		const auto begin = chrono::steady_clock::now();
+		start.store(true);
+		for (thread& t : threads)
+		{
+			t.join();
+		}
+		const auto end = chrono::steady_clock::now();
+
+		const double seconds = chrono::duration<double>(end - begin).count();
+		return static_cast<double>(OPEN_COUNT) * threadCount / seconds / 1e6;
+	}
+
+	/**
+	 * \brief 한 쓰레드에서 버퍼 하나를 받을 때 operator new가 불리는 평균 횟수를 재는 함수
+	 */
+	template <typename Open>
+	double AllocsPerOpen(Open open)
+	{
+		Run(1, open); // 풀을 데움
+		const long long before = GAllocCount.load();
+		Run(1, open);
+		return static_cast<double>(GAllocCount.load() - before - 2) / OPEN_COUNT; // 쓰레드 생성, window 할당 제외
+	}
+}
+
+
+int main()
+{
+	printf("%-8s %12s %12s\n", "threads", "old Mops/s", "new Mops/s");
+	for (int threadCount : {1, 2, 4, 8, 16})
+	{
+		const double oldRate = Run(threadCount, &OldOpen);
+		const double newRate = Run(threadCount, &NewOpen);
+		printf("%-8d %12.2f %12.2f\n", threadCount, oldRate, newRate);
+	}
+
+	printf("\nheap allocations per Open: old %.3f, new %.4f\n", AllocsPerOpen(&OldOpen), AllocsPerOpen(&NewOpen));
+	printf("hardware threads: %u\n", thread::hardware_concurrency());
+	return 0;
+}
@@ -0,0 +1,252 @@
+﻿#include "pch.h"
+#include "SendBuffer.h"
+#include "SendQueue.h"
+#include "BenchmarkUtils.h"
+#include <queue>
+#include <new>
+
+/*
+ * 송신 큐 경합 벤치마크 [user-006]
+ * 여러 생산자 쓰레드가 한 세션에 동시에 Send할 때의 처리량을 잽니다. 방 하나에 여러 쓰레드가 Broadcast하는 상황입니다.
+ * 두 큐 모두 Session과 같은 _sendRegistered 넘겨주기를 따릅니다.
+ *  - Push한 쓰레드가 송신 중 표시를 얻으면 그 쓰레드가 한번에 SEND_BATCH개까지 꺼내고, 큐가 비면 표시를 놓음
+ *  - 이전 방식 : Session::_mutex로 보호한 queue, Push와 꺼내기 모두 lock
+ *  - 현재 방식 : SendQueue (lock-free MPSC), 표시를 놓을 때 ReleaseSendRegistered와 같이 다시 확인
+ * 잰 구간에서 Send 하나에 operator new가 불린 평균 횟수도 함께 출력합니다. 노드 풀이 채워진 뒤 SendQueue는 0이어야 합니다.
+ * 소켓 송신은 하지 않으므로 큐와 넘겨주기 비용만 잽니다.
+ * 세션의 송신 적체 제한처럼 큐에 MAX_PENDING개가 쌓여 있으면 생산자는 양보하고 기다립니다. 버리지는 않습니다.
+ */
+
+namespace
+{
+	enum
+	{
+		SEND_COUNT = 1 << 19, // 생산자마다 보낼 패킷 수
+		SEND_BATCH = 64, // 한번의 송신에 꺼낼 최대 패킷 수 (SendEvent의 버퍼 수)
+		MAX_PENDING = 0x1000, // 큐에 쌓일 수 있는 최대 패킷 수 (SessionConfig::DEFAULT_PENDING_COUNT)
+	};
+
+	atomic<long long> GAllocCount = 0; // operator new 호출 수
+}
+
+void* operator new(size_t size)
+{
+	GAllocCount.fetch_add(1, memory_order_relaxed);
+	if (void* p = malloc(size))
+	{
+		return p;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace
+{
+
+	/**
+	 * \brief 이전 방식의 세션 송신 부분
+	 */
+	class MutexSession
+	{
+	public:
+		void Send(const SendBufferRef& sendBuffer)
+		{
+			bool registerSend = false;
+			{
+				lock_guard<mutex> lock(_mutex);
+				_sendQueue.push(sendBuffer);
+				_pending.fetch_add(1, memory_order_relaxed);
+				registerSend = _sendRegistered.exchange(true) == false;
+			}
+
+			if (registerSend)
+			{
+				RegisterSend();
+			}
+		}
+
+		long long SentCount() { return _sentCount; }
+		int Pending() { return _pending.load(memory_order_relaxed); }
+
+	private:
+		void RegisterSend()
+		{
+			while (true)
+			{
+				SendBufferRef batch[SEND_BATCH];
+				int count = 0;
+				{
+					lock_guard<mutex> lock(_mutex);
+					while (count < SEND_BATCH && _sendQueue.empty() == false)
+					{
+						batch[count++] = move(_sendQueue.front());
+						_sendQueue.pop();
+					}
+
+					if (count == 0)
+					{
+						_sendRegistered.store(false);
+						return;
+					}
+				}
+				_pending.fetch_sub(count, memory_order_relaxed);
+				_sentCount += count;
+			}
+		}
+
+	private:
+		mutex _mutex;
+		queue<SendBufferRef> _sendQueue;
+		atomic<bool> _sendRegistered = false;
+		atomic<int> _pending = 0; // 큐에 쌓인 패킷 수
+		long long _sentCount = 0; // 송신 중 표시를 가진 쓰레드만 변경
+	};
+
+	/**
+	 * \brief 현재 방식의 세션 송신 부분
+	 */
+	class LockFreeSession
+	{
+	public:
+		void Send(const SendBufferRef& sendBuffer)
+		{
+			_sendQueue.Push(sendBuffer);
+			_pending.fetch_add(1, memory_order_relaxed);
+			if (_sendRegistered.exchange(true) == false)
+			{
+				RegisterSend();
+			}
+		}
+
+		long long SentCount() { return _sentCount; }
+		int Pending() { return _pending.load(memory_order_relaxed); }
+
+	private:
+		void RegisterSend()
+		{
+			while (true)
+			{
+				SendBufferRef batch[SEND_BATCH];
+				int count = 0;
+				while (count < SEND_BATCH)
+				{
+					batch[count] = _sendQueue.Pop();
+					if (batch[count] == nullptr)
+					{
+						break;
+					}
+					count++;
+				}
+
+				if (count > 0)
+				{
+					_pending.fetch_sub(count, memory_order_relaxed);
+					_sentCount += count;
+					continue;
+				}
+
+				_sendRegistered.exchange(false);
+				if (_sendQueue.Empty() || _sendRegistered.exchange(true))
+				{
+					return;
+				}
+			}
+		}
+
+	private:
+		SendQueue _sendQueue;
+		atomic<bool> _sendRegistered = false;
+		atomic<int> _pending = 0; // 큐에 쌓인 패킷 수
+		long long _sentCount = 0; // 송신 중 표시를 가진 쓰레드만 변경
+	};
+
+	/**
+	 * \brief 생산자 쓰레드들이 한 세션에 동시에 Send하는 함수
+	 * \param producerCount 생산자 쓰레드 수
+	 * \param allocsPerSend Send 하나에 operator new가 불린 평균 횟수를 받을 변수
+	 * \return 초당 Send 수 (백만)
+	 */
+	template <typename SessionType>
+	double Run(int producerCount, double& allocsPerSend)
+	{
+		SessionType session;
+		atomic<int> ready = 0;
+		atomic<bool> start = false;
+		vector<thread> threads;
+		for (int t = 0; t < producerCount; t++)
+		{
+			threads.emplace_back([&]()
+			{
+				// Broadcast처럼 같은 버퍼를 여러번 보냄
+				SendBufferRef sendBuffer = GSendBufferManager->Open(64);
+				sendBuffer->Close(64);
+
+				ready.fetch_add(1);
+				while (start.load() == false)
+				{
+					this_thread::yield();
+				}
+
+				for (int i = 0; i < SEND_COUNT; i++)
+				{
+					while (session.Pending() >= MAX_PENDING)
+					{
+						this_thread::yield();
+					}
+					session.Send(sendBuffer);
+				}
+			});
+		}
+
+		while (ready.load() != producerCount)
+		{
+			this_thread::yield();
+		}
+
+		const long long allocBefore = GAllocCount.load();
+		const auto begin = chrono::steady_clock::now();
+		start.store(true);
+		for (thread& t : threads)
+		{
+			t.join();
+		}
+		const auto end = chrono::steady_clock::now();
+		allocsPerSend = static_cast<double>(GAllocCount.load() - allocBefore) / SEND_COUNT / producerCount;
+
+		// 마지막 Send한 쓰레드가 비울 때까지 송신하므로 모두 꺼내져 있어야 함
+		if (session.SentCount() != static_cast<long long>(SEND_COUNT) * producerCount)
+		{
+			printf("lost packets: sent %lld of %lld\n", session.SentCount(), static_cast<long long>(SEND_COUNT) * producerCount);
+			exit(1);
+		}
+
+		const double seconds = chrono::duration<double>(end - begin).count();
+		return static_cast<double>(SEND_COUNT) * producerCount / seconds / 1e6;
+	}
+}
+
+
+int main()
+{
+	printf("%-10s %14s %14s %14s %14s\n", "producers", "mutex Msend/s", "mpsc Msend/s", "mutex new/send", "mpsc new/send");
+	for (int producerCount : {1, 2, 4, 8, 16})
+	{
+		double mutexAllocs = 0;
+		double lockFreeAllocs = 0;
+		const double mutexRate = Run<MutexSession>(producerCount, mutexAllocs);
+		const double lockFreeRate = Run<LockFreeSession>(producerCount, lockFreeAllocs);
+		printf("%-10d %14.2f %14.2f %14.4f %14.4f\n", producerCount, mutexRate, lockFreeRate, mutexAllocs, lockFreeAllocs);
+	}
+
+	printf("\nhardware threads: %u\n", thread::hardware_concurrency());
+	return 0;
+}
@@ -1,21 +1,47 @@
 ﻿#include "pch.h"
 #include "Service.h"
+#include "PacketHandler.h"
 
 using namespace std;
 
 int main()
 {
-	auto service = make_shared<Service>(make_shared<Iocp>(), L"0.0.0.0", 3000);
+	// 코어마다 Iocp 샤드 하나와 고정된 워커 스레드 하나
+	const unsigned int shardCount = max(thread::hardware_concurrency(), 1u);
+	const unsigned int TICK_MS = 1000;
+
+	vector<shared_ptr<Iocp>> iocps;
+	for (unsigned int i = 0; i < shardCount; i++)
+	{
+		iocps.push_back(make_shared<Iocp>(Iocp::MAX_BATCH_SIZE));
+	}
+
+	auto service = make_shared<Service>(iocps, L"0.0.0.0", 3000);
+
+	// 대부분 유휴 상태인 채팅 연결은 데이터가 도착했을 때만 수신 버퍼를 빌림
+	SessionConfig sessionConfig;
+	sessionConfig.zeroByteRecv = true;
+
+	// 느린 클라이언트에게 쌓인 송신이 1MB 또는 4096개를 넘으면 오래된 채팅부터 버림
+	sessionConfig.sendPolicy = SendPolicy::DropOldestChat;
+	sessionConfig.maxPendingBytes = 0x100000;
+	sessionConfig.maxPendingCount = 0x1000;
+	service->SetSessionConfig(sessionConfig);
+
 	ASSERT_CRASH(service->Start());
 
 	vector<thread> threads;
-	for (unsigned int i = 0; i < thread::hardware_concurrency(); i++)
+	for (unsigned int i = 0; i < shardCount; i++)
 	{
 		threads.push_back(thread([=]()
 		{
+			PinCurrentThread(i);
 			while (true)
 			{
-				service->GetIocp()->Dispatch();
+				// 완료 패킷이 없어도 주기적으로 깨어나 샤드의 정기 작업 수행
+				service->GetIocp(i)->Dispatch(TICK_MS);
+				PacketHandler::ResetArena(); // 완료 패킷 묶음에서 파싱한 패킷 해제
+				service->Tick(i);
 			}
 		}));
 	}
@@ -0,0 +1,499 @@
+﻿#include "pch.h"
+#include "Iocp.h"
+
+#if !defined(_WIN32) && !defined(USE_IO_URING)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+Iocp::Iocp(unsigned int batchSize)
+	: _batchSize(clamp<unsigned int>(batchSize, 1, MAX_BATCH_SIZE))
+{
+	// epoll 생성
+	_iocpHandle = epoll_create1(EPOLL_CLOEXEC);
+	ASSERT_CRASH(_iocpHandle != -1);
+
+	// 완료 큐 알림용 eventfd 등록
+	_wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	ASSERT_CRASH(_wakeupFd != -1);
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = _wakeupFd;
+	ASSERT_CRASH(epoll_ctl(_iocpHandle, EPOLL_CTL_ADD, _wakeupFd, &event) == 0);
+}
+
+Iocp::~Iocp()
+{
+	close(_wakeupFd);
+	close(_iocpHandle);
+}
+
+
+/**
+ * \brief 소켓을 epoll에 연결
+ * \param iocpObject epoll에 연결할 iocpObject(Session, Listener)
+ * \return 연결 성공 여부
+ */
+bool Iocp::Register(shared_ptr<IocpObject> iocpObject)
+{
+	SOCKET socket = iocpObject->GetHandle();
+	iocpObject->_iocp = this;
+
+	{
+		// 소켓 번호는 재사용되므로 이전 객체의 항목은 덮어씀
+		unique_lock lock(_objectsMutex);
+		_objects[socket] = iocpObject;
+	}
+
+	return Watch(socket);
+}
+
+
+/**
+ * \brief 객체를 epoll에서 분리하는 함수
+ * \details 소켓은 닫히거나 교체될 때 epoll에서 빠지므로 알림 대상 항목과 대기열만 정리합니다.
+ * \param iocpObject 분리할 객체. 완료되지 않은 비동기 IO가 없어야 합니다.
+ */
+void Iocp::Unregister(IocpObject* iocpObject)
+{
+	{
+		// 같은 소켓 번호로 이미 다른 객체가 등록되었다면 그대로 둠
+		unique_lock lock(_objectsMutex);
+		auto it = _objects.find(iocpObject->GetHandle());
+		if (it != _objects.end() && it->second.expired())
+		{
+			_objects.erase(it);
+		}
+	}
+
+	lock_guard lock(iocpObject->_ioMutex);
+	iocpObject->_pendingReads.clear();
+	iocpObject->_pendingWrites.clear();
+}
+
+
+/**
+ * \brief epoll 완료 패킷 처리 함수
+ * \details 요청 즉시 완료된 이벤트를 먼저 처리하고, 없다면 준비 알림을 최대 _batchSize개 받아 대기중인 IO 작업을 수행합니다.
+ * \param timeoutMs epoll_wait이 Block될 시간. 기본값은 INFINITE
+ * \return 완료 패킷 처리 성공 여부
+ */
+bool Iocp::Dispatch(unsigned timeoutMs)
+{
+	IocpEvent* iocpEvents[MAX_BATCH_SIZE];
+	unsigned int count = PopCompletions(OUT iocpEvents, _batchSize);
+	if (count > 0)
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			IocpObject* iocpObject = iocpEvents[i]->_owner;
+			iocpObject->Dispatch(iocpEvents[i], iocpEvents[i]->_numOfBytes);
+			iocpObject->ReleaseRef();
+		}
+
+		RecordBatch(count);
+		return true;
+	}
+
+	epoll_event events[MAX_BATCH_SIZE];
+	const int timeout = timeoutMs == INFINITE ? -1 : static_cast<int>(timeoutMs);
+	const int numOfEvents = epoll_wait(_iocpHandle, OUT events, static_cast<int>(_batchSize), timeout);
+	if (numOfEvents <= 0)
+	{
+		// 타임아웃 또는 시그널 인터럽트
+		return false;
+	}
+
+	for (int i = 0; i < numOfEvents; i++)
+	{
+		const epoll_event& event = events[i];
+		if (event.data.fd == _wakeupFd)
+		{
+			// 완료 큐 알림, 카운터를 비우고 큐에서 알림 하나 자리와 남는 배치 크기만큼 처리
+			uint64_t value = 0;
+			if (read(_wakeupFd, OUT &value, sizeof(value)) < 0)
+			{
+				// 다른 스레드가 먼저 비움
+			}
+
+			const unsigned int popped = PopCompletions(OUT iocpEvents, _batchSize - numOfEvents + 1);
+			for (unsigned int j = 0; j < popped; j++)
+			{
+				IocpObject* iocpObject = iocpEvents[j]->_owner;
+				iocpObject->Dispatch(iocpEvents[j], iocpEvents[j]->_numOfBytes);
+				iocpObject->ReleaseRef();
+			}
+			count += popped;
+			continue;
+		}
+
+		shared_ptr<IocpObject> iocpObject;
+		{
+			shared_lock lock(_objectsMutex);
+			auto it = _objects.find(event.data.fd);
+			if (it != _objects.end())
+			{
+				iocpObject = it->second.lock();
+			}
+		}
+
+		if (iocpObject == nullptr)
+		{
+			// 이미 소멸된 객체의 늦은 알림
+			continue;
+		}
+
+		if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+		{
+			iocpObject->_readSeq.fetch_add(1);
+			Progress(iocpObject.get(), iocpObject->_pendingReads, iocpObject->_readSeq, true);
+		}
+
+		if (event.events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+		{
+			iocpObject->_writeSeq.fetch_add(1);
+			Progress(iocpObject.get(), iocpObject->_pendingWrites, iocpObject->_writeSeq, true);
+		}
+		count++;
+	}
+
+	RecordBatch(count);
+	return true;
+}
+
+
+/**
+ * \brief 비동기 IO 작업 요청 함수
+ * \details 작업을 대기열에 넣고 바로 수행을 시도합니다. 즉시 완료된 작업은 완료 큐를 통해 Dispatch 됩니다.
+ * \param iocpEvent 작업 정보가 담긴 이벤트. _owner가 Register된 객체여야 합니다.
+ * \return 작업 요청 성공 여부
+ */
+bool Iocp::Post(IocpEvent* iocpEvent)
+{
+	// 요청한 쪽이 객체의 참조를 가지고 있으므로 요청 도중 다른 스레드에서 완료되어도 객체가 유지됨
+	IocpObject* iocpObject = iocpEvent->_owner;
+	Iocp* iocp = iocpObject->_iocp;
+	if (iocp == nullptr)
+	{
+		errno = EBADF;
+		return false;
+	}
+
+	switch (iocpEvent->GetEventType())
+	{
+	case EventType::Accept:
+	case EventType::Recv:
+		{
+			lock_guard lock(iocpObject->_ioMutex);
+			iocpObject->_pendingReads.push_back(iocpEvent);
+		}
+		iocp->Progress(iocpObject, iocpObject->_pendingReads, iocpObject->_readSeq, false);
+		break;
+	case EventType::Send:
+		{
+			lock_guard lock(iocpObject->_ioMutex);
+			iocpObject->_pendingWrites.push_back(iocpEvent);
+		}
+		iocp->Progress(iocpObject, iocpObject->_pendingWrites, iocpObject->_writeSeq, false);
+		break;
+	case EventType::Disconnect:
+		// 이미 끊긴 소켓이어도 ProcessDisconnect가 호출되도록 항상 완료 처리
+		// 대기중인 Recv/Send는 shutdown 알림을 받아 0 바이트로 완료됨
+		shutdown(iocpEvent->_socket, SHUT_RDWR);
+		iocp->PostCompletion(iocpEvent);
+		break;
+	default:
+		errno = EINVAL;
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief 대기중인 Accept/Recv 작업을 취소하는 함수
+ * \details CancelIoEx처럼 아직 수행되지 않은 작업을 대기열에서 빼고 ECANCELED 실패로 완료합니다.
+ * \param iocpEvent 취소할 이벤트. 요청한 객체의 샤드 스레드에서 호출해야 합니다.
+ * \return 취소 여부. 이미 수행되었거나 완료되었다면 false
+ */
+bool Iocp::Cancel(IocpEvent* iocpEvent)
+{
+	IocpObject* iocpObject = iocpEvent->_owner;
+	Iocp* iocp = iocpObject->_iocp;
+	if (iocp == nullptr)
+	{
+		return false;
+	}
+
+	{
+		lock_guard lock(iocpObject->_ioMutex);
+		auto it = find(iocpObject->_pendingReads.begin(), iocpObject->_pendingReads.end(), iocpEvent);
+		if (it == iocpObject->_pendingReads.end())
+		{
+			return false;
+		}
+		iocpObject->_pendingReads.erase(it);
+	}
+
+	iocpEvent->_errorCode = ECANCELED;
+	iocpEvent->_numOfBytes = 0;
+	iocp->PostCompletion(iocpEvent);
+
+	return true;
+}
+
+
+/**
+ * \brief 소켓을 edge-triggered 방식으로 epoll에 추가하는 함수
+ * \param socket 추가할 소켓
+ * \return 추가 성공 여부
+ */
+bool Iocp::Watch(SOCKET socket)
+{
+	epoll_event event = {};
+	event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	event.data.fd = socket;
+	return epoll_ctl(_iocpHandle, EPOLL_CTL_ADD, socket, &event) == 0;
+}
+
+
+/**
+ * \brief 대기중인 IO 작업을 준비되지 않을 때 까지 수행하는 함수
+ * \details 작업 수행 도중 들어온 준비 알림을 놓치지 않도록 seq를 비교해 다시 시도합니다.
+ * \param iocpObject 작업을 요청한 객체
+ * \param pendings 읽기 또는 쓰기 대기열
+ * \param seq 대기열에 해당하는 준비 알림 횟수
+ * \param inlineDispatch 완료된 작업을 바로 Dispatch 할지 여부. false면 완료 큐에 넣음
+ */
+void Iocp::Progress(IocpObject* iocpObject, deque<IocpEvent*>& pendings, atomic<unsigned int>& seq,
+                    bool inlineDispatch)
+{
+	while (true)
+	{
+		const unsigned int readySeq = seq.load();
+
+		IocpEvent* iocpEvent = nullptr;
+		{
+			lock_guard lock(iocpObject->_ioMutex);
+			if (pendings.empty())
+			{
+				return;
+			}
+
+			iocpEvent = pendings.front();
+			pendings.pop_front();
+		}
+
+		if (Execute(iocpEvent))
+		{
+			Complete(iocpEvent, inlineDispatch);
+			continue;
+		}
+
+		// 아직 준비되지 않음, 대기열에 되돌림
+		{
+			lock_guard lock(iocpObject->_ioMutex);
+			pendings.push_front(iocpEvent);
+		}
+
+		if (seq.load() == readySeq)
+		{
+			return;
+		}
+	}
+}
+
+
+/**
+ * \brief 이벤트에 담긴 IO 작업을 수행하는 함수
+ * \param iocpEvent 수행할 작업의 이벤트
+ * \return 작업 완료 여부. 소켓이 준비되지 않았다면 false
+ */
+bool Iocp::Execute(IocpEvent* iocpEvent)
+{
+	while (true)
+	{
+		switch (iocpEvent->GetEventType())
+		{
+		case EventType::Accept:
+			{
+				SOCKET socket = accept4(iocpEvent->_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+				if (socket == INVALID_SOCKET)
+				{
+					break;
+				}
+
+				// AcceptEx처럼 미리 생성한 세션 소켓 자리에 연결된 소켓을 옮기고 다시 epoll에 추가
+				if (dup2(socket, iocpEvent->_acceptSocket) == SOCKET_ERROR || Watch(iocpEvent->_acceptSocket) == false)
+				{
+					iocpEvent->_errorCode = errno;
+				}
+				closesocket(socket);
+				return true;
+			}
+		case EventType::Recv:
+			{
+				// 0 바이트 수신은 읽을 데이터가 있거나 연결이 끊길 때까지 대기만 하고 데이터는 소켓에 남김
+				if (all_of(iocpEvent->_iovs.begin(), iocpEvent->_iovs.end(), [](const iovec& iov) { return iov.iov_len == 0; }))
+				{
+					BYTE peek;
+					if (recv(iocpEvent->_socket, &peek, 1, MSG_PEEK) < 0)
+					{
+						break;
+					}
+
+					iocpEvent->_numOfBytes = 0;
+					return true;
+				}
+
+				ssize_t numOfBytes = readv(iocpEvent->_socket, iocpEvent->_iovs.data(),
+				                           static_cast<int>(iocpEvent->_iovs.size()));
+				if (numOfBytes < 0)
+				{
+					break;
+				}
+
+				iocpEvent->_numOfBytes = static_cast<int>(numOfBytes);
+				return true;
+			}
+		case EventType::Send:
+			{
+				// Scatter-Gather IO, 부분 송신이면 보낸 만큼 버퍼를 소모하고 계속 송신 (한번에 최대 IOV_MAX개)
+				ssize_t numOfBytes = writev(iocpEvent->_socket, iocpEvent->_iovs.data(),
+				                            static_cast<int>(min<size_t>(iocpEvent->_iovs.size(), IOV_MAX)));
+				if (numOfBytes < 0)
+				{
+					break;
+				}
+
+				iocpEvent->_numOfBytes += static_cast<int>(numOfBytes);
+
+				auto iov = iocpEvent->_iovs.begin();
+				while (iov != iocpEvent->_iovs.end() && numOfBytes >= static_cast<ssize_t>(iov->iov_len))
+				{
+					numOfBytes -= iov->iov_len;
+					++iov;
+				}
+				iocpEvent->_iovs.erase(iocpEvent->_iovs.begin(), iov);
+
+				if (iocpEvent->_iovs.empty())
+				{
+					return true;
+				}
+
+				iocpEvent->_iovs.front().iov_base = static_cast<BYTE*>(iocpEvent->_iovs.front().iov_base) + numOfBytes;
+				iocpEvent->_iovs.front().iov_len -= numOfBytes;
+				continue;
+			}
+		default:
+			iocpEvent->_errorCode = EINVAL;
+			return true;
+		}
+
+		// 시스템 콜 실패
+		if (errno == EINTR)
+		{
+			continue;
+		}
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+		{
+			return false;
+		}
+
+		iocpEvent->_errorCode = errno;
+		return true;
+	}
+}
+
+
+/**
+ * \brief 완료된 작업을 Dispatch 하는 함수
+ * \param iocpEvent 완료된 이벤트
+ * \param inlineDispatch 바로 Dispatch 할지 여부. false면 완료 큐에 넣음
+ */
+void Iocp::Complete(IocpEvent* iocpEvent, bool inlineDispatch)
+{
+	if (iocpEvent->_errorCode != 0)
+	{
+		// IOCP와 같이 실패한 작업은 0 바이트로 완료
+		iocpEvent->_numOfBytes = 0;
+	}
+
+	if (inlineDispatch == false)
+	{
+		PostCompletion(iocpEvent);
+		return;
+	}
+
+	// 처리 후 이벤트가 가지고 있던 참조 해제
+	IocpObject* iocpObject = iocpEvent->_owner;
+	iocpObject->Dispatch(iocpEvent, iocpEvent->_numOfBytes);
+	iocpObject->ReleaseRef();
+}
+
+
+/**
+ * \brief 완료 큐에 이벤트를 넣는 함수
+ * \param iocpEvent 완료된 이벤트
+ */
+void Iocp::PostCompletion(IocpEvent* iocpEvent)
+{
+	bool wakeup = false;
+	{
+		lock_guard lock(_completionMutex);
+		wakeup = _completions.empty();
+		_completions.push(iocpEvent);
+	}
+
+	if (wakeup)
+	{
+		Wakeup();
+	}
+}
+
+
+/**
+ * \brief 완료 큐에서 이벤트를 꺼내는 함수
+ * \param iocpEvents 꺼낸 이벤트를 담을 배열
+ * \param maxCount 꺼낼 최대 개수
+ * \return 꺼낸 이벤트 수
+ */
+unsigned int Iocp::PopCompletions(IocpEvent** iocpEvents, unsigned int maxCount)
+{
+	unsigned int count = 0;
+	bool remain = false;
+	{
+		lock_guard lock(_completionMutex);
+		while (count < maxCount && _completions.empty() == false)
+		{
+			iocpEvents[count++] = _completions.front();
+			_completions.pop();
+		}
+		remain = _completions.empty() == false;
+	}
+
+	if (remain)
+	{
+		// 남은 이벤트를 처리할 다른 스레드를 깨움
+		Wakeup();
+	}
+
+	return count;
+}
+
+
+/**
+ * \brief epoll_wait에서 대기중인 스레드를 깨우는 함수
+ */
+void Iocp::Wakeup()
+{
+	uint64_t value = 1;
+	if (write(_wakeupFd, &value, sizeof(value)) < 0)
+	{
+		// 카운터가 가득 찬 경우에도 이미 깨어날 스레드가 있음
+	}
+}
+#endif
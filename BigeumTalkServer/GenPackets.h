@@ -0,0 +1,89 @@
+﻿#pragma once
+
+/*
+ * 자동 생성 파일입니다. 직접 수정하지 말고 Protobuf/GenPackets.py를 실행하세요.
+ * Protocol.proto의 PacketId로부터 패킷 처리 함수 선언, 디스패치 테이블 항목, MakeBuffer 함수를 만듭니다.
+ */
+
+class Session;
+
+/* 패킷 처리 함수, PacketHandler.cpp에 정의 */
+bool Handle_C_LOGIN(shared_ptr<Session>& session, Protocol::C_LOGIN& pkt);
+bool Handle_C_CREATE_ROOM(shared_ptr<Session>& session, Protocol::C_CREATE_ROOM& pkt);
+bool Handle_C_ENTER_ROOM(shared_ptr<Session>& session, Protocol::C_ENTER_ROOM& pkt);
+bool Handle_C_LEAVE_ROOM(shared_ptr<Session>& session, Protocol::C_LEAVE_ROOM& pkt);
+bool Handle_C_ROOM_LIST(shared_ptr<Session>& session, Protocol::C_ROOM_LIST& pkt);
+bool Handle_C_CHAT(shared_ptr<Session>& session, C_CHAT_View& pkt);
+
+
+/**
+ * \brief 패킷 처리 함수 목록
+ * \details 프로토콜 ID, 패킷, 처리 함수 항목으로 디스패치 테이블을 만듭니다.
+ * \tparam Entry 항목 템플릿 (PacketHandlerEntry)
+ * \tparam Table 테이블 템플릿 (PacketHandlerTable)
+ */
+template <template <unsigned short, typename, auto> class Entry, template <typename...> class Table>
+using GenPacketHandlerList = Table<
+	Entry<Protocol::PACKET_ID_C_LOGIN, Protocol::C_LOGIN, Handle_C_LOGIN>,
+	Entry<Protocol::PACKET_ID_C_CREATE_ROOM, Protocol::C_CREATE_ROOM, Handle_C_CREATE_ROOM>,
+	Entry<Protocol::PACKET_ID_C_ENTER_ROOM, Protocol::C_ENTER_ROOM, Handle_C_ENTER_ROOM>,
+	Entry<Protocol::PACKET_ID_C_LEAVE_ROOM, Protocol::C_LEAVE_ROOM, Handle_C_LEAVE_ROOM>,
+	Entry<Protocol::PACKET_ID_C_ROOM_LIST, Protocol::C_ROOM_LIST, Handle_C_ROOM_LIST>,
+	Entry<Protocol::PACKET_ID_C_CHAT, C_CHAT_View, Handle_C_CHAT>
+>;
+
+
+/**
+ * \brief 서버 패킷 직렬화 함수 목록
+ * \details PacketHandler가 상속하여 PacketHandler::MakeBuffer_S_로 사용합니다.
+ * \tparam Handler MakeSendBuffer를 가진 클래스 (PacketHandler)
+ */
+template <typename Handler>
+class GenPacketMaker
+{
+public:
+	static SendBufferRef MakeBuffer_S_LOGIN(Protocol::S_LOGIN& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_LOGIN);
+	}
+
+	static SendBufferRef MakeBuffer_S_CREATE_ROOM(Protocol::S_CREATE_ROOM& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_CREATE_ROOM);
+	}
+
+	static SendBufferRef MakeBuffer_S_ENTER_ROOM(Protocol::S_ENTER_ROOM& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_ENTER_ROOM);
+	}
+
+	static SendBufferRef MakeBuffer_S_LEAVE_ROOM(Protocol::S_LEAVE_ROOM& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_LEAVE_ROOM);
+	}
+
+	static SendBufferRef MakeBuffer_S_ROOM_LIST(Protocol::S_ROOM_LIST& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_ROOM_LIST);
+	}
+
+	static SendBufferRef MakeBuffer_S_CHAT(Protocol::S_CHAT& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_CHAT);
+	}
+
+	static SendBufferRef MakeBuffer_S_OTHER_ENTER(Protocol::S_OTHER_ENTER& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_OTHER_ENTER);
+	}
+
+	static SendBufferRef MakeBuffer_S_OTHER_LEAVE(Protocol::S_OTHER_LEAVE& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_OTHER_LEAVE);
+	}
+
+	static SendBufferRef MakeBuffer_S_USER_DICTIONARY(Protocol::S_USER_DICTIONARY& pkt)
+	{
+		return Handler::MakeSendBuffer(pkt, Protocol::PACKET_ID_S_USER_DICTIONARY);
+	}
+};
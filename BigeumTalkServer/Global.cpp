@@ -2,9 +2,15 @@
 #include "Global.h"
 #include "SocketUtils.h"
 #include "SendBuffer.h"
+#include "SendQueue.h"
+#include "RecvBuffer.h"
 #include "Room.h"
+#include "Session.h"
 
 SendBufferManager* GSendBufferManager = nullptr;
+SendNodePool* GSendNodePool = nullptr;
+RecvBufferPool* GRecvBufferPool = nullptr;
+SendMetrics* GSendMetrics = nullptr;
 
 
 /**
@@ -18,10 +24,16 @@ public:
 	{
 		SocketUtils::Init();
 		GSendBufferManager = new SendBufferManager();
+		GSendNodePool = new SendNodePool();
+		GRecvBufferPool = new RecvBufferPool();
+		GSendMetrics = new SendMetrics();
 	}
 
 	~Global()
 	{
 		delete GSendBufferManager;
+		delete GSendNodePool;
+		delete GRecvBufferPool;
+		delete GSendMetrics;
 	}
 } G;
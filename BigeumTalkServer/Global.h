@@ -1,3 +1,6 @@
 ﻿#pragma once
 
 extern class SendBufferManager* GSendBufferManager;
+extern class SendNodePool* GSendNodePool;
+extern class RecvBufferPool* GRecvBufferPool;
+extern struct SendMetrics* GSendMetrics;
@@ -13,14 +13,155 @@ IocpEvent::IocpEvent(EventType type)
  */
 void IocpEvent::Init()
 {
+#ifdef _WIN32
 	hEvent = nullptr;
 	Internal = 0;
 	InternalHigh = 0;
 	Offset = 0;
 	OffsetHigh = 0;
+#else
+	_socket = INVALID_SOCKET;
+	_acceptSocket = INVALID_SOCKET;
+	_iovs.clear();
+	_numOfBytes = 0;
+	_errorCode = 0;
+#endif
 }
 
-Iocp::Iocp()
+
+/**
+ * \brief 송신한 버퍼의 참조를 해제하고 목록을 비우는 함수
+ */
+void SendEvent::Clear()
+{
+	for (unsigned int i = 0; i < _sendBufferCount; i++)
+	{
+		_sendBuffers[i] = nullptr;
+	}
+	_sendBufferCount = 0;
+	_wsaBufCount = 0;
+}
+
+
+IocpObject::~IocpObject()
+{
+	Unregister();
+}
+
+
+/**
+ * \brief 객체를 Iocp에서 분리하는 함수
+ * \details 완료되지 않은 비동기 IO가 없을 때 호출합니다. Linux에서는 완료 에뮬레이션에 남은 상태를 정리합니다.
+ */
+void IocpObject::Unregister()
+{
+#ifndef _WIN32
+	if (_iocp != nullptr)
+	{
+		_iocp->Unregister(this);
+		_iocp = nullptr;
+	}
+#endif
+}
+
+
+/**
+ * \brief 비동기 IO 참조를 늘리는 함수
+ * \details 호출하는 쪽이 shared_ptr 또는 다른 비동기 IO 참조를 가지고 있어야 합니다. 첫 참조일 때만 자기 shared_ptr을 잡습니다.
+ * \details 자기 shared_ptr은 잠그기 전에 만들어 두어 REF_LOCKED 상태에서는 포인터만 옮깁니다.
+ */
+void IocpObject::AddRef()
+{
+	int refCount = _refCount.load();
+	while (true)
+	{
+		if (refCount == REF_LOCKED)
+		{
+			// 다른 스레드가 자기 참조를 교체하는 중
+			this_thread::yield();
+			refCount = _refCount.load();
+			continue;
+		}
+
+		if (refCount == 0)
+		{
+			shared_ptr<IocpObject> self = shared_from_this();
+			if (_refCount.compare_exchange_strong(refCount, REF_LOCKED))
+			{
+				_self = move(self);
+				_refCount.store(1, memory_order_release);
+				return;
+			}
+			continue;
+		}
+
+		if (_refCount.compare_exchange_weak(refCount, refCount + 1))
+		{
+			return;
+		}
+	}
+}
+
+
+/**
+ * \brief 비동기 IO 참조를 줄이는 함수
+ * \details 마지막 참조라면 자기 shared_ptr을 놓으며, 다른 shared_ptr이 없다면 객체가 소멸됩니다. 호출 후 객체를 사용하면 안됩니다.
+ */
+void IocpObject::ReleaseRef()
+{
+	int refCount = _refCount.load();
+	while (true)
+	{
+		ASSERT_CRASH(refCount > 0);
+
+		if (refCount == 1)
+		{
+			if (_refCount.compare_exchange_weak(refCount, REF_LOCKED))
+			{
+				// 객체는 잠금을 푼 뒤 self가 소멸될 때 해제될 수 있음
+				shared_ptr<IocpObject> self = move(_self);
+				_refCount.store(0, memory_order_release);
+				return;
+			}
+			continue;
+		}
+
+		if (_refCount.compare_exchange_weak(refCount, refCount - 1))
+		{
+			return;
+		}
+	}
+}
+
+
+/**
+ * \brief 배치 크기별 Dispatch 횟수를 반환하는 함수
+ * \return 인덱스가 한번에 처리한 완료 패킷 수인 히스토그램
+ */
+vector<unsigned long long> Iocp::GetBatchHistogram()
+{
+	vector<unsigned long long> histogram(_batchSize + 1);
+	for (unsigned int count = 0; count <= _batchSize; count++)
+	{
+		histogram[count] = _batchHistogram[count].load(memory_order_relaxed);
+	}
+
+	return histogram;
+}
+
+
+/**
+ * \brief Dispatch 한번에 처리한 완료 패킷 수를 기록하는 함수
+ * \param count 처리한 완료 패킷 수
+ */
+void Iocp::RecordBatch(unsigned int count)
+{
+	_batchHistogram[count].fetch_add(1, memory_order_relaxed);
+}
+
+#ifdef _WIN32
+Iocp::Iocp(unsigned int batchSize)
+	: _batchSize(clamp<unsigned int>(batchSize, 1, MAX_BATCH_SIZE))
 {
 	// CP 생성
 	_iocpHandle = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 0);
@@ -47,38 +188,36 @@ bool Iocp::Register(shared_ptr<IocpObject> iocpObject)
 
 /**
  * \brief IOCP 완료 패킷 처리 함수
- * \param timeoutMs GetQueuedCompletionStatus이 Block될 시간. 기본값은 INFINITE
+ * \details GetQueuedCompletionStatusEx로 최대 _batchSize개의 완료 패킷을 한번에 꺼내 처리합니다.
+ * \param timeoutMs GetQueuedCompletionStatusEx이 Block될 시간. 기본값은 INFINITE
  * \return 완료 패킷 처리 성공 여부
  */
 bool Iocp::Dispatch(unsigned timeoutMs)
 {
-	DWORD numOfBytes = 0; // 송수신한 데이터의 크기
-	ULONG_PTR key = 0;
-	IocpEvent* iocpEvent = nullptr; // Overlapped
+	OVERLAPPED_ENTRY entries[MAX_BATCH_SIZE];
+	ULONG numOfEntries = 0;
 
 	// CP 완료 패킷 확인
-	if (GetQueuedCompletionStatus(_iocpHandle, OUT &numOfBytes, OUT &key,
-	                              OUT reinterpret_cast<LPOVERLAPPED*>(&iocpEvent), timeoutMs))
+	if (GetQueuedCompletionStatusEx(_iocpHandle, OUT entries, _batchSize, OUT &numOfEntries, timeoutMs,
+	                                FALSE) == false)
 	{
-		// 완료 패킷 처리
-		shared_ptr<IocpObject> iocpObject = iocpEvent->_owner;
-		// _owner에는 비동기 IO를 요청한 객체(Listener, Session)가 있음
-		iocpObject->Dispatch(iocpEvent, numOfBytes);
+		// WAIT_TIMEOUT
+		return false;
 	}
-	else
+
+	for (ULONG i = 0; i < numOfEntries; i++)
 	{
-		int errCode = WSAGetLastError();
-		switch (errCode)
-		{
-		case WAIT_TIMEOUT:
-			return false;
-		default:
-			// TODO: 로그 찍기
-			shared_ptr<IocpObject> iocpObject = iocpEvent->_owner;
-			iocpObject->Dispatch(iocpEvent, numOfBytes);
-			break;
-		}
+		// 실패한 IO도 완료 패킷으로 꺼내지며 송수신 크기로 구분
+		IocpEvent* iocpEvent = reinterpret_cast<IocpEvent*>(entries[i].lpOverlapped);
+		DWORD numOfBytes = entries[i].dwNumberOfBytesTransferred;
+
+		// _owner에는 비동기 IO를 요청한 객체(Listener, Session)가 있음, 처리 후 이벤트의 참조 해제
+		IocpObject* iocpObject = iocpEvent->_owner;
+		iocpObject->Dispatch(iocpEvent, numOfBytes);
+		iocpObject->ReleaseRef();
 	}
 
+	RecordBatch(numOfEntries);
 	return true;
 }
+#endif
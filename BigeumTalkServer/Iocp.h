@@ -3,12 +3,13 @@
 using namespace std;
 
 class Session;
+class Iocp;
 
 
 /**
  * \brief IOCP event 타입 enum 클래스
  */
-enum class EventType : __int8
+enum class EventType : BYTE
 {
 	Connect,
 	Disconnect,
@@ -22,15 +23,32 @@ class IocpObject;
 /**
  * \brief IOCP 이벤트 클래스
  * \details 비동기 IO 함수의 lpOverlapped 인자로 사용되며 이후 완료 패킷이 어떤 이벤트로 부터 발생한 것인지 구분할 때 사용됩니다.
+ * \details Linux에서는 OVERLAPPED 대신 epoll 에뮬레이션이 수행할 IO 작업의 인자와 결과를 담습니다.
  */
+#ifdef _WIN32
 class IocpEvent : public OVERLAPPED
+#else
+class IocpEvent
+#endif
 {
 public:
 	IocpEvent(EventType type);
 	void Init();
 
 	EventType GetEventType() { return _type; }
-	shared_ptr<IocpObject> _owner;
+	IocpObject* _owner = nullptr; // 요청한 객체, 완료될 때까지 AddRef로 참조를 가짐
+
+#ifndef _WIN32
+	/* epoll 에뮬레이션 IO 작업 정보 */
+	SOCKET _socket = INVALID_SOCKET;
+	SOCKET _acceptSocket = INVALID_SOCKET; // Accept 결과를 옮겨 받을 소켓
+	vector<iovec> _iovs; // Recv/Send 버퍼, 부분 송신 시 앞에서부터 소모됨
+	int _numOfBytes = 0; // 완료된 바이트 수
+	int _errorCode = 0; // 0이 아니면 실패한 IO
+#ifdef USE_IO_URING
+	msghdr _msg = {}; // SENDMSG/RECVMSG 인자, 완료될 때까지 유지
+#endif
+#endif
 
 private:
 	EventType _type;
@@ -68,11 +86,19 @@ public:
 class AcceptEvent : public IocpEvent
 {
 public:
+	enum
+	{
+		FIRST_PACKET_SIZE = 0x100, // 연결과 함께 받을 첫 데이터의 최대 크기, 연결된 뒤 세션의 수신 버퍼로 옮김
+		ADDRESS_SIZE = (sizeof(SOCKADDR_IN) + 16) * 2, // AcceptEx가 로컬/원격 주소를 쓰는 크기
+	};
+
 	AcceptEvent() : IocpEvent(EventType::Accept)
 	{
 	}
 
 	shared_ptr<Session> _session = nullptr;
+	bool _cancelled = false; // 줄어들며 취소를 요청함, 완료될 때 해제
+	BYTE _acceptBuffer[FIRST_PACKET_SIZE + ADDRESS_SIZE] = {}; // AcceptEx가 첫 데이터와 그 뒤에 주소를 쓰는 버퍼
 };
 
 
@@ -90,45 +116,216 @@ public:
 
 /**
  * \brief Send 비동기 이벤트
+ * \details 한번에 보낼 버퍼 목록을 고정 크기 배열로 가져 송신마다 메모리를 할당하지 않습니다.
  */
 class SendEvent : public IocpEvent
 {
 public:
+	enum
+	{
+		MAX_SEGMENT_COUNT = 64, // 한번의 송신 요청에 담을 수 있는 최대 버퍼 수
+	};
+
 	SendEvent() : IocpEvent(EventType::Send)
 	{
 	}
 
-	vector<shared_ptr<SendBuffer>> _sendBuffers;
+	void Clear();
+
+	WSABUF _wsaBufs[MAX_SEGMENT_COUNT] = {};
+	unsigned int _wsaBufCount = 0;
+	SendBufferRef _sendBuffers[MAX_SEGMENT_COUNT]; // 송신이 끝날 때까지 참조를 유지할 버퍼
+	unsigned int _sendBufferCount = 0;
+};
+
+// 체인은 나누지 않고 한번의 송신에 담음
+static_assert(SendBufferManager::MAX_CHAIN_COUNT <= SendEvent::MAX_SEGMENT_COUNT, "send chain must fit in one SendEvent");
+
+
+#ifdef USE_IO_URING
+/**
+ * \brief io_uring 멀티샷 결과 구조체
+ * \details 대기중인 이벤트 없이 먼저 도착한 Accept/Recv 결과를 다음 요청까지 보관합니다.
+ */
+struct UringResult
+{
+	int result; // Accept: 연결된 소켓, Recv: 수신 바이트 수 (0이면 연결 종료)
+	unsigned short bufferId; // Recv 데이터가 담긴 커널 제공 버퍼
+	int offset; // 이미 옮겨간 바이트 수
+	EventType type; // Accept 또는 Recv
 };
 
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+#endif
+
 
 /**
  * \brief Iocp Object 클래스
  * \details 비동기 IO 요청을 발생시킬 클래스의 기초 클래스로 사용합니다.
  * \details IocpEvent의 owner 변수에 대입되며, 해당 이벤트를 발생시킨 주체를 구분할 수 있도록 사용됩니다.
+ * \details 완료되지 않은 비동기 IO는 _refCount 하나로 세고, 0이 아닌 동안만 자기 shared_ptr을 가져 객체를 유지합니다.
+ * \details Session과 Listener는 Service, Room, 패킷 처리 함수가 shared_ptr로 함께 소유하므로 소유권은 shared_ptr에 두고 IO 참조만 침습형으로 셉니다.
+ * \details 연결된 세션은 항상 Recv를 걸어두어 _refCount가 0이 되지 않으므로, 자기 shared_ptr을 잡고 놓는 REF_LOCKED 구간은 첫 IO와 마지막 IO에서만 지납니다.
  */
 class IocpObject : public enable_shared_from_this<IocpObject>
 {
 public:
-	virtual HANDLE GetHandle() abstract;
-	virtual void Dispatch(IocpEvent* iocpEvent, int numOfBytes = 0) abstract;
+	virtual ~IocpObject();
+
+	virtual HANDLE GetHandle() = 0;
+	virtual void Dispatch(IocpEvent* iocpEvent, int numOfBytes = 0) = 0;
+
+	/* 비동기 IO 참조 */
+	void AddRef();
+	void ReleaseRef();
+
+protected:
+	void Unregister();
+
+private:
+	enum
+	{
+		REF_LOCKED = -1, // 자기 참조를 잡거나 놓는 중
+	};
+
+	atomic<int> _refCount = 0; // 완료되지 않은 비동기 IO 수
+	shared_ptr<IocpObject> _self = nullptr; // _refCount가 0이 아닌 동안 자기 참조
+
+#ifndef _WIN32
+private:
+	friend class Iocp;
+
+	/* 완료 에뮬레이션 대기 작업 */
+	Iocp* _iocp = nullptr;
+	mutex _ioMutex;
+	deque<IocpEvent*> _pendingReads; // Accept, Recv
+#ifdef USE_IO_URING
+	deque<UringResult> _readyReads; // 대기 작업 없이 먼저 도착한 멀티샷 결과
+	bool _multishotArmed = false; // 멀티샷 요청이 살아있는 동안 AddRef로 참조를 가짐
+	bool _recvCancelling = false; // 보관한 수신 결과가 가득 차 멀티샷 Recv 취소를 요청함
+#else
+	deque<IocpEvent*> _pendingWrites; // Send
+	atomic<unsigned int> _readSeq = 0; // 읽기 준비 알림 횟수
+	atomic<unsigned int> _writeSeq = 0; // 쓰기 준비 알림 횟수
+#endif
+#endif
 };
 
 
 /**
  * \brief Iocp 클래스 \n
  * \details IOCP 코어에 해당하며 IocpObject의 CP 등록과 완료패킷 처리를 담당합니다.
+ * \details Linux에서는 epoll(기본) 또는 io_uring(USE_IO_URING)으로 완료 모델을 에뮬레이션합니다. IO 작업은 Post로 요청됩니다.
  */
 class Iocp
 {
 public:
-	Iocp();
+	enum
+	{
+		MAX_BATCH_SIZE = 64, // 한번의 대기로 꺼낼 수 있는 최대 완료 패킷 수
+	};
+
+	Iocp(unsigned int batchSize = 1);
 	~Iocp();
 
 	HANDLE GetHandle() { return _iocpHandle; }
 	bool Register(shared_ptr<IocpObject> iocpObject);
 	bool Dispatch(unsigned int timeoutMs = INFINITE);
 
+	unsigned int GetBatchSize() { return _batchSize; }
+	vector<unsigned long long> GetBatchHistogram();
+
+#ifndef _WIN32
+	static bool Post(IocpEvent* iocpEvent);
+	static bool Cancel(IocpEvent* iocpEvent);
+	void Unregister(IocpObject* iocpObject);
+#endif
+
+private:
+	void RecordBatch(unsigned int count);
+
+#ifndef _WIN32
+#ifdef USE_IO_URING
+	void Arm(IocpObject* iocpObject, EventType type);
+	void PushMessage(IocpEvent* iocpEvent, unsigned char opcode);
+	void PostCompleted(IocpEvent* iocpEvent);
+	void Push(const io_uring_sqe& sqe);
+	void Submit();
+	int Enter(unsigned int toSubmit, unsigned int minComplete, unsigned int flags, void* arg = nullptr,
+	          size_t argSize = 0);
+	unsigned int Reap(OUT io_uring_cqe* cqes, unsigned int maxCount);
+
+	void OnEvent(IocpEvent* iocpEvent, int result);
+	void OnAccept(IocpObject* iocpObject, int result, unsigned int flags);
+	void OnRecv(IocpObject* iocpObject, int result, unsigned int flags);
+	void Complete(IocpEvent* iocpEvent);
+
+	static void Adopt(IocpEvent* iocpEvent, SOCKET socket);
+	void Fill(IocpEvent* iocpEvent, deque<UringResult>& readyReads);
+	void RecycleBuffer(unsigned short bufferId);
+#else
+	bool Watch(SOCKET socket);
+	void Progress(IocpObject* iocpObject, deque<IocpEvent*>& pendings, atomic<unsigned int>& seq,
+	              bool inlineDispatch);
+	bool Execute(IocpEvent* iocpEvent);
+	void Complete(IocpEvent* iocpEvent, bool inlineDispatch);
+
+	void PostCompletion(IocpEvent* iocpEvent);
+	unsigned int PopCompletions(OUT IocpEvent** iocpEvents, unsigned int maxCount);
+	void Wakeup();
+#endif
+#endif
+
 private:
 	HANDLE _iocpHandle;
+
+	unsigned int _batchSize; // Dispatch 한번에 처리할 최대 완료 패킷 수
+	atomic<unsigned long long> _batchHistogram[MAX_BATCH_SIZE + 1] = {}; // 처리한 완료 패킷 수별 Dispatch 횟수
+
+#ifndef _WIN32
+#ifdef USE_IO_URING
+	enum
+	{
+		RECV_BUFFER_COUNT = 1024, // 2의 거듭제곱
+		RECV_BUFFER_SIZE = 0x1000,
+		RECV_BUFFER_GROUP = 0,
+		MAX_READY_RECV = 16, // 객체마다 보관할 수 있는 수신 결과 수, 가장 큰 수신 버퍼(64KB)만큼
+	};
+
+	BYTE* _ringMemory = nullptr;
+	size_t _ringSize = 0;
+
+	/* 제출 큐 */
+	mutex _sqMutex;
+	unsigned int* _sqHead = nullptr;
+	unsigned int* _sqTail = nullptr;
+	unsigned int* _sqArray = nullptr;
+	unsigned int _sqMask = 0;
+	unsigned int _sqEntries = 0;
+	io_uring_sqe* _sqes = nullptr;
+	atomic<unsigned int> _unsubmitted = 0; // 아직 커널에 제출하지 않은 요청 수
+
+	/* 완료 큐 */
+	mutex _cqMutex;
+	unsigned int* _cqHead = nullptr;
+	unsigned int* _cqTail = nullptr;
+	unsigned int _cqMask = 0;
+	io_uring_cqe* _cqes = nullptr;
+
+	/* 커널 제공 수신 버퍼 링, 멀티샷 Recv가 사용 */
+	mutex _bufferMutex;
+	io_uring_buf_ring* _bufferRing = nullptr;
+	vector<BYTE> _recvBuffers;
+#else
+	int _wakeupFd = -1; // 완료 큐에 쌓인 이벤트를 알리는 eventfd
+
+	mutex _completionMutex;
+	queue<IocpEvent*> _completions; // 요청 즉시 완료된 이벤트
+
+	shared_mutex _objectsMutex;
+	unordered_map<SOCKET, weak_ptr<IocpObject>> _objects; // epoll 알림 대상 조회
+#endif
+#endif
 };
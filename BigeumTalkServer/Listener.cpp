@@ -5,6 +5,8 @@
 
 Listener::~Listener()
 {
+	// 기초 클래스 소멸자에서는 GetHandle을 부를 수 없으므로 먼저 분리
+	Unregister();
 	closesocket(_socket);
 	for (AcceptEvent* acceptEvent : _acceptEvents)
 	{
@@ -16,16 +18,22 @@ Listener::~Listener()
 /**
  * \brief 리슨 소켓 설정 및 Accept 비동기 작업 요청 함수
  * \param service 리슨 소켓을 연결할 서비스
+ * \param shard 리슨 소켓을 등록할 샤드 번호
  * \return 작업 성공 여부
  */
-bool Listener::StartAccept(shared_ptr<Service> service)
+bool Listener::StartAccept(shared_ptr<Service> service, unsigned int shard)
 {
 	_service = service;
+	_shard = shard;
 	if (_service == nullptr)
 	{
 		return false;
 	}
 
+	_config = _service->GetAcceptConfig();
+	_config.minCount = max(_config.minCount, 1u);
+	_config.maxCount = max(_config.maxCount, _config.minCount);
+
 	// 리슨 소켓 생성
 	_socket = SocketUtils::CreateSocket();
 	if (_socket == INVALID_SOCKET)
@@ -34,19 +42,37 @@ bool Listener::StartAccept(shared_ptr<Service> service)
 	}
 
 	// 리슨 소켓 CP에 등록
-	if (_service->GetIocp()->Register(shared_from_this()) == false)
+	if (_service->GetIocp(_shard)->Register(shared_from_this()) == false)
 	{
 		return false;
 	}
 
 	{
 		// 주소 재사용 설정
-		bool flag = true;
+		int flag = 1;
 		if (SOCKET_ERROR == setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&flag),
 		                               sizeof(flag)))
 		{
 			return false;
 		}
+
+#ifndef _WIN32
+		// 샤드마다 같은 주소로 리슨 소켓 생성
+		if (SOCKET_ERROR == setsockopt(_socket, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&flag),
+		                               sizeof(flag)))
+		{
+			return false;
+		}
+
+		// 첫 데이터가 도착하거나 대기 시간이 지난 연결만 Accept 되도록 함
+		int deferSeconds = static_cast<int>(_config.firstPacketTimeoutSeconds);
+		if (_config.firstPacket
+			&& SOCKET_ERROR == setsockopt(_socket, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+			                              reinterpret_cast<const char*>(&deferSeconds), sizeof(deferSeconds)))
+		{
+			return false;
+		}
+#endif
 	}
 
 	// 주소 bind
@@ -61,16 +87,9 @@ bool Listener::StartAccept(shared_ptr<Service> service)
 		return false;
 	}
 
-	// AcceptEx 소켓 풀 생성
-	const int socketPoolCount = 100;
-	for (int i = 0; i < socketPoolCount; i++)
-	{
-		auto acceptEvent = new AcceptEvent();
-		acceptEvent->_owner = shared_from_this(); // 참조 증가
-		_acceptEvents.push_back(acceptEvent);
-		RegisterAccept(acceptEvent);
-	}
-
+	// AcceptEx 소켓 풀 생성, 최소 개수로 시작하여 접속률에 따라 조절
+	_windowStart = _lastAcceptTime = _lastTimeoutCheck = chrono::steady_clock::now();
+	Grow();
 
 	return true;
 }
@@ -99,7 +118,94 @@ void Listener::Dispatch(IocpEvent* iocpEvent, int numOfBytes)
 	auto acceptEvent = static_cast<AcceptEvent*>(iocpEvent);
 
 	// 완료 패킷을 처리
-	ProcessAccept(acceptEvent);
+	ProcessAccept(acceptEvent, numOfBytes);
+}
+
+
+/**
+ * \brief Accept 요청 상태와 접속률을 반환하는 함수
+ * \return AcceptStats
+ */
+AcceptStats Listener::GetAcceptStats()
+{
+	AcceptStats stats = {};
+	stats.outstanding = _outstanding.load();
+	stats.targetCount = _targetCount.load();
+	stats.acceptsPerSecond = _acceptsPerSecond.load();
+
+	const unsigned long long repostCount = _repostCount.load();
+	if (repostCount > 0)
+	{
+		stats.repostMicros = _repostNanos.load() / repostCount / 1000;
+	}
+
+	return stats;
+}
+
+
+/**
+ * \brief 첫 데이터 없이 오래 연결된 Accept 요청을 끊는 함수
+ * \details 리슨 소켓의 샤드 스레드에서 주기적으로 호출되며 1초에 한번만 확인합니다.
+ * \details Windows에서 AcceptEx가 첫 데이터를 기다리는 동안 연결만 하고 보내지 않는 클라이언트가 요청을 붙잡지 못하게 합니다.
+ * \details Linux는 TCP_DEFER_ACCEPT 대기 시간이 같은 역할을 합니다.
+ */
+void Listener::CheckAcceptTimeout()
+{
+#ifdef _WIN32
+	if (_config.firstPacket == false)
+	{
+		return;
+	}
+
+	const auto now = chrono::steady_clock::now();
+	if (now - _lastTimeoutCheck < chrono::seconds(1))
+	{
+		return;
+	}
+	_lastTimeoutCheck = now;
+
+	for (AcceptEvent* acceptEvent : _acceptEvents)
+	{
+		// 요청을 멈춘 이벤트는 세션이 없음
+		Session* session = acceptEvent->_session.get();
+		if (session == nullptr || session->_socket == INVALID_SOCKET)
+		{
+			continue;
+		}
+
+		// 연결된 뒤 지난 시간(초), 아직 연결되지 않았다면 0xFFFFFFFF
+		DWORD seconds = 0;
+		int size = sizeof(seconds);
+		if (SOCKET_ERROR == getsockopt(session->_socket, SOL_SOCKET, SO_CONNECT_TIME,
+		                               reinterpret_cast<char*>(&seconds), &size))
+		{
+			continue;
+		}
+
+		if (seconds != 0xFFFFFFFF && seconds >= _config.firstPacketTimeoutSeconds)
+		{
+			// 소켓을 닫으면 AcceptEx가 실패로 완료되어 새 세션으로 다시 요청됨
+			closesocket(session->_socket);
+			session->_socket = INVALID_SOCKET;
+		}
+	}
+#endif
+}
+
+
+/**
+ * \brief 새 세션을 등록할 샤드를 고르는 함수
+ * \return 샤드 번호
+ */
+unsigned int Listener::SelectShard()
+{
+#ifdef _WIN32
+	// 리슨 소켓 하나가 모든 샤드에 세션을 돌아가며 배정
+	return _nextShard.fetch_add(1) % _service->GetShardCount();
+#else
+	// 샤드마다 리슨 소켓이 있으므로 같은 샤드에 배정
+	return _shard;
+#endif
 }
 
 
@@ -109,21 +215,29 @@ void Listener::Dispatch(IocpEvent* iocpEvent, int numOfBytes)
  */
 void Listener::RegisterAccept(AcceptEvent* acceptEvent)
 {
-	shared_ptr<Session> session = _service->CreateSession(); // 세션을 미리 생성
+	shared_ptr<Session> session = _service->CreateSession(SelectShard()); // 세션을 미리 생성
 	acceptEvent->Init();
 	acceptEvent->_session = session; // 연결이 완료된 세션의 참조는 해제하며 새 세션 참조
+	acceptEvent->_owner = this;
+	AddRef(); // 참조 증가
+	_outstanding.fetch_add(1);
+
+	// 첫 데이터를 함께 받는다면 이벤트의 작은 고정 공간에 받고 뒤에 주소 정보를 받음
+	// 세션의 수신 버퍼는 연결된 뒤에 빌리므로 미리 요청한 Accept가 슬랩을 붙잡지 않음
+	DWORD receiveLength = 0;
+#ifdef _WIN32
+	if (_config.firstPacket)
+	{
+		receiveLength = AcceptEvent::FIRST_PACKET_SIZE;
+	}
+#endif
 
-	DWORD bytes = 0;
 	// 비동기 IO 작업 요청
-	if (false == SocketUtils::AcceptEx(_socket, session->GetSocket(), session->_recvBuffer.WritePos(), 0,
-	                                   sizeof(SOCKADDR_IN) + 16, sizeof(SOCKADDR_IN) + 16, OUT &bytes,
-	                                   static_cast<LPOVERLAPPED>(acceptEvent)))
+	if (false == SocketUtils::Accept(_socket, session->GetSocket(), acceptEvent->_acceptBuffer, receiveLength, acceptEvent))
 	{
-		const int errorCode = WSAGetLastError();
-		if (errorCode != WSA_IO_PENDING)
-		{
-			RegisterAccept(acceptEvent);
-		}
+		_outstanding.fetch_sub(1);
+		ReleaseRef();
+		RegisterAccept(acceptEvent);
 	}
 }
 
@@ -131,33 +245,85 @@ void Listener::RegisterAccept(AcceptEvent* acceptEvent)
 /**
  * \brief Accept 완료 패킷 처리 함수
  * \param acceptEvent 완료 패킷에 있는 AcceptEvent
+ * \param numOfBytes 연결과 함께 받은 첫 데이터의 크기 (Windows)
  */
-void Listener::ProcessAccept(AcceptEvent* acceptEvent)
+void Listener::ProcessAccept(AcceptEvent* acceptEvent, int numOfBytes)
 {
+	const auto completedTime = chrono::steady_clock::now();
 	shared_ptr<Session> session = acceptEvent->_session;
 
+	if (acceptEvent->_cancelled)
+	{
+		// 취소되었거나 취소 직전에 연결됨, 실패라면 아래에서 다시 요청되지 않음
+		acceptEvent->_cancelled = false;
+		_cancelling--;
+	}
+
+	// 남은 Accept 요청이 없다면 접속이 몰리는 중이므로 늘림
+	if (_outstanding.fetch_sub(1) == 1)
+	{
+		Grow();
+	}
+
+#ifdef _WIN32
 	// 연결된 소켓의 옵션을 리슨 소켓과 똑같이 함
 	if (SOCKET_ERROR == setsockopt(session->GetSocket(), SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT,
 	                               reinterpret_cast<char*>(&_socket), sizeof(_socket)))
 	{
-		RegisterAccept(acceptEvent);
+		Repost(acceptEvent);
 		return;
 	}
+#endif
 
 	SOCKADDR_IN sockAddr;
-	int sizeOfSockAddr = sizeof(sockAddr);
+	socklen_t sizeOfSockAddr = sizeof(sockAddr);
 	// Accept한 소켓의 주소 정보 얻기
 	if (SOCKET_ERROR == getpeername(session->GetSocket(), OUT reinterpret_cast<SOCKADDR*>(&sockAddr), &sizeOfSockAddr))
 	{
-		RegisterAccept(acceptEvent);
+		Repost(acceptEvent);
 		return;
 	}
 
 	session->SetAddress(sockAddr);
-	session->ProcessConnect();
+	_windowAccepts++;
+	_lastAcceptTime = completedTime;
 
-	// 다시 Accept 작업 등록
-	RegisterAccept(acceptEvent);
+#ifdef _WIN32
+	if (numOfBytes > 0)
+	{
+		// 이벤트의 고정 공간에 받은 첫 데이터를 세션의 수신 버퍼로 옮김
+		RecvBuffer& recvBuffer = session->_recvBuffer;
+		if (recvBuffer.Reserve(numOfBytes))
+		{
+			memcpy(recvBuffer.WritePos(), acceptEvent->_acceptBuffer, numOfBytes);
+		}
+		else
+		{
+			numOfBytes = 0;
+		}
+	}
+#else
+	if (_config.firstPacket)
+	{
+		// TCP_DEFER_ACCEPT로 첫 데이터가 도착한 뒤 Accept 되었으므로 준비 알림을 기다리지 않고 바로 읽음
+		RecvBuffer& recvBuffer = session->_recvBuffer;
+		if (recvBuffer.Reserve(sizeof(PacketHeader)))
+		{
+			ssize_t received = recv(session->GetSocket(), recvBuffer.WritePos(), recvBuffer.FreeSize(), MSG_DONTWAIT);
+			numOfBytes = static_cast<int>(max<ssize_t>(received, 0));
+		}
+	}
+#endif
+
+	// 연결과 함께 받은 첫 데이터가 있다면 바로 패킷 처리
+	session->ProcessConnect(numOfBytes);
+
+	if (Repost(acceptEvent))
+	{
+		const auto repostTime = chrono::steady_clock::now() - completedTime;
+		_repostNanos.fetch_add(chrono::duration_cast<chrono::nanoseconds>(repostTime).count());
+		_repostCount.fetch_add(1);
+	}
 
 	// TEMP LOG
 #ifdef _DEBUG
@@ -166,3 +332,117 @@ void Listener::ProcessAccept(AcceptEvent* acceptEvent)
 	cout << "[CLIENT ACCEPTED] " << ip << ':' << ntohs(sockAddr.sin_port) << " Accepted" << endl;
 #endif
 }
+
+
+/**
+ * \brief 완료된 AcceptEvent를 다시 요청하거나 쉬게 하는 함수
+ * \details 취소중이 아닌 요청이 이미 목표 수만큼 있다면 요청을 멈추고 미리 생성한 세션 참조를 해제합니다.
+ * \param acceptEvent 완료된 AcceptEvent
+ * \return 다시 요청했다면 true
+ */
+bool Listener::Repost(AcceptEvent* acceptEvent)
+{
+	if (_outstanding.load() - _cancelling >= _targetCount.load())
+	{
+		acceptEvent->_session = nullptr;
+		_idleEvents.push_back(acceptEvent);
+		return false;
+	}
+
+	RegisterAccept(acceptEvent);
+	return true;
+}
+
+
+/**
+ * \brief Accept 요청 수를 두배로 늘리는 함수
+ * \details 처음 호출될 때는 최소 개수만큼 요청합니다. 최대 개수를 넘지 않습니다.
+ */
+void Listener::Grow()
+{
+	const unsigned int targetCount = clamp(_targetCount.load() * 2, _config.minCount, _config.maxCount);
+	_targetCount.store(targetCount);
+
+	while (_outstanding.load() - _cancelling < targetCount)
+	{
+		AcceptEvent* acceptEvent = nullptr;
+		if (_idleEvents.empty() == false)
+		{
+			acceptEvent = _idleEvents.back();
+			_idleEvents.pop_back();
+		}
+		else
+		{
+			acceptEvent = new AcceptEvent();
+			_acceptEvents.push_back(acceptEvent);
+		}
+
+		RegisterAccept(acceptEvent);
+	}
+}
+
+
+/**
+ * \brief 목표보다 많이 요청된 Accept를 취소하는 함수
+ * \details 취소된 요청은 실패로 완료되어 Repost에서 쉬게 되므로 미리 생성한 세션이 해제됩니다.
+ */
+void Listener::Shrink()
+{
+	const unsigned int targetCount = _targetCount.load();
+	for (AcceptEvent* acceptEvent : _acceptEvents)
+	{
+		if (_outstanding.load() - _cancelling <= targetCount)
+		{
+			break;
+		}
+
+		// 요청을 멈췄거나 이미 취소를 요청한 이벤트
+		if (acceptEvent->_session == nullptr || acceptEvent->_cancelled)
+		{
+			continue;
+		}
+
+#ifdef _WIN32
+		const bool cancelled = CancelIoEx(reinterpret_cast<HANDLE>(_socket), acceptEvent) != FALSE;
+#else
+		const bool cancelled = Iocp::Cancel(acceptEvent);
+#endif
+		if (cancelled)
+		{
+			acceptEvent->_cancelled = true;
+			_cancelling++;
+		}
+	}
+}
+
+
+/**
+ * \brief 1초 구간마다 접속률을 계산하고 한가하다면 Accept 요청 수를 줄이는 함수
+ * \details 리슨 소켓의 샤드 스레드에서 주기적으로 호출되므로 접속이 없는 동안에도 구간이 넘어갑니다.
+ * \details 마지막 접속 뒤 idleSeconds가 지났거나 접속률이 요청 수에 비해 낮으면 절반으로 줄이고 남는 요청을 취소합니다.
+ */
+void Listener::UpdateAcceptRate()
+{
+	const auto now = chrono::steady_clock::now();
+	const auto elapsed = now - _windowStart;
+	if (elapsed < chrono::seconds(1))
+	{
+		return;
+	}
+
+	const unsigned long long elapsedMs = chrono::duration_cast<chrono::milliseconds>(elapsed).count();
+	const unsigned long long acceptsPerSecond = _windowAccepts * 1000 / elapsedMs;
+	_acceptsPerSecond.store(acceptsPerSecond);
+	_windowStart = now;
+	_windowAccepts = 0;
+
+	// 잠깐 접속이 끊긴 구간은 몰려오는 접속 사이일 수 있으므로 idleSeconds 동안은 유지
+	const unsigned int targetCount = _targetCount.load();
+	const bool idle = now - _lastAcceptTime >= chrono::seconds(_config.idleSeconds);
+	const bool slow = acceptsPerSecond > 0 && acceptsPerSecond * 4 < targetCount;
+	if ((idle || slow) && targetCount > _config.minCount)
+	{
+		_targetCount.store(max(targetCount / 2, _config.minCount));
+		Shrink();
+	}
+}
@@ -7,6 +7,34 @@ using namespace std;
 class Service;
 
 
+/**
+ * \brief AcceptConfig 구조체
+ * \details 리슨 소켓마다 미리 요청해 둘 Accept 수의 범위입니다. 접속률에 따라 이 범위 안에서 늘고 줄어듭니다.
+ * \details firstPacket을 켜면 연결과 함께 첫 데이터를 받아 Recv 요청 한번을 생략합니다.
+ */
+struct AcceptConfig
+{
+	unsigned int minCount = 16; // 최소 Accept 요청 수, 시작 값
+	unsigned int maxCount = 4096; // 최대 Accept 요청 수
+	unsigned int idleSeconds = 10; // 접속 사이 간격이 이보다 길면 줄임
+	bool firstPacket = false; // 첫 데이터가 도착한 뒤 Accept 완료 (Windows: AcceptEx 수신, Linux: TCP_DEFER_ACCEPT)
+	unsigned int firstPacketTimeoutSeconds = 5; // 첫 데이터 없이 Accept를 붙잡을 수 있는 최대 시간
+};
+
+
+/**
+ * \brief AcceptStats 구조체
+ * \details 리슨 소켓의 Accept 요청 상태와 접속률입니다.
+ */
+struct AcceptStats
+{
+	unsigned int outstanding; // 요청 중인 Accept 수
+	unsigned int targetCount; // 유지하려는 Accept 수
+	unsigned long long acceptsPerSecond; // 마지막 1초 구간의 접속률
+	unsigned long long repostMicros; // Accept 완료부터 다시 요청하기까지의 평균 시간
+};
+
+
 /**
  * \brief Listener 클래스
  * \details 리슨 소켓을 담당하는 클래스입니다.
@@ -19,16 +47,46 @@ public:
 	~Listener();
 
 public:
-	bool StartAccept(shared_ptr<Service> service);
+	bool StartAccept(shared_ptr<Service> service, unsigned int shard = 0);
 	HANDLE GetHandle() override;
 	void Dispatch(IocpEvent* iocpEvent, int numOfBytes = 0) override;
+	AcceptStats GetAcceptStats();
+	void CheckAcceptTimeout();
+	void UpdateAcceptRate();
+
+	/** \brief 리슨 소켓이 등록된 샤드 번호를 반환하는 함수 \return _shard */
+	unsigned int GetShard() { return _shard; }
 
 private:
+	unsigned int SelectShard();
 	void RegisterAccept(AcceptEvent* acceptEvent);
-	void ProcessAccept(AcceptEvent* acceptEvent);
+	void ProcessAccept(AcceptEvent* acceptEvent, int numOfBytes);
+	bool Repost(AcceptEvent* acceptEvent);
+
+	/* Accept 요청 수 조절 */
+	void Grow();
+	void Shrink();
 
 private:
 	SOCKET _socket = INVALID_SOCKET;
-	vector<AcceptEvent*> _acceptEvents;
+	vector<AcceptEvent*> _acceptEvents; // 생성한 모든 AcceptEvent
+	vector<AcceptEvent*> _idleEvents; // 줄어들며 요청을 멈춘 AcceptEvent, 늘어날 때 재사용
+
+	/* Accept 요청 수 조절, 리슨 소켓의 샤드 스레드에서만 변경 */
+	AcceptConfig _config;
+	atomic<unsigned int> _outstanding = 0;
+	atomic<unsigned int> _targetCount = 0;
+	unsigned int _cancelling = 0; // _outstanding 중 취소를 요청한 수
+	chrono::steady_clock::time_point _windowStart;
+	chrono::steady_clock::time_point _lastAcceptTime;
+	unsigned long long _windowAccepts = 0;
+	chrono::steady_clock::time_point _lastTimeoutCheck;
+
+	/* 통계 */
+	atomic<unsigned long long> _acceptsPerSecond = 0;
+	atomic<unsigned long long> _repostNanos = 0;
+	atomic<unsigned long long> _repostCount = 0;
 	shared_ptr<Service> _service;
+	unsigned int _shard = 0; // 리슨 소켓이 등록된 샤드
+	atomic<unsigned int> _nextShard = 0; // 세션을 나눠 배정할 다음 샤드
 };
@@ -0,0 +1,690 @@
+﻿#include "pch.h"
+#include "PacketCodec.h"
+#include "PacketHandler.h"
+#include <climits>
+#include <cstring>
+
+namespace
+{
+	enum
+	{
+		RECURSION_LIMIT = 100, // protobuf 파서의 기본 중첩 제한
+		SLOP_BYTES = 16, // protobuf 파서가 길이 상한에서 빼는 여유 바이트
+	};
+
+	enum WireType : uint32_t
+	{
+		WIRE_VARINT = 0,
+		WIRE_FIXED64 = 1,
+		WIRE_LENGTH_DELIMITED = 2,
+		WIRE_START_GROUP = 3,
+		WIRE_END_GROUP = 4,
+		WIRE_FIXED32 = 5,
+	};
+
+	/* 필드 태그, (필드 번호 << 3) | 와이어 타입 */
+	enum : uint32_t
+	{
+		TAG_USER_NICKNAME = (1 << 3) | WIRE_LENGTH_DELIMITED,
+		TAG_USER_ID = (2 << 3) | WIRE_VARINT,
+		TAG_C_CHAT_USER = (1 << 3) | WIRE_LENGTH_DELIMITED,
+		TAG_C_CHAT_MSG = (2 << 3) | WIRE_LENGTH_DELIMITED,
+		TAG_S_CHAT_USER = (2 << 3) | WIRE_LENGTH_DELIMITED,
+		TAG_S_CHAT_MSG = (3 << 3) | WIRE_LENGTH_DELIMITED,
+		TAG_S_CHAT_TIMESTAMP = (4 << 3) | WIRE_FIXED64,
+		TAG_S_CHAT_USER_ID = (5 << 3) | WIRE_VARINT,
+		TAG_USER_DICTIONARY_USERS = (1 << 3) | WIRE_LENGTH_DELIMITED,
+		TAG_NOTICE_USER = (1 << 3) | WIRE_LENGTH_DELIMITED, // S_OTHER_ENTER, S_OTHER_LEAVE
+		TAG_NOTICE_TIMESTAMP = (2 << 3) | WIRE_FIXED64,
+	};
+
+
+	/**
+	 * \brief protobuf 와이어 포맷 리더 클래스
+	 * \details 생성된 파서와 같은 규칙으로 태그, varint, 길이를 읽으며 범위를 넘는 읽기는 실패합니다.
+	 */
+	class WireReader
+	{
+	public:
+		WireReader(const BYTE* begin, const BYTE* end) : _ptr(begin), _end(end)
+		{
+		}
+
+		bool Done() { return _ptr == _end; }
+
+		/**
+		 * \brief 태그를 읽는 함수
+		 * \details 최대 5바이트이며 32비트를 넘는 값은 버립니다.
+		 */
+		bool ReadTag(OUT uint32_t& tag)
+		{
+			uint32_t value = 0;
+			for (int i = 0; i < 5 && _ptr < _end; i++)
+			{
+				const BYTE byte = *_ptr++;
+				value |= static_cast<uint32_t>(byte & 0x7F) << (7 * i);
+				if (byte < 0x80)
+				{
+					tag = value;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * \brief varint를 읽는 함수
+		 * \details 최대 10바이트이며 64비트를 넘는 값은 버립니다.
+		 */
+		bool ReadVarint(OUT uint64_t& value)
+		{
+			value = 0;
+			for (int i = 0; i < 10 && _ptr < _end; i++)
+			{
+				const BYTE byte = *_ptr++;
+				value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+				if (byte < 0x80)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * \brief 길이 구분 필드의 길이를 읽는 함수
+		 * \details 최대 5바이트이며 int 범위를 넘거나 남은 데이터보다 길면 실패합니다.
+		 */
+		bool ReadSize(OUT uint32_t& size)
+		{
+			uint32_t value = 0;
+			for (int i = 0; i < 5 && _ptr < _end; i++)
+			{
+				const BYTE byte = *_ptr++;
+				if (i == 4 && byte >= 8)
+				{
+					return false;
+				}
+
+				value |= static_cast<uint32_t>(byte & 0x7F) << (7 * i);
+				if (byte < 0x80)
+				{
+					if (value > INT_MAX - SLOP_BYTES || value > static_cast<size_t>(_end - _ptr))
+					{
+						return false;
+					}
+					size = value;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool ReadBytes(OUT string_view& bytes)
+		{
+			uint32_t size;
+			if (ReadSize(size) == false)
+			{
+				return false;
+			}
+
+			bytes = string_view(reinterpret_cast<const char*>(_ptr), size);
+			_ptr += size;
+			return true;
+		}
+
+		bool Skip(size_t size)
+		{
+			if (size > static_cast<size_t>(_end - _ptr))
+			{
+				return false;
+			}
+			_ptr += size;
+			return true;
+		}
+
+		bool SkipField(uint32_t tag, int depth);
+
+	private:
+		const BYTE* _ptr;
+		const BYTE* _end;
+	};
+
+
+	/**
+	 * \brief 알 수 없는 필드를 건너뛰는 함수
+	 * \details 그룹은 짝이 맞는 끝 태그까지 건너뛰며 필드 번호 0과 정의되지 않은 와이어 타입은 실패합니다.
+	 * \param tag 이미 읽은 필드의 태그
+	 * \param depth 남은 중첩 깊이
+	 * \return 성공 여부
+	 */
+	bool WireReader::SkipField(uint32_t tag, int depth)
+	{
+		if ((tag >> 3) == 0)
+		{
+			return false;
+		}
+
+		switch (tag & 7)
+		{
+		case WIRE_VARINT:
+		{
+			uint64_t value;
+			return ReadVarint(value);
+		}
+		case WIRE_FIXED64:
+			return Skip(8);
+		case WIRE_LENGTH_DELIMITED:
+		{
+			string_view bytes;
+			return ReadBytes(bytes);
+		}
+		case WIRE_START_GROUP:
+		{
+			if (--depth < 0)
+			{
+				return false;
+			}
+
+			while (Done() == false)
+			{
+				uint32_t innerTag;
+				if (ReadTag(innerTag) == false || innerTag == 0)
+				{
+					return false;
+				}
+				if ((innerTag & 7) == WIRE_END_GROUP)
+				{
+					return innerTag == tag + 1;
+				}
+				if (SkipField(innerTag, depth) == false)
+				{
+					return false;
+				}
+			}
+			return false;
+		}
+		case WIRE_FIXED32:
+			return Skip(4);
+		default:
+			return false;
+		}
+	}
+
+
+	/**
+	 * \brief 올바른 UTF-8인지 확인하는 함수
+	 * \details 생성된 파서처럼 overlong 인코딩, 서로게이트, U+10FFFF를 넘는 코드 포인트를 거부합니다.
+	 */
+	bool IsValidUtf8(string_view str)
+	{
+		auto ptr = reinterpret_cast<const BYTE*>(str.data());
+		const auto end = ptr + str.size();
+
+		while (ptr < end)
+		{
+			const BYTE lead = *ptr++;
+			if (lead < 0x80)
+			{
+				continue;
+			}
+
+			int count;
+			BYTE min = 0x80;
+			BYTE max = 0xBF;
+			if (lead >= 0xC2 && lead <= 0xDF)
+			{
+				count = 1;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF)
+			{
+				count = 2;
+				if (lead == 0xE0)
+				{
+					min = 0xA0;
+				}
+				else if (lead == 0xED)
+				{
+					max = 0x9F;
+				}
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4)
+			{
+				count = 3;
+				if (lead == 0xF0)
+				{
+					min = 0x90;
+				}
+				else if (lead == 0xF4)
+				{
+					max = 0x8F;
+				}
+			}
+			else
+			{
+				return false;
+			}
+
+			if (end - ptr < count || *ptr < min || *ptr > max)
+			{
+				return false;
+			}
+			ptr++;
+
+			for (int i = 1; i < count; i++, ptr++)
+			{
+				if (*ptr < 0x80 || *ptr > 0xBF)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+
+	/**
+	 * \brief User 메시지 필드를 읽는 함수
+	 * \details 여러번 온 User는 생성된 코드처럼 병합됩니다.
+	 */
+	bool ParseUser(WireReader reader, int depth, C_CHAT_View& view)
+	{
+		while (reader.Done() == false)
+		{
+			uint32_t tag;
+			if (reader.ReadTag(tag) == false)
+			{
+				return false;
+			}
+
+			if (tag == TAG_USER_NICKNAME)
+			{
+				if (reader.ReadBytes(view.nickname) == false || IsValidUtf8(view.nickname) == false)
+				{
+					return false;
+				}
+			}
+			else if (tag == TAG_USER_ID)
+			{
+				uint64_t id;
+				if (reader.ReadVarint(id) == false)
+				{
+					return false;
+				}
+				view.userId = id;
+			}
+			else if (tag == 0 || (tag & 7) == WIRE_END_GROUP)
+			{
+				// 중첩 메시지가 끝 태그로 끝나면 실패
+				return false;
+			}
+			else if (reader.SkipField(tag, depth) == false)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	/**
+	 * \brief protobuf 와이어 포맷 라이터 클래스
+	 * \details 미리 계산한 크기의 버퍼에 생성된 코드와 같은 바이트로 필드를 씁니다.
+	 * \details 태그는 모두 1바이트인 필드 번호 15 이하만 사용합니다.
+	 */
+	class WireWriter
+	{
+	public:
+		explicit WireWriter(BYTE* ptr) : _ptr(ptr)
+		{
+		}
+
+		BYTE* Ptr() { return _ptr; }
+
+		static size_t VarintSize(uint64_t value)
+		{
+			size_t size = 1;
+			while (value >= 0x80)
+			{
+				value >>= 7;
+				size++;
+			}
+			return size;
+		}
+
+		static size_t BytesFieldSize(size_t size) { return 1 + VarintSize(size) + size; }
+		static size_t Fixed64FieldSize() { return 1 + sizeof(uint64_t); }
+
+		void WriteVarint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				*_ptr++ = static_cast<BYTE>(value | 0x80);
+				value >>= 7;
+			}
+			*_ptr++ = static_cast<BYTE>(value);
+		}
+
+		void WriteVarintField(uint32_t tag, uint64_t value)
+		{
+			*_ptr++ = static_cast<BYTE>(tag);
+			WriteVarint(value);
+		}
+
+		/** \brief 문자열 또는 미리 직렬화한 메시지를 길이와 함께 그대로 씀 */
+		void WriteBytesField(uint32_t tag, string_view bytes)
+		{
+			*_ptr++ = static_cast<BYTE>(tag);
+			WriteVarint(bytes.size());
+			memcpy(_ptr, bytes.data(), bytes.size());
+			_ptr += bytes.size();
+		}
+
+		/** \brief fixed64를 리틀 엔디언으로 씀 */
+		void WriteFixed64Field(uint32_t tag, uint64_t value)
+		{
+			*_ptr++ = static_cast<BYTE>(tag);
+			for (size_t i = 0; i < sizeof(value); i++)
+			{
+				*_ptr++ = static_cast<BYTE>(value >> (8 * i));
+			}
+		}
+
+	private:
+		BYTE* _ptr;
+	};
+
+
+	/** \brief double의 비트 표현, 생성된 코드는 이 값이 0일 때만 필드를 생략 */
+	uint64_t RawDouble(double value)
+	{
+		uint64_t raw;
+		static_assert(sizeof(raw) == sizeof(value), "double must be 64-bit");
+		memcpy(&raw, &value, sizeof(value));
+		return raw;
+	}
+
+
+	/**
+	 * \brief 한 청크에 담기는 패킷을 SendBuffer에 쓰는 함수
+	 * \tparam WriteFunc 패킷 객체를 쓰는 함수
+	 * \param pktId 프로토콜 ID
+	 * \param dataSize 직렬화된 패킷 객체의 크기
+	 * \param write 패킷 객체를 쓰는 함수, WireWriter를 인자로 받음
+	 * \return 직렬화된 내용이 담긴 버퍼
+	 */
+	template <typename WriteFunc>
+	SendBufferRef WritePacket(unsigned short pktId, size_t dataSize, WriteFunc write)
+	{
+		const size_t packetSize = sizeof(PacketHeader) + dataSize;
+
+		SendBufferRef sendBuffer = GSendBufferManager->Open(static_cast<unsigned int>(packetSize));
+		auto header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
+		header->id = pktId;
+		header->size = static_cast<unsigned short>(packetSize);
+
+		WireWriter writer(reinterpret_cast<BYTE*>(&header[1]));
+		write(writer);
+		ASSERT_CRASH(writer.Ptr() == sendBuffer->Buffer() + packetSize);
+
+		sendBuffer->Close(static_cast<unsigned int>(packetSize));
+		return sendBuffer;
+	}
+
+
+	/** \brief 한 청크에 담기는 패킷인지 확인하는 함수 */
+	bool FitsInChunk(size_t dataSize)
+	{
+		return sizeof(PacketHeader) + dataSize <= SendBufferManager::MAX_BUFFER_SIZE;
+	}
+
+
+	/**
+	 * \brief 유저 입장, 퇴장 알림을 SendBuffer에 쓰는 함수
+	 * \details S_OTHER_ENTER와 S_OTHER_LEAVE는 같은 필드 구성입니다.
+	 * \tparam PacketType Protocol::S_OTHER_ENTER 또는 Protocol::S_OTHER_LEAVE
+	 * \param pktId 프로토콜 ID
+	 * \param user 직렬화된 User 메시지
+	 * \param timestamp 알림 시간
+	 * \param makeBuffer 한 청크에 담기지 않을 때 사용할 생성된 MakeBuffer 함수
+	 * \return 직렬화된 내용이 담긴 버퍼
+	 */
+	template <typename PacketType>
+	SendBufferRef MakeUserNotice(unsigned short pktId, string_view user, double timestamp,
+	                             SendBufferRef (*makeBuffer)(PacketType&))
+	{
+		const uint64_t rawTimestamp = RawDouble(timestamp);
+		const size_t dataSize = WireWriter::BytesFieldSize(user.size()) +
+			(rawTimestamp == 0 ? 0 : WireWriter::Fixed64FieldSize());
+
+		if (FitsInChunk(dataSize) == false)
+		{
+			PacketType pkt;
+			pkt.mutable_user()->ParseFromArray(user.data(), static_cast<int>(user.size()));
+			pkt.set_timestamp(timestamp);
+			return makeBuffer(pkt);
+		}
+
+		return WritePacket(pktId, dataSize, [&](WireWriter& writer)
+		{
+			writer.WriteBytesField(TAG_NOTICE_USER, user);
+			if (rawTimestamp != 0)
+			{
+				writer.WriteFixed64Field(TAG_NOTICE_TIMESTAMP, rawTimestamp);
+			}
+		});
+	}
+}
+
+
+/**
+ * \brief C_CHAT 패킷을 읽는 함수
+ * \details 생성된 코드와 같이 모르는 필드는 건너뛰고, 같은 필드가 여러번 오면 마지막 값을 사용하며, 문자열이 올바른 UTF-8이 아니면 실패합니다.
+ * \param data 직렬화된 패킷 객체
+ * \param size data의 크기
+ * \return 성공 여부
+ */
+bool C_CHAT_View::ParseFromArray(const void* data, int size)
+{
+	*this = C_CHAT_View();
+
+	auto begin = static_cast<const BYTE*>(data);
+	WireReader reader(begin, begin + size);
+	const int depth = RECURSION_LIMIT;
+
+	while (reader.Done() == false)
+	{
+		uint32_t tag;
+		if (reader.ReadTag(tag) == false)
+		{
+			return false;
+		}
+
+		if (tag == TAG_C_CHAT_USER)
+		{
+			string_view user;
+			if (reader.ReadBytes(user) == false)
+			{
+				return false;
+			}
+
+			auto userBegin = reinterpret_cast<const BYTE*>(user.data());
+			if (ParseUser(WireReader(userBegin, userBegin + user.size()), depth - 1, *this) == false)
+			{
+				return false;
+			}
+			hasUser = true;
+		}
+		else if (tag == TAG_C_CHAT_MSG)
+		{
+			if (reader.ReadBytes(msg) == false || IsValidUtf8(msg) == false)
+			{
+				return false;
+			}
+		}
+		else if (tag == 0 || (tag & 7) == WIRE_END_GROUP)
+		{
+			// 최상위 메시지는 데이터 끝에서만 끝날 수 있음
+			return false;
+		}
+		else if (reader.SkipField(tag, depth) == false)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * \brief User 메시지를 직렬화하는 함수
+ * \details 로그인할 때 한번 만들어 User에 보관하고, 유저 정보를 담는 패킷에 그대로 붙여 씁니다.
+ * \param userId 유저 ID
+ * \param nickname 유저 닉네임
+ * \return Protocol::User::SerializeAsString과 같은 바이트
+ */
+string PacketCodec::EncodeUser(unsigned long long userId, string_view nickname)
+{
+	const size_t size = (nickname.empty() ? 0 : WireWriter::BytesFieldSize(nickname.size())) +
+		(userId == 0 ? 0 : 1 + WireWriter::VarintSize(userId));
+
+	string encoded(size, '\0');
+	WireWriter writer(reinterpret_cast<BYTE*>(encoded.data()));
+	if (nickname.empty() == false)
+	{
+		writer.WriteBytesField(TAG_USER_NICKNAME, nickname);
+	}
+	if (userId != 0)
+	{
+		writer.WriteVarintField(TAG_USER_ID, userId);
+	}
+	ASSERT_CRASH(writer.Ptr() == reinterpret_cast<BYTE*>(encoded.data()) + size);
+
+	return encoded;
+}
+
+
+/**
+ * \brief S_CHAT 패킷을 SendBuffer에 바로 쓰는 함수
+ * \details Protocol::S_CHAT의 직렬화와 같은 순서로 쓰며, 기본값인 필드는 생략하고 oneof인 user는 항상 씁니다.
+ * \details 한 청크에 담기지 않는 크기는 User 메시지를 다시 파싱하여 생성된 코드로 직렬화합니다.
+ * \details 닉네임은 C_LOGIN 파싱에서 UTF-8 검사를 거치므로 다시 파싱해도 같은 User가 됩니다.
+ * \param user 보낸 유저의 직렬화된 User 메시지 (EncodeUser)
+ * \param msg 채팅 내용
+ * \param timestamp 보낸 시간
+ * \return 직렬화된 내용이 담긴 버퍼
+ */
+SendBufferRef PacketCodec::MakeBuffer_S_CHAT(string_view user, string_view msg, double timestamp)
+{
+	const uint64_t rawTimestamp = RawDouble(timestamp);
+	const size_t dataSize = WireWriter::BytesFieldSize(user.size()) +
+		(msg.empty() ? 0 : WireWriter::BytesFieldSize(msg.size())) +
+		(rawTimestamp == 0 ? 0 : WireWriter::Fixed64FieldSize());
+
+	if (FitsInChunk(dataSize) == false)
+	{
+		Protocol::S_CHAT pkt;
+		pkt.mutable_user()->ParseFromArray(user.data(), static_cast<int>(user.size()));
+		pkt.set_msg(msg.data(), msg.size());
+		pkt.set_timestamp(timestamp);
+		return PacketHandler::MakeBuffer_S_CHAT(pkt);
+	}
+
+	return WritePacket(Protocol::PACKET_ID_S_CHAT, dataSize, [&](WireWriter& writer)
+	{
+		writer.WriteBytesField(TAG_S_CHAT_USER, user);
+		if (msg.empty() == false)
+		{
+			writer.WriteBytesField(TAG_S_CHAT_MSG, msg);
+		}
+		if (rawTimestamp != 0)
+		{
+			writer.WriteFixed64Field(TAG_S_CHAT_TIMESTAMP, rawTimestamp);
+		}
+	});
+}
+
+
+/**
+ * \brief 닉네임 대신 userId만 담은 S_CHAT 패킷을 SendBuffer에 바로 쓰는 함수
+ * \details 유저 사전을 사용하는 세션에게 보냅니다. oneof인 userId는 필드 번호 순서대로 마지막에 씁니다.
+ * \param userId 보낸 유저 ID
+ * \param msg 채팅 내용
+ * \param timestamp 보낸 시간
+ * \return 직렬화된 내용이 담긴 버퍼
+ */
+SendBufferRef PacketCodec::MakeBuffer_S_CHAT_UserId(unsigned long long userId, string_view msg, double timestamp)
+{
+	const uint64_t rawTimestamp = RawDouble(timestamp);
+	const size_t dataSize = (msg.empty() ? 0 : WireWriter::BytesFieldSize(msg.size())) +
+		(rawTimestamp == 0 ? 0 : WireWriter::Fixed64FieldSize()) + 1 + WireWriter::VarintSize(userId);
+
+	if (FitsInChunk(dataSize) == false)
+	{
+		Protocol::S_CHAT pkt;
+		pkt.set_userid(userId);
+		pkt.set_msg(msg.data(), msg.size());
+		pkt.set_timestamp(timestamp);
+		return PacketHandler::MakeBuffer_S_CHAT(pkt);
+	}
+
+	return WritePacket(Protocol::PACKET_ID_S_CHAT, dataSize, [&](WireWriter& writer)
+	{
+		if (msg.empty() == false)
+		{
+			writer.WriteBytesField(TAG_S_CHAT_MSG, msg);
+		}
+		if (rawTimestamp != 0)
+		{
+			writer.WriteFixed64Field(TAG_S_CHAT_TIMESTAMP, rawTimestamp);
+		}
+		writer.WriteVarintField(TAG_S_CHAT_USER_ID, userId);
+	});
+}
+
+
+/**
+ * \brief 유저 하나를 알리는 S_USER_DICTIONARY 패킷을 SendBuffer에 바로 쓰는 함수
+ * \param user 알릴 유저의 직렬화된 User 메시지 (EncodeUser)
+ * \return 직렬화된 내용이 담긴 버퍼
+ */
+SendBufferRef PacketCodec::MakeBuffer_S_USER_DICTIONARY(string_view user)
+{
+	const size_t dataSize = WireWriter::BytesFieldSize(user.size());
+
+	if (FitsInChunk(dataSize) == false)
+	{
+		Protocol::S_USER_DICTIONARY pkt;
+		pkt.add_users()->ParseFromArray(user.data(), static_cast<int>(user.size()));
+		return PacketHandler::MakeBuffer_S_USER_DICTIONARY(pkt);
+	}
+
+	return WritePacket(Protocol::PACKET_ID_S_USER_DICTIONARY, dataSize, [&](WireWriter& writer)
+	{
+		writer.WriteBytesField(TAG_USER_DICTIONARY_USERS, user);
+	});
+}
+
+
+/**
+ * \brief S_OTHER_ENTER 패킷을 SendBuffer에 바로 쓰는 함수
+ * \param user 입장한 유저의 직렬화된 User 메시지 (EncodeUser)
+ * \param timestamp 입장한 시간
+ * \return 직렬화된 내용이 담긴 버퍼
+ */
+SendBufferRef PacketCodec::MakeBuffer_S_OTHER_ENTER(string_view user, double timestamp)
+{
+	return MakeUserNotice(Protocol::PACKET_ID_S_OTHER_ENTER, user, timestamp, &PacketHandler::MakeBuffer_S_OTHER_ENTER);
+}
+
+
+/**
+ * \brief S_OTHER_LEAVE 패킷을 SendBuffer에 바로 쓰는 함수
+ * \param user 퇴장한 유저의 직렬화된 User 메시지 (EncodeUser)
+ * \param timestamp 퇴장한 시간
+ * \return 직렬화된 내용이 담긴 버퍼
+ */
+SendBufferRef PacketCodec::MakeBuffer_S_OTHER_LEAVE(string_view user, double timestamp)
+{
+	return MakeUserNotice(Protocol::PACKET_ID_S_OTHER_LEAVE, user, timestamp, &PacketHandler::MakeBuffer_S_OTHER_LEAVE);
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <string_view>
+
+/*
+ * 패킷 코덱
+ * 트래픽 대부분을 차지하는 채팅 패킷을 protobuf 생성 코드를 거치지 않고 직접 읽고 씁니다.
+ * 읽고 쓰는 와이어 바이트는 Protocol.pb.cc의 ParseFromArray, SerializeToArray와 같아야 합니다.
+ */
+
+
+/**
+ * \brief C_CHAT 패킷 뷰 구조체
+ * \details 문자열을 복사하지 않고 수신 버퍼를 가리키므로 패킷 처리 함수가 반환된 뒤에는 사용할 수 없습니다.
+ * \details Protocol::C_CHAT::ParseFromArray와 같은 입력을 받아들이고 거부합니다.
+ */
+struct C_CHAT_View
+{
+	bool ParseFromArray(const void* data, int size);
+
+	string_view msg;
+	bool hasUser = false;
+	unsigned long long userId = 0;
+	string_view nickname;
+};
+
+
+/**
+ * \brief PacketCodec 클래스
+ * \details 서버 패킷을 생성된 코드와 바이트 단위로 같게 SendBuffer에 바로 씁니다.
+ * \details 유저 정보는 EncodeUser로 미리 직렬화한 User 메시지를 그대로 붙여 씁니다.
+ */
+class PacketCodec
+{
+public:
+	static string EncodeUser(unsigned long long userId, string_view nickname);
+
+	static SendBufferRef MakeBuffer_S_CHAT(string_view user, string_view msg, double timestamp);
+	static SendBufferRef MakeBuffer_S_CHAT_UserId(unsigned long long userId, string_view msg, double timestamp);
+	static SendBufferRef MakeBuffer_S_USER_DICTIONARY(string_view user);
+	static SendBufferRef MakeBuffer_S_OTHER_ENTER(string_view user, double timestamp);
+	static SendBufferRef MakeBuffer_S_OTHER_LEAVE(string_view user, double timestamp);
+};
@@ -0,0 +1,434 @@
+﻿#include "pch.h"
+#include "PacketCompressor.h"
+#include <cstring>
+
+namespace
+{
+	enum
+	{
+		HASH_LOG = 12,
+		HASH_SIZE = 1 << HASH_LOG,
+		RUN_MASK = 0x0F, // 토큰의 한 쪽 4비트가 담을 수 있는 최대 길이, 넘으면 추가 바이트가 이어짐
+		MAX_PREFIX_SIZE = sizeof(PacketHeaderV2) + sizeof(unsigned int), // 압축한 패킷에서 LZ 블록 앞에 오는 크기
+	};
+
+	/**
+	 * \brief 프리셋 사전
+	 * \details 압축 전 데이터 앞에 놓인 것으로 보고 매치를 찾으므로, 패킷 첫 부분의 반복되는 필드 배치도 매치가 됩니다.
+	 * \details 자주 나오는 내용일수록 뒤쪽에 둡니다. 내용을 바꾸면 PACKET_ID_COMPRESSION도 바꿉니다.
+	 */
+	const BYTE PRESET_DICTIONARY[] =
+		// S_OTHER_ENTER, S_OTHER_LEAVE의 timestamp 태그와 초 단위 시각의 0인 하위 바이트
+		"\x11\x00\x00\x00\x00"
+		// S_CHAT의 timestamp 태그
+		"\x21\x00\x00\x00\x00"
+		// S_ROOM_LIST의 방 항목 (maxUser = 100), 다음 방 항목 시작
+		"\x20\x64\x28\x01\x12\x20\x64\x28\x02\x12\x20\x64\x28\x03\x12\x20\x64\x28\x04\x12"
+		// S_ENTER_ROOM의 roomData 뒤 유저 목록 항목 시작 (users, User.nickname)
+		"\x20\x64\x28\x01\x1a\x0a\x0a\x06\x1a\x0b\x0a\x07\x1a\x0c\x0a\x08\x1a\x09\x0a\x05"
+		// User.id 태그 뒤 다음 유저 항목
+		"\x10\x01\x1a\x0a\x0a\x06\x10\x02\x1a\x0a\x0a\x06";
+
+	constexpr unsigned int DICTIONARY_SIZE = sizeof(PRESET_DICTIONARY) - 1; // 문자열 끝의 0 제외
+
+	thread_local vector<BYTE> LCompressSource; // 프리셋 사전 뒤에 압축할 데이터를 모은 공간
+	thread_local vector<BYTE> LCompressBlock; // 압축한 패킷을 만드는 공간
+
+	unsigned int Read32(const BYTE* p)
+	{
+		unsigned int value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	unsigned int Hash(const BYTE* p)
+	{
+		return (Read32(p) * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	/**
+	 * \brief 프리셋 사전의 위치를 미리 넣은 해시 테이블을 반환하는 함수
+	 * \details 압축할 때마다 이 테이블을 복사하여 시작합니다.
+	 */
+	const array<int, HASH_SIZE>& DictionaryTable()
+	{
+		static const array<int, HASH_SIZE> table = []
+		{
+			array<int, HASH_SIZE> t;
+			t.fill(-1);
+			for (unsigned int i = 0; i + PacketCompressor::MIN_MATCH <= DICTIONARY_SIZE; i++)
+			{
+				t[Hash(&PRESET_DICTIONARY[i])] = static_cast<int>(i);
+			}
+			return t;
+		}();
+		return table;
+	}
+
+	/**
+	 * \brief 토큰 4비트를 넘는 길이를 255 단위의 추가 바이트로 쓰는 함수
+	 * \return 다음으로 쓸 위치
+	 */
+	BYTE* WriteLength(BYTE* dst, unsigned int length)
+	{
+		for (; length >= 0xFF; length -= 0xFF)
+		{
+			*dst++ = 0xFF;
+		}
+		*dst++ = static_cast<BYTE>(length);
+		return dst;
+	}
+
+	/**
+	 * \brief 토큰 4비트에 이어지는 추가 바이트를 읽는 함수
+	 * \param length 토큰에서 읽은 길이, 추가 바이트를 더함
+	 * \param limit 넘으면 실패로 볼 길이
+	 * \return 정상적으로 읽었는지 여부
+	 */
+	bool ReadLength(const BYTE*& src, const BYTE* srcEnd, unsigned int& length, unsigned int limit)
+	{
+		BYTE value;
+		do
+		{
+			if (src >= srcEnd)
+			{
+				return false;
+			}
+			value = *src++;
+			length += value;
+			if (length > limit)
+			{
+				return false;
+			}
+		}
+		while (value == 0xFF);
+		return true;
+	}
+}
+
+
+/**
+ * \brief 패킷을 압축할지 정하는 함수
+ * \param sendBuffer 보낼 패킷, 체인이라면 첫 버퍼
+ * \return 기준 크기 이상이고 아직 압축하지 않은 패킷인지 여부
+ */
+bool PacketCompressor::ShouldCompress(const SendBufferRef& sendBuffer)
+{
+	if (sendBuffer->PacketSize() < COMPRESS_THRESHOLD)
+	{
+		return false;
+	}
+
+	auto header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
+	return (header->id & PACKET_ID_COMPRESSED_FLAG) == 0;
+}
+
+
+/**
+ * \brief 패킷을 압축한 새 버퍼를 만드는 함수
+ * \details 체인은 연속된 공간에 모아 압축하며, 압축한 패킷이 한 청크를 넘으면 다시 체인에 담습니다.
+ * \param sendBuffer 압축할 패킷, 체인이라면 첫 버퍼
+ * \return 압축한 패킷, 원본보다 작아지지 않는다면 nullptr
+ */
+SendBufferRef PacketCompressor::Compress(const SendBufferRef& sendBuffer)
+{
+	const unsigned int packetSize = sendBuffer->PacketSize();
+	auto header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
+	const unsigned short id = header->id;
+	const unsigned int headerSize = header->size == 0 ? sizeof(PacketHeaderV2) : sizeof(PacketHeader);
+	const unsigned int dataSize = packetSize - headerSize;
+
+	// 프리셋 사전 뒤에 헤더를 뺀 데이터를 이어 붙임
+	vector<BYTE>& source = LCompressSource;
+	source.resize(DICTIONARY_SIZE + dataSize);
+	memcpy(source.data(), PRESET_DICTIONARY, DICTIONARY_SIZE);
+
+	BYTE* write = source.data() + DICTIONARY_SIZE;
+	unsigned int skip = headerSize;
+	for (SendBuffer* segment = sendBuffer.get(); segment != nullptr; segment = segment->Next())
+	{
+		const unsigned int skipped = min(skip, segment->WriteSize());
+		memcpy(write, segment->Buffer() + skipped, segment->WriteSize() - skipped);
+		write += segment->WriteSize() - skipped;
+		skip -= skipped;
+	}
+
+	vector<BYTE>& block = LCompressBlock;
+	block.resize(MAX_PREFIX_SIZE + CompressBound(dataSize));
+	const unsigned int blockSize = CompressSource(source.data(), dataSize, block.data() + MAX_PREFIX_SIZE);
+
+	unsigned int compressedSize = sizeof(PacketHeader) + sizeof(unsigned int) + blockSize;
+	if (compressedSize > numeric_limits<decltype(PacketHeader::size)>::max())
+	{
+		compressedSize += sizeof(PacketHeaderV2) - sizeof(PacketHeader);
+	}
+
+	if (compressedSize >= packetSize)
+	{
+		return nullptr;
+	}
+
+	// 블록 바로 앞에 헤더와 원본 데이터 크기를 씀
+	BYTE* packet = block.data() + MAX_PREFIX_SIZE + blockSize - compressedSize;
+	const unsigned short compressedId = id | PACKET_ID_COMPRESSED_FLAG;
+	if (compressedSize <= numeric_limits<decltype(PacketHeader::size)>::max())
+	{
+		PacketHeader compressedHeader = {static_cast<unsigned short>(compressedSize), compressedId};
+		memcpy(packet, &compressedHeader, sizeof(compressedHeader));
+		memcpy(packet + sizeof(compressedHeader), &dataSize, sizeof(dataSize));
+	}
+	else
+	{
+		PacketHeaderV2 compressedHeader = {0, compressedId, compressedSize};
+		memcpy(packet, &compressedHeader, sizeof(compressedHeader));
+		memcpy(packet + sizeof(compressedHeader), &dataSize, sizeof(dataSize));
+	}
+
+	if (compressedSize <= SendBufferManager::MAX_BUFFER_SIZE)
+	{
+		SendBufferRef compressed = GSendBufferManager->Open(compressedSize);
+		memcpy(compressed->Buffer(), packet, compressedSize);
+		compressed->Close(compressedSize);
+		return compressed;
+	}
+
+	// 체인의 버퍼들은 이미 크기가 정해져 있으므로 차례로 채움
+	SendBufferRef compressed = GSendBufferManager->OpenChain(compressedSize);
+	for (SendBuffer* segment = compressed.get(); segment != nullptr; segment = segment->Next())
+	{
+		memcpy(segment->Buffer(), packet, segment->WriteSize());
+		packet += segment->WriteSize();
+	}
+	return compressed;
+}
+
+
+/**
+ * \brief 데이터를 LZ 블록으로 압축하는 함수
+ * \param src 압축할 데이터
+ * \param srcSize 압축할 데이터 크기
+ * \param dst 블록을 쓸 공간, CompressBound(srcSize) 바이트 이상
+ * \return 블록 크기
+ */
+unsigned int PacketCompressor::CompressBlock(const BYTE* src, unsigned int srcSize, BYTE* dst)
+{
+	vector<BYTE>& source = LCompressSource;
+	source.resize(DICTIONARY_SIZE + srcSize);
+	memcpy(source.data(), PRESET_DICTIONARY, DICTIONARY_SIZE);
+	copy_n(src, srcSize, source.data() + DICTIONARY_SIZE);
+	return CompressSource(source.data(), srcSize, dst);
+}
+
+
+/**
+ * \brief 프리셋 사전의 크기를 반환하는 함수
+ * \details 블록의 오프셋은 풀린 크기에 이 크기를 더한 만큼까지 거슬러 올라갈 수 있습니다.
+ * \return 프리셋 사전의 바이트 수
+ */
+unsigned int PacketCompressor::PresetDictionarySize()
+{
+	return DICTIONARY_SIZE;
+}
+
+
+/**
+ * \brief LZ 블록을 푸는 함수
+ * \details 받은 데이터이므로 모든 길이와 오프셋을 확인하며, 풀린 크기가 dstSize와 정확히 같아야 성공합니다.
+ * \param src LZ 블록
+ * \param srcSize LZ 블록 크기
+ * \param dst 풀 공간
+ * \param dstSize 원본 데이터 크기
+ * \return 정상적으로 풀었는지 여부
+ */
+bool PacketCompressor::Decompress(const BYTE* src, unsigned int srcSize, BYTE* dst, unsigned int dstSize)
+{
+	const BYTE* srcEnd = src + srcSize;
+	unsigned int written = 0;
+
+	while (true)
+	{
+		if (src >= srcEnd)
+		{
+			return false;
+		}
+		const BYTE token = *src++;
+
+		// 리터럴
+		unsigned int literalLength = token >> 4;
+		if (literalLength == RUN_MASK && ReadLength(src, srcEnd, literalLength, dstSize) == false)
+		{
+			return false;
+		}
+		if (literalLength > static_cast<unsigned int>(srcEnd - src) || literalLength > dstSize - written)
+		{
+			return false;
+		}
+		memcpy(dst + written, src, literalLength);
+		src += literalLength;
+		written += literalLength;
+
+		// 마지막 시퀀스
+		if (src == srcEnd)
+		{
+			return written == dstSize;
+		}
+
+		// 매치
+		if (srcEnd - src < 2)
+		{
+			return false;
+		}
+		const unsigned int offset = src[0] | (src[1] << 8);
+		src += 2;
+		if (offset == 0 || offset > written + DICTIONARY_SIZE)
+		{
+			return false;
+		}
+
+		unsigned int matchLength = token & RUN_MASK;
+		if (matchLength == RUN_MASK && ReadLength(src, srcEnd, matchLength, dstSize) == false)
+		{
+			return false;
+		}
+		matchLength += MIN_MATCH;
+		if (matchLength > dstSize - written)
+		{
+			return false;
+		}
+
+		// 프리셋 사전에서 시작하는 매치는 사전의 끝까지 먼저 복사
+		if (offset > written)
+		{
+			const unsigned int dictionaryPos = DICTIONARY_SIZE - (offset - written);
+			const unsigned int copySize = min(matchLength, DICTIONARY_SIZE - dictionaryPos);
+			memcpy(dst + written, &PRESET_DICTIONARY[dictionaryPos], copySize);
+			written += copySize;
+			matchLength -= copySize;
+			if (matchLength == 0)
+			{
+				continue;
+			}
+		}
+
+		// 겹치는 매치는 앞에서 쓴 바이트를 다시 읽으므로 한 바이트씩 복사
+		if (matchLength <= offset)
+		{
+			memcpy(dst + written, dst + written - offset, matchLength);
+		}
+		else
+		{
+			for (unsigned int i = 0; i < matchLength; i++)
+			{
+				dst[written + i] = dst[written + i - offset];
+			}
+		}
+		written += matchLength;
+	}
+}
+
+
+/**
+ * \brief 프리셋 사전 뒤에 이어 놓은 데이터를 LZ 블록으로 압축하는 함수
+ * \details 해시 테이블에 위치 하나만 기억하는 탐욕적 매치로 속도를 우선합니다.
+ * \param base 프리셋 사전과 압축할 데이터가 이어진 공간
+ * \param dataSize 압축할 데이터 크기
+ * \param dst 블록을 쓸 공간, CompressBound(dataSize) 바이트 이상
+ * \return 블록 크기
+ */
+unsigned int PacketCompressor::CompressSource(const BYTE* base, unsigned int dataSize, BYTE* dst)
+{
+	const unsigned int begin = DICTIONARY_SIZE;
+	const unsigned int end = DICTIONARY_SIZE + dataSize;
+
+	array<int, HASH_SIZE> table = DictionaryTable();
+	BYTE* const dstBegin = dst;
+
+	unsigned int anchor = begin; // 아직 쓰지 않은 리터럴의 시작
+	unsigned int pos = begin;
+	while (pos + MIN_MATCH <= end)
+	{
+		const unsigned int hash = Hash(base + pos);
+		const int candidate = table[hash];
+		table[hash] = static_cast<int>(pos);
+
+		if (candidate < 0 || pos - static_cast<unsigned int>(candidate) > MAX_OFFSET ||
+			Read32(base + candidate) != Read32(base + pos))
+		{
+			pos++;
+			continue;
+		}
+
+		unsigned int matchLength = MIN_MATCH;
+		while (pos + matchLength < end && base[candidate + matchLength] == base[pos + matchLength])
+		{
+			matchLength++;
+		}
+
+		// 시퀀스 쓰기
+		const unsigned int literalLength = pos - anchor;
+		BYTE* token = dst++;
+		*token = static_cast<BYTE>((min<unsigned int>(literalLength, RUN_MASK) << 4) |
+			min<unsigned int>(matchLength - MIN_MATCH, RUN_MASK));
+		if (literalLength >= RUN_MASK)
+		{
+			dst = WriteLength(dst, literalLength - RUN_MASK);
+		}
+		memcpy(dst, base + anchor, literalLength);
+		dst += literalLength;
+
+		const unsigned int offset = pos - candidate;
+		*dst++ = static_cast<BYTE>(offset);
+		*dst++ = static_cast<BYTE>(offset >> 8);
+		if (matchLength - MIN_MATCH >= RUN_MASK)
+		{
+			dst = WriteLength(dst, matchLength - MIN_MATCH - RUN_MASK);
+		}
+
+		pos += matchLength;
+		anchor = pos;
+
+		// 매치 끝 바로 앞 위치도 기억하여 이어지는 반복을 찾음
+		if (pos - 2 >= begin && pos - 2 + MIN_MATCH <= end)
+		{
+			table[Hash(base + pos - 2)] = static_cast<int>(pos - 2);
+		}
+	}
+
+	// 남은 리터럴로 마지막 시퀀스
+	const unsigned int literalLength = end - anchor;
+	*dst++ = static_cast<BYTE>(min<unsigned int>(literalLength, RUN_MASK) << 4);
+	if (literalLength >= RUN_MASK)
+	{
+		dst = WriteLength(dst, literalLength - RUN_MASK);
+	}
+	memcpy(dst, base + anchor, literalLength);
+	dst += literalLength;
+
+	return static_cast<unsigned int>(dst - dstBegin);
+}
+
+
+/**
+ * \brief 세션에게 보낼 버퍼를 반환하는 함수
+ * \details 압축을 협상한 세션이 처음 요청할 때 압축본을 만들고, 작아지지 않는다면 원본을 보냅니다.
+ * \param session 받을 세션
+ * \return 보낼 버퍼
+ */
+const SendBufferRef& BroadcastBuffer::For(Session& session)
+{
+	if (session.UseCompression() == false || _sendBuffer == nullptr)
+	{
+		return _sendBuffer;
+	}
+
+	if (_compressTried == false)
+	{
+		_compressTried = true;
+		if (PacketCompressor::ShouldCompress(_sendBuffer))
+		{
+			_compressed = PacketCompressor::Compress(_sendBuffer);
+		}
+	}
+
+	return _compressed != nullptr ? _compressed : _sendBuffer;
+}
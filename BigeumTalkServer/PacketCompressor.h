@@ -0,0 +1,65 @@
+﻿#pragma once
+
+/*
+ * 패킷 압축
+ * 압축을 협상한 연결에 한해 기준 크기 이상의 패킷을 LZ 블록으로 압축하여 주고받습니다.
+ * 압축한 패킷은 헤더 id에 PACKET_ID_COMPRESSED_FLAG를 켜고, 헤더 뒤에 [원본 데이터 크기 4바이트][LZ 블록]을 담습니다.
+ * 헤더는 압축한 패킷의 크기에 따라 PacketHeader 또는 PacketHeaderV2를 사용합니다.
+ *
+ * LZ 블록 형식 (LZ4 블록과 같은 구조)
+ *   시퀀스 = [토큰][리터럴 길이 추가 바이트][리터럴][오프셋 2바이트][매치 길이 추가 바이트]
+ *   토큰의 상위 4비트는 리터럴 길이, 하위 4비트는 매치 길이 - 4, 15라면 255 미만의 바이트가 나올 때까지 더함
+ *   마지막 시퀀스는 리터럴만 담고 끝나며, 오프셋은 프리셋 사전까지 거슬러 올라갈 수 있음
+ */
+
+
+/**
+ * \brief PacketCompressor 클래스
+ * \details 패킷 데이터를 프리셋 사전을 앞에 둔 LZ 블록으로 압축하고 풉니다.
+ * \details 프리셋 사전을 바꾸면 상대와 풀 수 없으므로 PACKET_ID_COMPRESSION도 함께 바꾸어 협상해야 합니다.
+ */
+class PacketCompressor
+{
+public:
+	enum
+	{
+		COMPRESS_THRESHOLD = 0x200, // 이 크기 이상의 패킷만 압축
+		MIN_MATCH = 4,
+		MAX_OFFSET = 0xFFFF,
+	};
+
+	static bool ShouldCompress(const SendBufferRef& sendBuffer);
+	static SendBufferRef Compress(const SendBufferRef& sendBuffer);
+	static unsigned int CompressBlock(const BYTE* src, unsigned int srcSize, BYTE* dst);
+	static bool Decompress(const BYTE* src, unsigned int srcSize, BYTE* dst, unsigned int dstSize);
+	static unsigned int PresetDictionarySize();
+
+	/** \brief 압축한 LZ 블록의 최대 크기를 반환하는 함수 \details 리터럴만으로 이루어진 블록의 크기에 여유를 더함 */
+	static unsigned int CompressBound(unsigned int size) { return size + size / 0xFF + 16; }
+
+private:
+	static unsigned int CompressSource(const BYTE* base, unsigned int dataSize, BYTE* dst);
+};
+
+
+/**
+ * \brief BroadcastBuffer 클래스
+ * \details 여러 세션에 같은 패킷을 보낼 때 압축을 협상한 세션들을 위한 압축본을 한번만 만듭니다.
+ */
+class BroadcastBuffer
+{
+public:
+	explicit BroadcastBuffer(SendBufferRef sendBuffer) : _sendBuffer(move(sendBuffer))
+	{
+	}
+
+	const SendBufferRef& For(Session& session);
+
+	/** \brief 압축하지 않은 원본 버퍼를 반환하는 함수 \return _sendBuffer */
+	const SendBufferRef& Original() { return _sendBuffer; }
+
+private:
+	SendBufferRef _sendBuffer;
+	SendBufferRef _compressed = nullptr;
+	bool _compressTried = false;
+};
@@ -1,11 +1,177 @@
 ﻿#include "pch.h"
 #include "PacketHandler.h"
+#include "PacketCompressor.h"
 #include "User.h"
 #include "Room.h"
 #include "Service.h"
 #include <chrono>
 
-unordered_map<unsigned short, PacketHandlerFunc> GPacketHandler;
+namespace
+{
+	/**
+	 * \brief PacketArena 구조체
+	 * \details 도착한 패킷을 파싱할 쓰레드별 Arena 입니다.
+	 * \details 첫 블록으로 고정 공간을 주어 Reset 후에도 남아있으므로, 보통 크기의 패킷은 파싱할 때 메모리를 할당하지 않습니다.
+	 */
+	struct PacketArena
+	{
+		enum
+		{
+			INITIAL_BLOCK_SIZE = 0x10000,
+		};
+
+		PacketArena() : arena(block, INITIAL_BLOCK_SIZE)
+		{
+		}
+
+		alignas(8) char block[INITIAL_BLOCK_SIZE];
+		google::protobuf::Arena arena;
+	};
+
+	thread_local PacketArena LPacketArena; // 디스패치 쓰레드별 패킷 Arena
+
+	enum
+	{
+		DECOMPRESS_KEEP_SIZE = 0x10000, // 이 크기를 넘게 늘어난 압축 해제 공간은 사용 후 해제
+	};
+
+	thread_local vector<BYTE> LDecompressBuffer; // 압축한 패킷을 풀어 헤더와 함께 담는 공간
+}
+
+
+/**
+ * \brief 쓰레드의 패킷 Arena를 반환하는 함수 \return 현재 쓰레드의 Arena
+ */
+google::protobuf::Arena* PacketHandler::Arena()
+{
+	return &LPacketArena.arena;
+}
+
+
+/**
+ * \brief 쓰레드의 패킷 Arena를 비우는 함수
+ * \details 완료 패킷 묶음을 처리한 뒤 디스패치 쓰레드에서 호출합니다. 첫 블록 외의 블록은 해제됩니다.
+ */
+void PacketHandler::ResetArena()
+{
+	LPacketArena.arena.Reset();
+}
+
+
+/**
+ * \brief 압축한 패킷을 풀어 처리하는 함수
+ * \details 압축을 협상한 세션의 패킷만 풀며, 풀린 패킷은 압축 표시를 뺀 헤더를 붙여 다시 HandlePacket으로 처리합니다.
+ * \details 풀린 크기가 세션이 받을 수 있는 패킷 크기를 넘으면 메모리를 잡기 전에 거부합니다.
+ * \param session 패킷을 Recv한 Session
+ * \param buffer 압축한 패킷
+ * \param len 압축한 패킷의 길이
+ * \return 정상 처리 여부
+ */
+bool PacketHandler::HandleCompressedPacket(shared_ptr<Session>& session, BYTE* buffer, int len)
+{
+	if (session->UseCompression() == false)
+	{
+		return false;
+	}
+
+	const unsigned int headerSize = reinterpret_cast<PacketHeader*>(buffer)->size == 0 ? sizeof(PacketHeaderV2) : sizeof(PacketHeader);
+	if (static_cast<unsigned int>(len) < headerSize + sizeof(unsigned int))
+	{
+		return false;
+	}
+
+	const unsigned short id = reinterpret_cast<PacketHeader*>(buffer)->id & ~PACKET_ID_COMPRESSED_FLAG;
+	unsigned int dataSize;
+	memcpy(&dataSize, buffer + headerSize, sizeof(dataSize));
+
+	// 풀린 패킷도 원래 받을 수 있는 크기여야 함
+	unsigned int packetSize = sizeof(PacketHeader) + dataSize;
+	if (packetSize > numeric_limits<decltype(PacketHeader::size)>::max())
+	{
+		packetSize = sizeof(PacketHeaderV2) + dataSize;
+	}
+	if (dataSize > session->GetMaxPacketSize() || packetSize > session->GetMaxPacketSize())
+	{
+		return false;
+	}
+
+	vector<BYTE>& packet = LDecompressBuffer;
+	packet.resize(packetSize);
+	if (packetSize <= numeric_limits<decltype(PacketHeader::size)>::max())
+	{
+		auto header = reinterpret_cast<PacketHeader*>(packet.data());
+		header->size = static_cast<unsigned short>(packetSize);
+		header->id = id;
+	}
+	else
+	{
+		auto header = reinterpret_cast<PacketHeaderV2*>(packet.data());
+		header->mark = 0;
+		header->id = id;
+		header->size = packetSize;
+	}
+
+	const unsigned int blockOffset = headerSize + sizeof(unsigned int);
+	bool handled = PacketCompressor::Decompress(buffer + blockOffset, len - blockOffset,
+	                                            packet.data() + (packetSize - dataSize), dataSize);
+	if (handled)
+	{
+		handled = HandlePacket(session, packet.data(), static_cast<int>(packetSize));
+	}
+
+	// 큰 패킷의 메모리를 잡아두지 않도록 해제
+	if (packet.capacity() > DECOMPRESS_KEEP_SIZE)
+	{
+		vector<BYTE>().swap(packet);
+	}
+
+	return handled;
+}
+
+
+SendBufferOutputStream::SendBufferOutputStream(SendBuffer* sendBuffer, unsigned offset)
+	: _segment(sendBuffer), _offset(offset)
+{
+}
+
+
+/**
+ * \brief 다음으로 쓸 공간을 넘겨주는 함수
+ * \details 현재 버퍼를 모두 넘겨주었다면 체인의 다음 버퍼로 넘어갑니다.
+ * \param data 쓸 공간의 시작 주소
+ * \param size 쓸 공간의 크기
+ * \return 넘겨줄 공간이 남았는지 여부
+ */
+bool SendBufferOutputStream::Next(void** data, int* size)
+{
+	while (_segment != nullptr && _offset >= _segment->WriteSize())
+	{
+		_segment = _segment->Next();
+		_offset = 0;
+	}
+
+	if (_segment == nullptr)
+	{
+		return false;
+	}
+
+	*data = _segment->Buffer() + _offset;
+	*size = static_cast<int>(_segment->WriteSize() - _offset);
+	_offset = _segment->WriteSize();
+	_byteCount += *size;
+	return true;
+}
+
+
+/**
+ * \brief 마지막으로 넘겨준 공간 중 쓰지 않은 뒷부분을 돌려받는 함수
+ * \param count 돌려받을 크기
+ */
+void SendBufferOutputStream::BackUp(int count)
+{
+	_offset -= count;
+	_byteCount -= count;
+}
 
 bool Handle_C_LOGIN(shared_ptr<Session>& session, Protocol::C_LOGIN& pkt)
 {
@@ -17,7 +183,7 @@ bool Handle_C_LOGIN(shared_ptr<Session>& session, Protocol::C_LOGIN& pkt)
 	{
 		sPkt.set_success(false);
 
-		shared_ptr<SendBuffer> sendBuffer = PacketHandler::MakeBuffer_S_LOGIN(sPkt);
+		SendBufferRef sendBuffer = PacketHandler::MakeBuffer_S_LOGIN(sPkt);
 		session->Send(sendBuffer);
 
 		return true;
@@ -30,6 +196,7 @@ bool Handle_C_LOGIN(shared_ptr<Session>& session, Protocol::C_LOGIN& pkt)
 	auto userRef = make_shared<User>();
 	userRef->userId = idGenerator.fetch_add(1);
 	userRef->nickname = pkt.user().nickname();
+	userRef->encodedUser = PacketCodec::EncodeUser(userRef->userId, userRef->nickname);
 	userRef->ownerSession = session;
 
 	session->_user = userRef;
@@ -38,11 +205,23 @@ bool Handle_C_LOGIN(shared_ptr<Session>& session, Protocol::C_LOGIN& pkt)
 	cout << "[USER LOGIN] " << '[' << userRef->userId << "] " << userRef->nickname << endl;
 #endif
 
+	// 유저 사전 사용 요청 수락, 자신의 ID와 닉네임은 이미 알고 있음
+	if (pkt.userdictionary())
+	{
+		session->EnableUserDictionary();
+		sPkt.set_userdictionary(true);
+	}
+
 	sPkt.set_success(true);
 	sPkt.set_userid(userRef->userId);
-	shared_ptr<SendBuffer> sendBuffer = PacketHandler::MakeBuffer_S_LOGIN(sPkt);
+	SendBufferRef sendBuffer = PacketHandler::MakeBuffer_S_LOGIN(sPkt);
 	session->Send(sendBuffer);
 
+	if (session->UseUserDictionary())
+	{
+		session->LearnUser(userRef->userId);
+	}
+
 	return true;
 }
 
@@ -93,7 +272,7 @@ bool Handle_C_ENTER_ROOM(shared_ptr<Session>& session, Protocol::C_ENTER_ROOM& p
 	{
 		sPkt.set_success(false);
 
-		shared_ptr<SendBuffer> sendBuffer = PacketHandler::MakeBuffer_S_ENTER_ROOM(sPkt);
+		SendBufferRef sendBuffer = PacketHandler::MakeBuffer_S_ENTER_ROOM(sPkt);
 		session->Send(sendBuffer);
 		return true;
 	}
@@ -116,12 +295,20 @@ bool Handle_C_ENTER_ROOM(shared_ptr<Session>& session, Protocol::C_ENTER_ROOM& p
 		roomUser->set_id(user.first);
 		roomUser->set_nickname(user.second);
 	}
-	sPkt.set_allocated_roomdata(roomPkt);
 
-	shared_ptr<SendBuffer> sendBuffer = PacketHandler::MakeBuffer_S_ENTER_ROOM(sPkt);
+	SendBufferRef sendBuffer = PacketHandler::MakeBuffer_S_ENTER_ROOM(sPkt);
 	session->Send(sendBuffer);
 	sendBuffer = nullptr;
 
+	// 입장 패킷으로 받은 유저 목록은 유저 사전에 등록, 입장 패킷을 Send한 뒤에 기록해야 채팅이 먼저 가지 않음
+	if (session->UseUserDictionary())
+	{
+		for (auto& user : roomUsers)
+		{
+			session->LearnUser(user.first);
+		}
+	}
+
 	return true;
 }
 
@@ -161,11 +348,19 @@ bool Handle_C_ROOM_LIST(shared_ptr<Session>& session, Protocol::C_ROOM_LIST& pkt
 		roomPkt->set_usercount(room.userCount);
 	}
 
+	auto sendBuffer = PacketHandler::MakeBuffer_S_ROOM_LIST(sPkt);
+	session->Send(sendBuffer);
+
 	return true;
 }
 
-bool Handle_C_CHAT(shared_ptr<Session>& session, Protocol::C_CHAT& pkt)
+bool Handle_C_CHAT(shared_ptr<Session>& session, C_CHAT_View& pkt)
 {
+	if (session->_user == nullptr)
+	{
+		return false;
+	}
+
 	auto room = session->_user->room;
 	if (room == nullptr)
 	{
@@ -174,17 +369,10 @@ bool Handle_C_CHAT(shared_ptr<Session>& session, Protocol::C_CHAT& pkt)
 		return false;
 	}
 
-	Protocol::S_CHAT sPkt;
-	Protocol::User user;
-	user.set_id(session->_user->userId);
-	user.set_nickname(session->_user->nickname);
-	sPkt.set_allocated_user(&user);
-	sPkt.set_msg(pkt.msg());
-	sPkt.set_timestamp(std::chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).
-		count());
-
-	shared_ptr<SendBuffer> sendBuffer = PacketHandler::MakeBuffer_S_CHAT(sPkt);
-	room->Broadcast(sendBuffer);
+	// 받은 메시지를 복사하지 않고 수신 버퍼에서 바로 S_CHAT을 씀
+	const double timestamp = static_cast<double>(chrono::duration_cast<chrono::seconds>(
+		chrono::system_clock::now().time_since_epoch()).count());
+	room->BroadcastChat(session->_user, pkt.msg, timestamp);
 
 	return true;
 }
@@ -1,135 +1,65 @@
 ﻿#pragma once
 #include "Protocol.pb.h"
-
-// TODO 자동화
-
-class Session;
-using PacketHandlerFunc = std::function<bool(shared_ptr<Session>&, BYTE*, int)>;
-extern unordered_map<unsigned short, PacketHandlerFunc> GPacketHandler;
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/zero_copy_stream.h>
 
 /*
  * Handle_C_ 함수 정책
  * 비 정상적인 패킷에 한해서 false 반환
+ *
+ * 패킷 처리 함수 선언, 디스패치 테이블 항목, MakeBuffer_S_ 함수는 GenPackets.h에 생성됩니다.
+ * Protocol.proto에 패킷을 추가한 뒤 Protobuf/GenProtocol.bat (또는 GenProtocol.sh)을 실행하고 Handle_C_ 함수를 정의합니다.
  */
+#include "PacketCodec.h"
+#include "GenPackets.h"
 
-bool Handle_C_LOGIN(shared_ptr<Session>& session, Protocol::C_LOGIN& pkt);
-bool Handle_C_CREATE_ROOM(shared_ptr<Session>& session, Protocol::C_CREATE_ROOM& pkt);
-bool Handle_C_ENTER_ROOM(shared_ptr<Session>& session, Protocol::C_ENTER_ROOM& pkt);
-bool Handle_C_LEAVE_ROOM(shared_ptr<Session>& session, Protocol::C_LEAVE_ROOM& pkt);
-bool Handle_C_ROOM_LIST(shared_ptr<Session>& session, Protocol::C_ROOM_LIST& pkt);
-bool Handle_C_CHAT(shared_ptr<Session>& session, Protocol::C_CHAT& pkt);
+class Session;
+using PacketHandlerFunc = bool(*)(shared_ptr<Session>&, BYTE*, int);
 
 /**
- * \brief ServerPacketHandler 클래스
- * \details 서버에 도착한 패킷을 처리하고 클라이언트에게 보낼 데이터를 생성합니다.
+ * \brief SendBufferOutputStream 클래스
+ * \details SendBuffer 체인의 버퍼를 차례로 protobuf 직렬화에 넘겨주는 출력 스트림입니다.
  */
-class PacketHandler
+class SendBufferOutputStream : public google::protobuf::io::ZeroCopyOutputStream
 {
 public:
-	/**
-	 * \brief 정의한 패킷 처리 함수를 초기화하는 함수
-	 */
-	static void Init()
-	{
-		GPacketHandler.emplace(Protocol::PACKET_ID_C_LOGIN,
-		                       [](shared_ptr<Session>& session, BYTE* buffer, int len) -> bool
-		                       {
-			                       return HandlePacketTemplate<Protocol::C_LOGIN>(Handle_C_LOGIN, session, buffer, len);
-		                       });
-
-		GPacketHandler.emplace(Protocol::PACKET_ID_C_CREATE_ROOM,
-		                       [](shared_ptr<Session>& session, BYTE* buffer, int len) -> bool
-		                       {
-			                       return HandlePacketTemplate<Protocol::C_CREATE_ROOM>(
-				                       Handle_C_CREATE_ROOM, session, buffer, len);
-		                       });
-
-		GPacketHandler.emplace(Protocol::PACKET_ID_C_ENTER_ROOM,
-		                       [](shared_ptr<Session>& session, BYTE* buffer, int len) -> bool
-		                       {
-			                       return HandlePacketTemplate<Protocol::C_ENTER_ROOM>(
-				                       Handle_C_ENTER_ROOM, session, buffer, len);
-		                       });
-
-		GPacketHandler.emplace(Protocol::PACKET_ID_C_LEAVE_ROOM,
-		                       [](shared_ptr<Session>& session, BYTE* buffer, int len) -> bool
-		                       {
-			                       return HandlePacketTemplate<Protocol::C_LEAVE_ROOM>(
-				                       Handle_C_LEAVE_ROOM, session, buffer, len);
-		                       });
-
-		GPacketHandler.emplace(Protocol::PACKET_ID_C_ROOM_LIST,
-		                       [](shared_ptr<Session>& session, BYTE* buffer, int len) -> bool
-		                       {
-			                       return HandlePacketTemplate<Protocol::C_ROOM_LIST>(
-				                       Handle_C_ROOM_LIST, session, buffer, len);
-		                       });
-
-		GPacketHandler.emplace(Protocol::PACKET_ID_C_CHAT,
-		                       [](shared_ptr<Session>& session, BYTE* buffer, int len) -> bool
-		                       {
-			                       return HandlePacketTemplate<Protocol::C_CHAT>(Handle_C_CHAT, session, buffer, len);
-		                       });
-	}
-
-
-	/**
-	 * \brief 도착한 패킷을 처리하는 함수
-	 * \param session 패킷을 Recv한 Session
-	 * \param buffer Session의 Buffer
-	 * \param len 패킷의 길이
-	 * \return 정상 처리 여부
-	 */
-	static bool HandlePacket(shared_ptr<Session>& session, BYTE* buffer, int len)
-	{
-		auto header = reinterpret_cast<PacketHeader*>(buffer);
-		auto handler = GPacketHandler.find(header->id);
-		if (handler == GPacketHandler.end())
-		{
-			return false;
-		}
-		return handler->second(session, buffer, len);
-	}
+	SendBufferOutputStream(SendBuffer* sendBuffer, unsigned int offset);
 
-	static shared_ptr<SendBuffer> MakeBuffer_S_LOGIN(Protocol::S_LOGIN& pkt)
-	{
-		return MakeSendBuffer(pkt, Protocol::PACKET_ID_S_LOGIN);
-	}
+	bool Next(void** data, int* size) override;
+	void BackUp(int count) override;
+	int64_t ByteCount() const override { return _byteCount; }
 
-	static shared_ptr<SendBuffer> MakeBuffer_S_CREATE_ROOM(Protocol::S_CREATE_ROOM& pkt)
-	{
-		return MakeSendBuffer(pkt, Protocol::PACKET_ID_S_CREATE_ROOM);
-	}
-
-	static shared_ptr<SendBuffer> MakeBuffer_S_ENTER_ROOM(Protocol::S_ENTER_ROOM& pkt)
-	{
-		return MakeSendBuffer(pkt, Protocol::PACKET_ID_S_ENTER_ROOM);
-	}
+private:
+	SendBuffer* _segment; // 쓰고 있는 체인의 버퍼
+	unsigned int _offset; // _segment에서 넘겨준 위치
+	int64_t _byteCount = 0;
+};
 
-	static shared_ptr<SendBuffer> MakeBuffer_S_LEAVE_ROOM(Protocol::S_LEAVE_ROOM& pkt)
-	{
-		return MakeSendBuffer(pkt, Protocol::PACKET_ID_S_LEAVE_ROOM);
-	}
 
-	static shared_ptr<SendBuffer> MakeBuffer_S_CHAT(Protocol::S_CHAT& pkt)
-	{
-		return MakeSendBuffer(pkt, Protocol::PACKET_ID_S_CHAT);
-	}
+/**
+ * \brief ServerPacketHandler 클래스
+ * \details 서버에 도착한 패킷을 처리하고 클라이언트에게 보낼 데이터를 생성합니다.
+ */
+class PacketHandler : public GenPacketMaker<PacketHandler>
+{
+public:
+	static bool HandlePacket(shared_ptr<Session>& session, BYTE* buffer, int len);
+	static void ResetArena();
 
-	static shared_ptr<SendBuffer> MakeBuffer_S_OTHER_ENTER(Protocol::S_OTHER_ENTER& pkt)
-	{
-		return MakeSendBuffer(pkt, Protocol::PACKET_ID_S_OTHER_ENTER);
-	}
+private:
+	template <unsigned short, typename, auto>
+	friend struct PacketHandlerEntry;
+	friend class GenPacketMaker<PacketHandler>;
 
-	static shared_ptr<SendBuffer> MakeBuffer_S_OTHER_LEAVE(Protocol::S_OTHER_LEAVE& pkt)
-	{
-		return MakeSendBuffer(pkt, Protocol::PACKET_ID_S_OTHER_LEAVE);
-	}
+	static google::protobuf::Arena* Arena();
+	static bool HandleCompressedPacket(shared_ptr<Session>& session, BYTE* buffer, int len);
 
-private:
 	/**
-	 * \brief Init을 통해 map에 정의한 패킷 처리 함수를 등록
-	 * \tparam PacketType 정의한 패킷
+	 * \brief 패킷을 파싱하여 정의한 패킷 처리 함수에 넘기는 함수
+	 * \details 패킷 객체는 쓰레드의 Arena에 만들어지며 완료 패킷 묶음을 처리한 뒤 ResetArena로 한번에 해제됩니다.
+	 * \details PacketCodec.h의 뷰 타입은 Arena 없이 수신 버퍼를 가리키도록 파싱합니다.
+	 * \details 패킷 처리 함수는 받은 패킷 객체의 참조를 보관하면 안됩니다.
+	 * \tparam PacketType 정의한 패킷 또는 뷰 타입
 	 * \tparam HandleFunc 패킷 처리 함수
 	 * \param func 패킷 처리 함수
 	 * \param session 패킷을 Recv한 Session
@@ -140,39 +70,181 @@ private:
 	template <typename PacketType, typename HandleFunc>
 	static bool HandlePacketTemplate(HandleFunc func, shared_ptr<Session>& session, BYTE* buffer, int len)
 	{
-		PacketType pkt;
-		const int headerSize = sizeof(PacketHeader);
-		if (pkt.ParseFromArray(buffer + headerSize, len - headerSize) == false)
+		// size가 0이라면 64KB를 넘는 v2 프레임
+		const int headerSize = reinterpret_cast<PacketHeader*>(buffer)->size == 0 ? sizeof(PacketHeaderV2) : sizeof(PacketHeader);
+
+		if constexpr (is_base_of_v<google::protobuf::MessageLite, PacketType>)
 		{
-			return false;
+			PacketType* pkt = google::protobuf::Arena::CreateMessage<PacketType>(Arena());
+			if (pkt->ParseFromArray(buffer + headerSize, len - headerSize) == false)
+			{
+				return false;
+			}
+
+			return func(session, *pkt);
 		}
+		else
+		{
+			PacketType pkt;
+			if (pkt.ParseFromArray(buffer + headerSize, len - headerSize) == false)
+			{
+				return false;
+			}
 
-		return func(session, pkt);
+			return func(session, pkt);
+		}
 	}
 
 
 	/**
 	 * \brief SendBuffer에 정의한 패킷 객체를 직렬화하여 담는 함수
+	 * \details 한 청크에 담기지 않는 큰 패킷은 청크 체인에 나누어 직렬화하며, 작은 패킷은 연속된 버퍼에 바로 직렬화합니다.
 	 * \tparam PacketType 정의한 패킷
 	 * \param pkt 정의한 패킷
 	 * \param pktId 프로토콜 ID
-	 * \return 직렬화된 내용이 담긴 버퍼
+	 * \return 직렬화된 내용이 담긴 버퍼, 체인에도 담을 수 없을 만큼 크다면 nullptr
 	 */
 	template <typename PacketType>
-	static shared_ptr<SendBuffer> MakeSendBuffer(PacketType& pkt, unsigned short pktId)
+	static SendBufferRef MakeSendBuffer(PacketType& pkt, unsigned short pktId)
 	{
-		const unsigned short dataSize = static_cast<unsigned short>(pkt.ByteSizeLong());
-		const unsigned short packetSize = dataSize + sizeof(PacketHeader);
+		const size_t dataSize = pkt.ByteSizeLong();
+		const size_t packetSize = dataSize + sizeof(PacketHeader);
+		if (packetSize > SendBufferManager::MAX_BUFFER_SIZE)
+		{
+			return MakeChainSendBuffer(pkt, pktId, dataSize);
+		}
 
-		shared_ptr<SendBuffer> sendBuffer = GSendBufferManager->Open(packetSize);
+		SendBufferRef sendBuffer = GSendBufferManager->Open(static_cast<unsigned int>(packetSize));
 		auto header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
 		header->id = pktId;
-		header->size = packetSize;
+		header->size = static_cast<unsigned short>(packetSize);
 
-		pkt.SerializeToArray(&header[1], dataSize);
+		pkt.SerializeToArray(&header[1], static_cast<int>(dataSize));
 
-		sendBuffer->Close(packetSize);
+		sendBuffer->Close(static_cast<unsigned int>(packetSize));
 
 		return sendBuffer;
 	}
+
+
+	/**
+	 * \brief 한 청크보다 큰 패킷 객체를 청크 체인에 직렬화하여 담는 함수
+	 * \details 체인의 각 버퍼는 하나의 Scatter-Gather 송신에 함께 담깁니다.
+	 * \details 64KB를 넘는 패킷은 PacketHeaderV2를 사용하며 v2 프레이밍을 협상한 세션에만 송신됩니다.
+	 * \details v1 세션은 이런 패킷을 받을 수 없으므로 Send하면 세션의 연결을 끊고 SendMetrics::oversizeDisconnectCount에 집계합니다.
+	 * \tparam PacketType 정의한 패킷
+	 * \param pkt 정의한 패킷
+	 * \param pktId 프로토콜 ID
+	 * \param dataSize 직렬화된 패킷 객체의 크기
+	 * \return 직렬화된 내용이 담긴 체인의 첫 버퍼, 체인에도 담을 수 없을 만큼 크다면 nullptr
+	 */
+	template <typename PacketType>
+	static SendBufferRef MakeChainSendBuffer(PacketType& pkt, unsigned short pktId, size_t dataSize)
+	{
+		size_t headerSize = sizeof(PacketHeader);
+		if (dataSize + headerSize > numeric_limits<decltype(PacketHeader::size)>::max())
+		{
+			headerSize = sizeof(PacketHeaderV2);
+		}
+
+		const size_t packetSize = dataSize + headerSize;
+		if (packetSize > SendBufferManager::MAX_CHAIN_SIZE)
+		{
+			return nullptr;
+		}
+
+		SendBufferRef sendBuffer = GSendBufferManager->OpenChain(static_cast<unsigned int>(packetSize));
+		if (headerSize == sizeof(PacketHeader))
+		{
+			auto header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
+			header->id = pktId;
+			header->size = static_cast<unsigned short>(packetSize);
+		}
+		else
+		{
+			auto header = reinterpret_cast<PacketHeaderV2*>(sendBuffer->Buffer());
+			header->mark = 0;
+			header->id = pktId;
+			header->size = static_cast<unsigned int>(packetSize);
+		}
+
+		SendBufferOutputStream stream(sendBuffer.get(), static_cast<unsigned int>(headerSize));
+		const bool serialized = pkt.SerializeToZeroCopyStream(&stream);
+		ASSERT_CRASH(serialized && stream.ByteCount() == static_cast<int64_t>(dataSize));
+
+		return sendBuffer;
+	}
+};
+
+
+/**
+ * \brief 패킷 처리 함수 목록의 항목
+ * \tparam Id 프로토콜 ID
+ * \tparam PacketType 정의한 패킷
+ * \tparam Func 패킷 처리 함수
+ */
+template <unsigned short Id, typename PacketType, auto Func>
+struct PacketHandlerEntry
+{
+	static constexpr unsigned short ID = Id;
+
+	static bool Handle(shared_ptr<Session>& session, BYTE* buffer, int len)
+	{
+		return PacketHandler::HandlePacketTemplate<PacketType>(Func, session, buffer, len);
+	}
 };
+
+
+/**
+ * \brief 패킷 처리 함수 테이블
+ * \details 항목 목록으로부터 프로토콜 ID를 인덱스로 하는 배열을 컴파일 타임에 만듭니다.
+ * \details 등록되지 않은 ID의 칸은 항상 실패하는 함수로 채워 범위 확인 한번으로 처리 여부를 정합니다.
+ * \tparam Entries PacketHandlerEntry 목록
+ */
+template <typename... Entries>
+struct PacketHandlerTable
+{
+	static constexpr size_t SIZE = max({static_cast<size_t>(Entries::ID)...}) + 1;
+
+	static bool HandleInvalid(shared_ptr<Session>&, BYTE*, int)
+	{
+		return false;
+	}
+
+	static constexpr array<PacketHandlerFunc, SIZE> Build()
+	{
+		array<PacketHandlerFunc, SIZE> table = {};
+		for (size_t i = 0; i < SIZE; i++)
+		{
+			table[i] = &HandleInvalid;
+		}
+		((table[Entries::ID] = &Entries::Handle), ...);
+		return table;
+	}
+};
+
+
+/* 패킷 처리 함수 목록, GenPackets.h에서 생성 */
+using PacketHandlerList = GenPacketHandlerList<PacketHandlerEntry, PacketHandlerTable>;
+
+inline constexpr array<PacketHandlerFunc, PacketHandlerList::SIZE> GPacketHandler = PacketHandlerList::Build();
+static_assert(PacketHandlerList::SIZE <= PACKET_ID_COMPRESSED_FLAG, "protocol id overlaps compressed flag");
+
+
+/**
+ * \brief 도착한 패킷을 처리하는 함수
+ * \details 압축한 패킷의 id는 테이블 범위를 넘으므로 범위 확인에 실패한 경우에만 압축 여부를 확인합니다.
+ * \param session 패킷을 Recv한 Session
+ * \param buffer Session의 Buffer
+ * \param len 패킷의 길이
+ * \return 정상 처리 여부
+ */
+inline bool PacketHandler::HandlePacket(shared_ptr<Session>& session, BYTE* buffer, int len)
+{
+	auto header = reinterpret_cast<PacketHeader*>(buffer);
+	if (header->id >= GPacketHandler.size())
+	{
+		return (header->id & PACKET_ID_COMPRESSED_FLAG) != 0 && HandleCompressedPacket(session, buffer, len);
+	}
+	return GPacketHandler[header->id](session, buffer, len);
+}
@@ -0,0 +1,242 @@
+﻿#pragma once
+
+/*
+ * 플랫폼 헤더
+ * Windows는 Winsock을 그대로 사용하고, Linux는 서버 코드가 사용하는 Winsock 타입과 함수를 POSIX로 대응시킵니다.
+ */
+
+#ifdef _WIN32
+
+#include <WinSock2.h>
+#include <MSWSock.h>
+#include <WS2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "onecore.lib") // VirtualAlloc2, MapViewOfFile3
+
+/* 함수 */
+/**
+ * \brief 현재 스레드를 논리 프로세서 하나에 고정하는 함수
+ * \details 64개를 넘는 논리 프로세서는 프로세서 그룹으로 나뉘므로, 전체 번호를 그룹과 그룹 안의 번호로 바꾸어 SetThreadGroupAffinity로 고정합니다.
+ * \param core 모든 그룹을 이어 센 논리 프로세서 번호
+ * \return 성공 여부, 없는 번호라면 false
+ */
+inline bool PinCurrentThread(unsigned int core)
+{
+	const WORD groupCount = GetActiveProcessorGroupCount();
+	for (WORD group = 0; group < groupCount; group++)
+	{
+		// 그룹 하나의 논리 프로세서는 64개 이하이므로 마스크 하나에 들어감
+		const DWORD processorCount = GetActiveProcessorCount(group);
+		if (core < processorCount)
+		{
+			GROUP_AFFINITY affinity = {};
+			affinity.Group = group;
+			affinity.Mask = static_cast<KAFFINITY>(1) << core;
+			return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+		}
+		core -= processorCount;
+	}
+
+	return false;
+}
+
+/** \brief 미러링 매핑 크기의 단위를 반환하는 함수 \return 할당 단위 (보통 64KB) */
+inline size_t MirroredGranularity()
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return systemInfo.dwAllocationGranularity;
+}
+
+/**
+ * \brief 같은 물리 메모리를 가상 주소에 두번 연속 매핑하는 함수
+ * \details [0, size)에 쓴 데이터가 [size, size * 2)에서도 보이므로 끝을 넘는 데이터도 연속으로 접근할 수 있습니다.
+ * \param size 매핑 크기. MirroredGranularity의 배수여야 합니다.
+ * \return 매핑 시작 주소, 실패하면 nullptr
+ */
+inline BYTE* AllocateMirrored(size_t size)
+{
+	HANDLE section = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+	                                    static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+	if (section == nullptr)
+	{
+		return nullptr;
+	}
+
+	// 두배 크기의 자리를 예약한 뒤 반으로 나누어 각각 같은 섹션으로 교체
+	BYTE* placeholder = static_cast<BYTE*>(VirtualAlloc2(nullptr, nullptr, size * 2, MEM_RESERVE | MEM_RESERVE_PLACEHOLDER,
+	                                                     PAGE_NOACCESS, nullptr, 0));
+	BYTE* mirrored = nullptr;
+	if (placeholder != nullptr && VirtualFree(placeholder, size, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER))
+	{
+		void* first = MapViewOfFile3(section, nullptr, placeholder, 0, size, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+		void* second = MapViewOfFile3(section, nullptr, placeholder + size, 0, size, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+		if (first != nullptr && second != nullptr)
+		{
+			mirrored = placeholder;
+		}
+		else
+		{
+			// 매핑된 뷰는 해제하고 매핑되지 못한 자리는 예약 해제
+			BYTE* halves[2] = {placeholder, placeholder + size};
+			void* views[2] = {first, second};
+			for (int i = 0; i < 2; i++)
+			{
+				if (views[i] != nullptr)
+				{
+					UnmapViewOfFile(views[i]);
+				}
+				else
+				{
+					VirtualFree(halves[i], 0, MEM_RELEASE);
+				}
+			}
+		}
+	}
+	else if (placeholder != nullptr)
+	{
+		VirtualFree(placeholder, 0, MEM_RELEASE);
+	}
+
+	// 매핑된 뷰가 섹션을 참조하므로 핸들은 바로 닫음
+	CloseHandle(section);
+	return mirrored;
+}
+
+/** \brief AllocateMirrored로 매핑한 메모리를 해제하는 함수 */
+inline void FreeMirrored(BYTE* mirrored, size_t size)
+{
+	UnmapViewOfFile(mirrored);
+	UnmapViewOfFile(mirrored + size);
+}
+
+#else
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <cwchar>
+#include <string>
+
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/* 타입 */
+using BYTE = unsigned char;
+using CHAR = char;
+using WCHAR = wchar_t;
+using ULONG = unsigned int;
+using DWORD = unsigned int;
+using SOCKET = int;
+using HANDLE = int;
+using SOCKADDR = sockaddr;
+using SOCKADDR_IN = sockaddr_in;
+
+/**
+ * \brief WSABUF 구조체
+ * \details Scatter-Gather IO에 사용할 버퍼 정보입니다. 송신 시 iovec으로 옮겨 writev에 전달됩니다.
+ */
+struct WSABUF
+{
+	ULONG len;
+	CHAR* buf;
+};
+
+/* 상수 */
+#define OUT
+#define INFINITE 0xFFFFFFFF
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define WSAECONNRESET ECONNRESET
+#define WSAECONNABORTED ECONNABORTED
+
+/* MSVC 전용 */
+#define __analysis_assume(expr)
+
+/* 함수 */
+inline int closesocket(SOCKET socket) { return close(socket); }
+inline int WSAGetLastError() { return errno; }
+inline int WSACleanup() { return 0; }
+
+inline int InetPtonW(int family, const WCHAR* address, void* buffer)
+{
+	std::string narrow(address, address + wcslen(address));
+	return inet_pton(family, narrow.c_str(), buffer);
+}
+
+inline bool PinCurrentThread(unsigned int core)
+{
+	if (core >= CPU_SETSIZE)
+	{
+		return false;
+	}
+
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(core, &cpuSet);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+}
+
+/** \brief 미러링 매핑 크기의 단위를 반환하는 함수 \return 페이지 크기 */
+inline size_t MirroredGranularity()
+{
+	return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/**
+ * \brief 같은 물리 메모리를 가상 주소에 두번 연속 매핑하는 함수
+ * \details [0, size)에 쓴 데이터가 [size, size * 2)에서도 보이므로 끝을 넘는 데이터도 연속으로 접근할 수 있습니다.
+ * \param size 매핑 크기. MirroredGranularity의 배수여야 합니다.
+ * \return 매핑 시작 주소, 실패하면 nullptr
+ */
+inline BYTE* AllocateMirrored(size_t size)
+{
+	int fd = memfd_create("RecvBuffer", MFD_CLOEXEC);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+
+	// 두배 크기의 자리를 예약한 뒤 앞뒤 절반에 같은 파일을 덮어 매핑
+	BYTE* mirrored = nullptr;
+	void* reserved = MAP_FAILED;
+	if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+	{
+		reserved = mmap(nullptr, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+
+	if (reserved != MAP_FAILED)
+	{
+		BYTE* base = static_cast<BYTE*>(reserved);
+		if (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED
+			&& mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED)
+		{
+			mirrored = base;
+		}
+		else
+		{
+			munmap(base, size * 2);
+		}
+	}
+
+	// 매핑이 파일을 참조하므로 fd는 바로 닫음
+	close(fd);
+	return mirrored;
+}
+
+/** \brief AllocateMirrored로 매핑한 메모리를 해제하는 함수 */
+inline void FreeMirrored(BYTE* mirrored, size_t size)
+{
+	munmap(mirrored, size * 2);
+}
+
+#endif
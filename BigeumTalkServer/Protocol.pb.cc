@@ -55,6 +55,7 @@ PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORIT
 PROTOBUF_CONSTEXPR C_LOGIN::C_LOGIN(
     ::_pbi::ConstantInitialized): _impl_{
     /*decltype(_impl_.user_)*/nullptr
+  , /*decltype(_impl_.userdictionary_)*/false
   , /*decltype(_impl_._cached_size_)*/{}} {}
 struct C_LOGINDefaultTypeInternal {
   PROTOBUF_CONSTEXPR C_LOGINDefaultTypeInternal()
@@ -69,6 +70,7 @@ PROTOBUF_CONSTEXPR S_LOGIN::S_LOGIN(
     ::_pbi::ConstantInitialized): _impl_{
     /*decltype(_impl_.userid_)*/uint64_t{0u}
   , /*decltype(_impl_.success_)*/false
+  , /*decltype(_impl_.userdictionary_)*/false
   , /*decltype(_impl_._cached_size_)*/{}} {}
 struct S_LOGINDefaultTypeInternal {
   PROTOBUF_CONSTEXPR S_LOGINDefaultTypeInternal()
@@ -248,8 +250,21 @@ struct S_OTHER_LEAVEDefaultTypeInternal {
   };
 };
 PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 S_OTHER_LEAVEDefaultTypeInternal _S_OTHER_LEAVE_default_instance_;
+PROTOBUF_CONSTEXPR S_USER_DICTIONARY::S_USER_DICTIONARY(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_.users_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}} {}
+struct S_USER_DICTIONARYDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR S_USER_DICTIONARYDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~S_USER_DICTIONARYDefaultTypeInternal() {}
+  union {
+    S_USER_DICTIONARY _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 S_USER_DICTIONARYDefaultTypeInternal _S_USER_DICTIONARY_default_instance_;
 }  // namespace Protocol
-static ::_pb::Metadata file_level_metadata_Protocol_2eproto[16];
+static ::_pb::Metadata file_level_metadata_Protocol_2eproto[17];
 static const ::_pb::EnumDescriptor* file_level_enum_descriptors_Protocol_2eproto[1];
 static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_Protocol_2eproto = nullptr;
 
@@ -280,6 +295,7 @@ const uint32_t TableStruct_Protocol_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE
   ~0u,  // no _weak_field_map_
   ~0u,  // no _inlined_string_donated_
   PROTOBUF_FIELD_OFFSET(::Protocol::C_LOGIN, _impl_.user_),
+  PROTOBUF_FIELD_OFFSET(::Protocol::C_LOGIN, _impl_.userdictionary_),
   ~0u,  // no _has_bits_
   PROTOBUF_FIELD_OFFSET(::Protocol::S_LOGIN, _internal_metadata_),
   ~0u,  // no _extensions_
@@ -288,6 +304,7 @@ const uint32_t TableStruct_Protocol_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE
   ~0u,  // no _inlined_string_donated_
   PROTOBUF_FIELD_OFFSET(::Protocol::S_LOGIN, _impl_.success_),
   PROTOBUF_FIELD_OFFSET(::Protocol::S_LOGIN, _impl_.userid_),
+  PROTOBUF_FIELD_OFFSET(::Protocol::S_LOGIN, _impl_.userdictionary_),
   ~0u,  // no _has_bits_
   PROTOBUF_FIELD_OFFSET(::Protocol::C_CREATE_ROOM, _internal_metadata_),
   ~0u,  // no _extensions_
@@ -367,6 +384,7 @@ const uint32_t TableStruct_Protocol_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE
   ~0u,  // no _inlined_string_donated_
   ::_pbi::kInvalidFieldOffsetTag,
   ::_pbi::kInvalidFieldOffsetTag,
+  ::_pbi::kInvalidFieldOffsetTag,
   PROTOBUF_FIELD_OFFSET(::Protocol::S_CHAT, _impl_.msg_),
   PROTOBUF_FIELD_OFFSET(::Protocol::S_CHAT, _impl_.timestamp_),
   PROTOBUF_FIELD_OFFSET(::Protocol::S_CHAT, _impl_.is_server_),
@@ -386,24 +404,32 @@ const uint32_t TableStruct_Protocol_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE
   ~0u,  // no _inlined_string_donated_
   PROTOBUF_FIELD_OFFSET(::Protocol::S_OTHER_LEAVE, _impl_.user_),
   PROTOBUF_FIELD_OFFSET(::Protocol::S_OTHER_LEAVE, _impl_.timestamp_),
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::Protocol::S_USER_DICTIONARY, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::Protocol::S_USER_DICTIONARY, _impl_.users_),
 };
 static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
   { 0, -1, -1, sizeof(::Protocol::User)},
   { 8, -1, -1, sizeof(::Protocol::Room)},
   { 19, -1, -1, sizeof(::Protocol::C_LOGIN)},
-  { 26, -1, -1, sizeof(::Protocol::S_LOGIN)},
-  { 34, -1, -1, sizeof(::Protocol::C_CREATE_ROOM)},
-  { 42, -1, -1, sizeof(::Protocol::S_CREATE_ROOM)},
-  { 50, -1, -1, sizeof(::Protocol::C_ENTER_ROOM)},
-  { 58, -1, -1, sizeof(::Protocol::S_ENTER_ROOM)},
-  { 67, -1, -1, sizeof(::Protocol::C_LEAVE_ROOM)},
-  { 75, -1, -1, sizeof(::Protocol::S_LEAVE_ROOM)},
-  { 82, -1, -1, sizeof(::Protocol::C_ROOM_LIST)},
-  { 89, -1, -1, sizeof(::Protocol::S_ROOM_LIST)},
-  { 97, -1, -1, sizeof(::Protocol::C_CHAT)},
-  { 105, -1, -1, sizeof(::Protocol::S_CHAT)},
-  { 116, -1, -1, sizeof(::Protocol::S_OTHER_ENTER)},
-  { 124, -1, -1, sizeof(::Protocol::S_OTHER_LEAVE)},
+  { 27, -1, -1, sizeof(::Protocol::S_LOGIN)},
+  { 36, -1, -1, sizeof(::Protocol::C_CREATE_ROOM)},
+  { 44, -1, -1, sizeof(::Protocol::S_CREATE_ROOM)},
+  { 52, -1, -1, sizeof(::Protocol::C_ENTER_ROOM)},
+  { 60, -1, -1, sizeof(::Protocol::S_ENTER_ROOM)},
+  { 69, -1, -1, sizeof(::Protocol::C_LEAVE_ROOM)},
+  { 77, -1, -1, sizeof(::Protocol::S_LEAVE_ROOM)},
+  { 84, -1, -1, sizeof(::Protocol::C_ROOM_LIST)},
+  { 91, -1, -1, sizeof(::Protocol::S_ROOM_LIST)},
+  { 99, -1, -1, sizeof(::Protocol::C_CHAT)},
+  { 107, -1, -1, sizeof(::Protocol::S_CHAT)},
+  { 119, -1, -1, sizeof(::Protocol::S_OTHER_ENTER)},
+  { 127, -1, -1, sizeof(::Protocol::S_OTHER_LEAVE)},
+  { 135, -1, -1, sizeof(::Protocol::S_USER_DICTIONARY)},
 };
 
 static const ::_pb::Message* const file_default_instances[] = {
@@ -423,51 +449,56 @@ static const ::_pb::Message* const file_default_instances[] = {
   &::Protocol::_S_CHAT_default_instance_._instance,
   &::Protocol::_S_OTHER_ENTER_default_instance_._instance,
   &::Protocol::_S_OTHER_LEAVE_default_instance_._instance,
+  &::Protocol::_S_USER_DICTIONARY_default_instance_._instance,
 };
 
 const char descriptor_table_protodef_Protocol_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
   "\n\016Protocol.proto\022\010Protocol\"$\n\004User\022\020\n\010ni"
   "ckname\030\001 \001(\t\022\n\n\002id\030\002 \001(\004\"Z\n\004Room\022\n\n\002id\030\001"
   " \001(\004\022\020\n\010roomName\030\002 \001(\t\022\020\n\010hostName\030\003 \001(\t"
-  "\022\017\n\007maxUser\030\004 \001(\r\022\021\n\tuserCount\030\005 \001(\r\"\'\n\007"
-  "C_LOGIN\022\034\n\004user\030\001 \001(\0132\016.Protocol.User\"*\n"
-  "\007S_LOGIN\022\017\n\007success\030\001 \001(\010\022\016\n\006userId\030\002 \001("
-  "\004\"\?\n\rC_CREATE_ROOM\022\034\n\004user\030\001 \001(\0132\016.Proto"
-  "col.User\022\020\n\010roomName\030\002 \001(\t\">\n\rS_CREATE_R"
-  "OOM\022\017\n\007success\030\001 \001(\010\022\034\n\004room\030\002 \001(\0132\016.Pro"
-  "tocol.Room\"<\n\014C_ENTER_ROOM\022\034\n\004user\030\001 \001(\013"
-  "2\016.Protocol.User\022\016\n\006roomId\030\002 \001(\004\"`\n\014S_EN"
-  "TER_ROOM\022\017\n\007success\030\001 \001(\010\022 \n\010roomData\030\002 "
-  "\001(\0132\016.Protocol.Room\022\035\n\005users\030\003 \003(\0132\016.Pro"
-  "tocol.User\"<\n\014C_LEAVE_ROOM\022\034\n\004user\030\001 \001(\013"
-  "2\016.Protocol.User\022\016\n\006roomId\030\002 \001(\004\"\037\n\014S_LE"
-  "AVE_ROOM\022\017\n\007success\030\001 \001(\010\"+\n\013C_ROOM_LIST"
-  "\022\034\n\004user\030\001 \001(\0132\016.Protocol.User\"\?\n\013S_ROOM"
-  "_LIST\022\021\n\troomCount\030\001 \001(\r\022\035\n\005rooms\030\002 \003(\0132"
-  "\016.Protocol.Room\"3\n\006C_CHAT\022\034\n\004user\030\001 \001(\0132"
-  "\016.Protocol.User\022\013\n\003msg\030\002 \001(\t\"i\n\006S_CHAT\022\022"
-  "\n\010isServer\030\001 \001(\010H\000\022\036\n\004user\030\002 \001(\0132\016.Proto"
-  "col.UserH\000\022\013\n\003msg\030\003 \001(\t\022\021\n\ttimestamp\030\004 \001"
-  "(\001B\013\n\tis_server\"@\n\rS_OTHER_ENTER\022\034\n\004user"
-  "\030\001 \001(\0132\016.Protocol.User\022\021\n\ttimestamp\030\002 \001("
-  "\001\"@\n\rS_OTHER_LEAVE\022\034\n\004user\030\001 \001(\0132\016.Proto"
-  "col.User\022\021\n\ttimestamp\030\002 \001(\001*\222\003\n\010PacketId"
-  "\022\022\n\016PACKET_ID_NONE\020\000\022\025\n\021PACKET_ID_C_LOGI"
-  "N\020\001\022\025\n\021PACKET_ID_S_LOGIN\020\002\022\033\n\027PACKET_ID_"
-  "C_CREATE_ROOM\020\003\022\033\n\027PACKET_ID_S_CREATE_RO"
-  "OM\020\004\022\032\n\026PACKET_ID_C_ENTER_ROOM\020\005\022\032\n\026PACK"
-  "ET_ID_S_ENTER_ROOM\020\006\022\032\n\026PACKET_ID_C_LEAV"
-  "E_ROOM\020\007\022\032\n\026PACKET_ID_S_LEAVE_ROOM\020\010\022\031\n\025"
-  "PACKET_ID_C_ROOM_LIST\020\t\022\031\n\025PACKET_ID_S_R"
-  "OOM_LIST\020\n\022\024\n\020PACKET_ID_C_CHAT\020\013\022\024\n\020PACK"
-  "ET_ID_S_CHAT\020\014\022\033\n\027PACKET_ID_S_OTHER_ENTE"
-  "R\020\r\022\033\n\027PACKET_ID_S_OTHER_LEAVE\020\016b\006proto3"
+  "\022\017\n\007maxUser\030\004 \001(\r\022\021\n\tuserCount\030\005 \001(\r\"\?\n\007"
+  "C_LOGIN\022\034\n\004user\030\001 \001(\0132\016.Protocol.User\022\026\n"
+  "\016userDictionary\030\002 \001(\010\"B\n\007S_LOGIN\022\017\n\007succ"
+  "ess\030\001 \001(\010\022\016\n\006userId\030\002 \001(\004\022\026\n\016userDiction"
+  "ary\030\003 \001(\010\"\?\n\rC_CREATE_ROOM\022\034\n\004user\030\001 \001(\013"
+  "2\016.Protocol.User\022\020\n\010roomName\030\002 \001(\t\">\n\rS_"
+  "CREATE_ROOM\022\017\n\007success\030\001 \001(\010\022\034\n\004room\030\002 \001"
+  "(\0132\016.Protocol.Room\"<\n\014C_ENTER_ROOM\022\034\n\004us"
+  "er\030\001 \001(\0132\016.Protocol.User\022\016\n\006roomId\030\002 \001(\004"
+  "\"`\n\014S_ENTER_ROOM\022\017\n\007success\030\001 \001(\010\022 \n\010roo"
+  "mData\030\002 \001(\0132\016.Protocol.Room\022\035\n\005users\030\003 \003"
+  "(\0132\016.Protocol.User\"<\n\014C_LEAVE_ROOM\022\034\n\004us"
+  "er\030\001 \001(\0132\016.Protocol.User\022\016\n\006roomId\030\002 \001(\004"
+  "\"\037\n\014S_LEAVE_ROOM\022\017\n\007success\030\001 \001(\010\"+\n\013C_R"
+  "OOM_LIST\022\034\n\004user\030\001 \001(\0132\016.Protocol.User\"\?"
+  "\n\013S_ROOM_LIST\022\021\n\troomCount\030\001 \001(\r\022\035\n\005room"
+  "s\030\002 \003(\0132\016.Protocol.Room\"3\n\006C_CHAT\022\034\n\004use"
+  "r\030\001 \001(\0132\016.Protocol.User\022\013\n\003msg\030\002 \001(\t\"{\n\006"
+  "S_CHAT\022\022\n\010isServer\030\001 \001(\010H\000\022\036\n\004user\030\002 \001(\013"
+  "2\016.Protocol.UserH\000\022\020\n\006userId\030\005 \001(\004H\000\022\013\n\003"
+  "msg\030\003 \001(\t\022\021\n\ttimestamp\030\004 \001(\001B\013\n\tis_serve"
+  "r\"@\n\rS_OTHER_ENTER\022\034\n\004user\030\001 \001(\0132\016.Proto"
+  "col.User\022\021\n\ttimestamp\030\002 \001(\001\"@\n\rS_OTHER_L"
+  "EAVE\022\034\n\004user\030\001 \001(\0132\016.Protocol.User\022\021\n\tti"
+  "mestamp\030\002 \001(\001\"2\n\021S_USER_DICTIONARY\022\035\n\005us"
+  "ers\030\001 \003(\0132\016.Protocol.User*\263\003\n\010PacketId\022\022"
+  "\n\016PACKET_ID_NONE\020\000\022\025\n\021PACKET_ID_C_LOGIN\020"
+  "\001\022\025\n\021PACKET_ID_S_LOGIN\020\002\022\033\n\027PACKET_ID_C_"
+  "CREATE_ROOM\020\003\022\033\n\027PACKET_ID_S_CREATE_ROOM"
+  "\020\004\022\032\n\026PACKET_ID_C_ENTER_ROOM\020\005\022\032\n\026PACKET"
+  "_ID_S_ENTER_ROOM\020\006\022\032\n\026PACKET_ID_C_LEAVE_"
+  "ROOM\020\007\022\032\n\026PACKET_ID_S_LEAVE_ROOM\020\010\022\031\n\025PA"
+  "CKET_ID_C_ROOM_LIST\020\t\022\031\n\025PACKET_ID_S_ROO"
+  "M_LIST\020\n\022\024\n\020PACKET_ID_C_CHAT\020\013\022\024\n\020PACKET"
+  "_ID_S_CHAT\020\014\022\033\n\027PACKET_ID_S_OTHER_ENTER\020"
+  "\r\022\033\n\027PACKET_ID_S_OTHER_LEAVE\020\016\022\037\n\033PACKET"
+  "_ID_S_USER_DICTIONARY\020\017b\006proto3"
   ;
 static ::_pbi::once_flag descriptor_table_Protocol_2eproto_once;
 const ::_pbi::DescriptorTable descriptor_table_Protocol_2eproto = {
-    false, false, 1440, descriptor_table_protodef_Protocol_2eproto,
+    false, false, 1591, descriptor_table_protodef_Protocol_2eproto,
     "Protocol.proto",
-    &descriptor_table_Protocol_2eproto_once, nullptr, 0, 16,
+    &descriptor_table_Protocol_2eproto_once, nullptr, 0, 17,
     schemas, file_default_instances, TableStruct_Protocol_2eproto::offsets,
     file_level_metadata_Protocol_2eproto, file_level_enum_descriptors_Protocol_2eproto,
     file_level_service_descriptors_Protocol_2eproto,
@@ -500,6 +531,7 @@ bool PacketId_IsValid(int value) {
     case 12:
     case 13:
     case 14:
+    case 15:
       return true;
     default:
       return false;
@@ -1096,12 +1128,14 @@ C_LOGIN::C_LOGIN(const C_LOGIN& from)
   C_LOGIN* const _this = this; (void)_this;
   new (&_impl_) Impl_{
       decltype(_impl_.user_){nullptr}
+    , decltype(_impl_.userdictionary_){}
     , /*decltype(_impl_._cached_size_)*/{}};
 
   _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
   if (from._internal_has_user()) {
     _this->_impl_.user_ = new ::Protocol::User(*from._impl_.user_);
   }
+  _this->_impl_.userdictionary_ = from._impl_.userdictionary_;
   // @@protoc_insertion_point(copy_constructor:Protocol.C_LOGIN)
 }
 
@@ -1111,6 +1145,7 @@ inline void C_LOGIN::SharedCtor(
   (void)is_message_owned;
   new (&_impl_) Impl_{
       decltype(_impl_.user_){nullptr}
+    , decltype(_impl_.userdictionary_){false}
     , /*decltype(_impl_._cached_size_)*/{}
   };
 }
@@ -1143,6 +1178,7 @@ void C_LOGIN::Clear() {
     delete _impl_.user_;
   }
   _impl_.user_ = nullptr;
+  _impl_.userdictionary_ = false;
   _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
@@ -1160,6 +1196,14 @@ const char* C_LOGIN::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx)
         } else
           goto handle_unusual;
         continue;
+      // bool userDictionary = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _impl_.userdictionary_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -1196,6 +1240,12 @@ uint8_t* C_LOGIN::_InternalSerialize(
         _Internal::user(this).GetCachedSize(), target, stream);
   }
 
+  // bool userDictionary = 2;
+  if (this->_internal_userdictionary() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(2, this->_internal_userdictionary(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
@@ -1219,6 +1269,11 @@ size_t C_LOGIN::ByteSizeLong() const {
         *_impl_.user_);
   }
 
+  // bool userDictionary = 2;
+  if (this->_internal_userdictionary() != 0) {
+    total_size += 1 + 1;
+  }
+
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
@@ -1241,6 +1296,9 @@ void C_LOGIN::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOB
     _this->_internal_mutable_user()->::Protocol::User::MergeFrom(
         from._internal_user());
   }
+  if (from._internal_userdictionary() != 0) {
+    _this->_internal_set_userdictionary(from._internal_userdictionary());
+  }
   _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
@@ -1258,7 +1316,12 @@ bool C_LOGIN::IsInitialized() const {
 void C_LOGIN::InternalSwap(C_LOGIN* other) {
   using std::swap;
   _internal_metadata_.InternalSwap(&other->_internal_metadata_);
-  swap(_impl_.user_, other->_impl_.user_);
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(C_LOGIN, _impl_.userdictionary_)
+      + sizeof(C_LOGIN::_impl_.userdictionary_)
+      - PROTOBUF_FIELD_OFFSET(C_LOGIN, _impl_.user_)>(
+          reinterpret_cast<char*>(&_impl_.user_),
+          reinterpret_cast<char*>(&other->_impl_.user_));
 }
 
 ::PROTOBUF_NAMESPACE_ID::Metadata C_LOGIN::GetMetadata() const {
@@ -1285,12 +1348,13 @@ S_LOGIN::S_LOGIN(const S_LOGIN& from)
   new (&_impl_) Impl_{
       decltype(_impl_.userid_){}
     , decltype(_impl_.success_){}
+    , decltype(_impl_.userdictionary_){}
     , /*decltype(_impl_._cached_size_)*/{}};
 
   _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
   ::memcpy(&_impl_.userid_, &from._impl_.userid_,
-    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.success_) -
-    reinterpret_cast<char*>(&_impl_.userid_)) + sizeof(_impl_.success_));
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.userdictionary_) -
+    reinterpret_cast<char*>(&_impl_.userid_)) + sizeof(_impl_.userdictionary_));
   // @@protoc_insertion_point(copy_constructor:Protocol.S_LOGIN)
 }
 
@@ -1301,6 +1365,7 @@ inline void S_LOGIN::SharedCtor(
   new (&_impl_) Impl_{
       decltype(_impl_.userid_){uint64_t{0u}}
     , decltype(_impl_.success_){false}
+    , decltype(_impl_.userdictionary_){false}
     , /*decltype(_impl_._cached_size_)*/{}
   };
 }
@@ -1329,8 +1394,8 @@ void S_LOGIN::Clear() {
   (void) cached_has_bits;
 
   ::memset(&_impl_.userid_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&_impl_.success_) -
-      reinterpret_cast<char*>(&_impl_.userid_)) + sizeof(_impl_.success_));
+      reinterpret_cast<char*>(&_impl_.userdictionary_) -
+      reinterpret_cast<char*>(&_impl_.userid_)) + sizeof(_impl_.userdictionary_));
   _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
@@ -1356,6 +1421,14 @@ const char* S_LOGIN::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx)
         } else
           goto handle_unusual;
         continue;
+      // bool userDictionary = 3;
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 24)) {
+          _impl_.userdictionary_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -1397,6 +1470,12 @@ uint8_t* S_LOGIN::_InternalSerialize(
     target = ::_pbi::WireFormatLite::WriteUInt64ToArray(2, this->_internal_userid(), target);
   }
 
+  // bool userDictionary = 3;
+  if (this->_internal_userdictionary() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(3, this->_internal_userdictionary(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
@@ -1423,6 +1502,11 @@ size_t S_LOGIN::ByteSizeLong() const {
     total_size += 1 + 1;
   }
 
+  // bool userDictionary = 3;
+  if (this->_internal_userdictionary() != 0) {
+    total_size += 1 + 1;
+  }
+
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
@@ -1447,6 +1531,9 @@ void S_LOGIN::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOB
   if (from._internal_success() != 0) {
     _this->_internal_set_success(from._internal_success());
   }
+  if (from._internal_userdictionary() != 0) {
+    _this->_internal_set_userdictionary(from._internal_userdictionary());
+  }
   _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
@@ -1465,8 +1552,8 @@ void S_LOGIN::InternalSwap(S_LOGIN* other) {
   using std::swap;
   _internal_metadata_.InternalSwap(&other->_internal_metadata_);
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(S_LOGIN, _impl_.success_)
-      + sizeof(S_LOGIN::_impl_.success_)
+      PROTOBUF_FIELD_OFFSET(S_LOGIN, _impl_.userdictionary_)
+      + sizeof(S_LOGIN::_impl_.userdictionary_)
       - PROTOBUF_FIELD_OFFSET(S_LOGIN, _impl_.userid_)>(
           reinterpret_cast<char*>(&_impl_.userid_),
           reinterpret_cast<char*>(&other->_impl_.userid_));
@@ -3544,6 +3631,10 @@ S_CHAT::S_CHAT(const S_CHAT& from)
           from._internal_user());
       break;
     }
+    case kUserId: {
+      _this->_internal_set_userid(from._internal_userid());
+      break;
+    }
     case IS_SERVER_NOT_SET: {
       break;
     }
@@ -3603,6 +3694,10 @@ void S_CHAT::clear_is_server() {
       }
       break;
     }
+    case kUserId: {
+      // No need to clear
+      break;
+    }
     case IS_SERVER_NOT_SET: {
       break;
     }
@@ -3663,6 +3758,14 @@ const char* S_CHAT::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
         } else
           goto handle_unusual;
         continue;
+      // uint64 userId = 5;
+      case 5:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 40)) {
+          _internal_set_userid(::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr));
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -3725,6 +3828,12 @@ uint8_t* S_CHAT::_InternalSerialize(
     target = ::_pbi::WireFormatLite::WriteDoubleToArray(4, this->_internal_timestamp(), target);
   }
 
+  // uint64 userId = 5;
+  if (_internal_has_userid()) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt64ToArray(5, this->_internal_userid(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
@@ -3770,6 +3879,11 @@ size_t S_CHAT::ByteSizeLong() const {
           *_impl_.is_server_.user_);
       break;
     }
+    // uint64 userId = 5;
+    case kUserId: {
+      total_size += ::_pbi::WireFormatLite::UInt64SizePlusOne(this->_internal_userid());
+      break;
+    }
     case IS_SERVER_NOT_SET: {
       break;
     }
@@ -3812,6 +3926,10 @@ void S_CHAT::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBU
           from._internal_user());
       break;
     }
+    case kUserId: {
+      _this->_internal_set_userid(from._internal_userid());
+      break;
+    }
     case IS_SERVER_NOT_SET: {
       break;
     }
@@ -4322,6 +4440,191 @@ void S_OTHER_LEAVE::InternalSwap(S_OTHER_LEAVE* other) {
       file_level_metadata_Protocol_2eproto[15]);
 }
 
+// ===================================================================
+
+class S_USER_DICTIONARY::_Internal {
+ public:
+};
+
+S_USER_DICTIONARY::S_USER_DICTIONARY(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:Protocol.S_USER_DICTIONARY)
+}
+S_USER_DICTIONARY::S_USER_DICTIONARY(const S_USER_DICTIONARY& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  S_USER_DICTIONARY* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_.users_){from._impl_.users_}
+    , /*decltype(_impl_._cached_size_)*/{}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  // @@protoc_insertion_point(copy_constructor:Protocol.S_USER_DICTIONARY)
+}
+
+inline void S_USER_DICTIONARY::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_.users_){arena}
+    , /*decltype(_impl_._cached_size_)*/{}
+  };
+}
+
+S_USER_DICTIONARY::~S_USER_DICTIONARY() {
+  // @@protoc_insertion_point(destructor:Protocol.S_USER_DICTIONARY)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
+}
+
+inline void S_USER_DICTIONARY::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.users_.~RepeatedPtrField();
+}
+
+void S_USER_DICTIONARY::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
+}
+
+void S_USER_DICTIONARY::Clear() {
+// @@protoc_insertion_point(message_clear_start:Protocol.S_USER_DICTIONARY)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  _impl_.users_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* S_USER_DICTIONARY::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // repeated .Protocol.User users = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 10)) {
+          ptr -= 1;
+          do {
+            ptr += 1;
+            ptr = ctx->ParseMessage(_internal_add_users(), ptr);
+            CHK_(ptr);
+            if (!ctx->DataAvailable(ptr)) break;
+          } while (::PROTOBUF_NAMESPACE_ID::internal::ExpectTag<10>(ptr));
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* S_USER_DICTIONARY::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:Protocol.S_USER_DICTIONARY)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // repeated .Protocol.User users = 1;
+  for (unsigned i = 0,
+      n = static_cast<unsigned>(this->_internal_users_size()); i < n; i++) {
+    const auto& repfield = this->_internal_users(i);
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+        InternalWriteMessage(1, repfield, repfield.GetCachedSize(), target, stream);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:Protocol.S_USER_DICTIONARY)
+  return target;
+}
+
+size_t S_USER_DICTIONARY::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:Protocol.S_USER_DICTIONARY)
+  size_t total_size = 0;
+
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // repeated .Protocol.User users = 1;
+  total_size += 1UL * this->_internal_users_size();
+  for (const auto& msg : this->_impl_.users_) {
+    total_size +=
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(msg);
+  }
+
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData S_USER_DICTIONARY::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    S_USER_DICTIONARY::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*S_USER_DICTIONARY::GetClassData() const { return &_class_data_; }
+
+
+void S_USER_DICTIONARY::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<S_USER_DICTIONARY*>(&to_msg);
+  auto& from = static_cast<const S_USER_DICTIONARY&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:Protocol.S_USER_DICTIONARY)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  _this->_impl_.users_.MergeFrom(from._impl_.users_);
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+}
+
+void S_USER_DICTIONARY::CopyFrom(const S_USER_DICTIONARY& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:Protocol.S_USER_DICTIONARY)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool S_USER_DICTIONARY::IsInitialized() const {
+  return true;
+}
+
+void S_USER_DICTIONARY::InternalSwap(S_USER_DICTIONARY* other) {
+  using std::swap;
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  _impl_.users_.InternalSwap(&other->_impl_.users_);
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata S_USER_DICTIONARY::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_Protocol_2eproto_getter, &descriptor_table_Protocol_2eproto_once,
+      file_level_metadata_Protocol_2eproto[16]);
+}
+
 // @@protoc_insertion_point(namespace_scope)
 }  // namespace Protocol
 PROTOBUF_NAMESPACE_OPEN
@@ -4389,6 +4692,10 @@ template<> PROTOBUF_NOINLINE ::Protocol::S_OTHER_LEAVE*
 Arena::CreateMaybeMessage< ::Protocol::S_OTHER_LEAVE >(Arena* arena) {
   return Arena::CreateMessageInternal< ::Protocol::S_OTHER_LEAVE >(arena);
 }
+template<> PROTOBUF_NOINLINE ::Protocol::S_USER_DICTIONARY*
+Arena::CreateMaybeMessage< ::Protocol::S_USER_DICTIONARY >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::Protocol::S_USER_DICTIONARY >(arena);
+}
 PROTOBUF_NAMESPACE_CLOSE
 
 // @@protoc_insertion_point(global_scope)
@@ -91,6 +91,9 @@ extern S_OTHER_LEAVEDefaultTypeInternal _S_OTHER_LEAVE_default_instance_;
 class S_ROOM_LIST;
 struct S_ROOM_LISTDefaultTypeInternal;
 extern S_ROOM_LISTDefaultTypeInternal _S_ROOM_LIST_default_instance_;
+class S_USER_DICTIONARY;
+struct S_USER_DICTIONARYDefaultTypeInternal;
+extern S_USER_DICTIONARYDefaultTypeInternal _S_USER_DICTIONARY_default_instance_;
 class User;
 struct UserDefaultTypeInternal;
 extern UserDefaultTypeInternal _User_default_instance_;
@@ -111,6 +114,7 @@ template<> ::Protocol::S_LOGIN* Arena::CreateMaybeMessage<::Protocol::S_LOGIN>(A
 template<> ::Protocol::S_OTHER_ENTER* Arena::CreateMaybeMessage<::Protocol::S_OTHER_ENTER>(Arena*);
 template<> ::Protocol::S_OTHER_LEAVE* Arena::CreateMaybeMessage<::Protocol::S_OTHER_LEAVE>(Arena*);
 template<> ::Protocol::S_ROOM_LIST* Arena::CreateMaybeMessage<::Protocol::S_ROOM_LIST>(Arena*);
+template<> ::Protocol::S_USER_DICTIONARY* Arena::CreateMaybeMessage<::Protocol::S_USER_DICTIONARY>(Arena*);
 template<> ::Protocol::User* Arena::CreateMaybeMessage<::Protocol::User>(Arena*);
 PROTOBUF_NAMESPACE_CLOSE
 namespace Protocol {
@@ -131,12 +135,13 @@ enum PacketId : int {
   PACKET_ID_S_CHAT = 12,
   PACKET_ID_S_OTHER_ENTER = 13,
   PACKET_ID_S_OTHER_LEAVE = 14,
+  PACKET_ID_S_USER_DICTIONARY = 15,
   PacketId_INT_MIN_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::min(),
   PacketId_INT_MAX_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::max()
 };
 bool PacketId_IsValid(int value);
 constexpr PacketId PacketId_MIN = PACKET_ID_NONE;
-constexpr PacketId PacketId_MAX = PACKET_ID_S_OTHER_LEAVE;
+constexpr PacketId PacketId_MAX = PACKET_ID_S_USER_DICTIONARY;
 constexpr int PacketId_ARRAYSIZE = PacketId_MAX + 1;
 
 const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* PacketId_descriptor();
@@ -643,6 +648,7 @@ class C_LOGIN final :
 
   enum : int {
     kUserFieldNumber = 1,
+    kUserDictionaryFieldNumber = 2,
   };
   // .Protocol.User user = 1;
   bool has_user() const;
@@ -662,6 +668,15 @@ class C_LOGIN final :
       ::Protocol::User* user);
   ::Protocol::User* unsafe_arena_release_user();
 
+  // bool userDictionary = 2;
+  void clear_userdictionary();
+  bool userdictionary() const;
+  void set_userdictionary(bool value);
+  private:
+  bool _internal_userdictionary() const;
+  void _internal_set_userdictionary(bool value);
+  public:
+
   // @@protoc_insertion_point(class_scope:Protocol.C_LOGIN)
  private:
   class _Internal;
@@ -671,6 +686,7 @@ class C_LOGIN final :
   typedef void DestructorSkippable_;
   struct Impl_ {
     ::Protocol::User* user_;
+    bool userdictionary_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   };
   union { Impl_ _impl_; };
@@ -801,6 +817,7 @@ class S_LOGIN final :
   enum : int {
     kUserIdFieldNumber = 2,
     kSuccessFieldNumber = 1,
+    kUserDictionaryFieldNumber = 3,
   };
   // uint64 userId = 2;
   void clear_userid();
@@ -820,6 +837,15 @@ class S_LOGIN final :
   void _internal_set_success(bool value);
   public:
 
+  // bool userDictionary = 3;
+  void clear_userdictionary();
+  bool userdictionary() const;
+  void set_userdictionary(bool value);
+  private:
+  bool _internal_userdictionary() const;
+  void _internal_set_userdictionary(bool value);
+  public:
+
   // @@protoc_insertion_point(class_scope:Protocol.S_LOGIN)
  private:
   class _Internal;
@@ -830,6 +856,7 @@ class S_LOGIN final :
   struct Impl_ {
     uint64_t userid_;
     bool success_;
+    bool userdictionary_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   };
   union { Impl_ _impl_; };
@@ -2394,6 +2421,7 @@ class S_CHAT final :
   enum IsServerCase {
     kIsServer = 1,
     kUser = 2,
+    kUserId = 5,
     IS_SERVER_NOT_SET = 0,
   };
 
@@ -2479,6 +2507,7 @@ class S_CHAT final :
     kTimestampFieldNumber = 4,
     kIsServerFieldNumber = 1,
     kUserFieldNumber = 2,
+    kUserIdFieldNumber = 5,
   };
   // string msg = 3;
   void clear_msg();
@@ -2534,6 +2563,19 @@ class S_CHAT final :
       ::Protocol::User* user);
   ::Protocol::User* unsafe_arena_release_user();
 
+  // uint64 userId = 5;
+  bool has_userid() const;
+  private:
+  bool _internal_has_userid() const;
+  public:
+  void clear_userid();
+  uint64_t userid() const;
+  void set_userid(uint64_t value);
+  private:
+  uint64_t _internal_userid() const;
+  void _internal_set_userid(uint64_t value);
+  public:
+
   void clear_is_server();
   IsServerCase is_server_case() const;
   // @@protoc_insertion_point(class_scope:Protocol.S_CHAT)
@@ -2541,6 +2583,7 @@ class S_CHAT final :
   class _Internal;
   void set_has_isserver();
   void set_has_user();
+  void set_has_userid();
 
   inline bool has_is_server() const;
   inline void clear_has_is_server();
@@ -2556,6 +2599,7 @@ class S_CHAT final :
         ::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized _constinit_;
       bool isserver_;
       ::Protocol::User* user_;
+      uint64_t userid_;
     } is_server_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
     uint32_t _oneof_case_[1];
@@ -2900,6 +2944,163 @@ class S_OTHER_LEAVE final :
   union { Impl_ _impl_; };
   friend struct ::TableStruct_Protocol_2eproto;
 };
+// -------------------------------------------------------------------
+
+class S_USER_DICTIONARY final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:Protocol.S_USER_DICTIONARY) */ {
+ public:
+  inline S_USER_DICTIONARY() : S_USER_DICTIONARY(nullptr) {}
+  ~S_USER_DICTIONARY() override;
+  explicit PROTOBUF_CONSTEXPR S_USER_DICTIONARY(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
+
+  S_USER_DICTIONARY(const S_USER_DICTIONARY& from);
+  S_USER_DICTIONARY(S_USER_DICTIONARY&& from) noexcept
+    : S_USER_DICTIONARY() {
+    *this = ::std::move(from);
+  }
+
+  inline S_USER_DICTIONARY& operator=(const S_USER_DICTIONARY& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline S_USER_DICTIONARY& operator=(S_USER_DICTIONARY&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const S_USER_DICTIONARY& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const S_USER_DICTIONARY* internal_default_instance() {
+    return reinterpret_cast<const S_USER_DICTIONARY*>(
+               &_S_USER_DICTIONARY_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    16;
+
+  friend void swap(S_USER_DICTIONARY& a, S_USER_DICTIONARY& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(S_USER_DICTIONARY* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(S_USER_DICTIONARY* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  S_USER_DICTIONARY* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<S_USER_DICTIONARY>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
+  void CopyFrom(const S_USER_DICTIONARY& from);
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const S_USER_DICTIONARY& from) {
+    S_USER_DICTIONARY::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
+  void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(S_USER_DICTIONARY* other);
+
+  private:
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "Protocol.S_USER_DICTIONARY";
+  }
+  protected:
+  explicit S_USER_DICTIONARY(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
+  public:
+
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kUsersFieldNumber = 1,
+  };
+  // repeated .Protocol.User users = 1;
+  int users_size() const;
+  private:
+  int _internal_users_size() const;
+  public:
+  void clear_users();
+  ::Protocol::User* mutable_users(int index);
+  ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::Protocol::User >*
+      mutable_users();
+  private:
+  const ::Protocol::User& _internal_users(int index) const;
+  ::Protocol::User* _internal_add_users();
+  public:
+  const ::Protocol::User& users(int index) const;
+  ::Protocol::User* add_users();
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::Protocol::User >&
+      users() const;
+
+  // @@protoc_insertion_point(class_scope:Protocol.S_USER_DICTIONARY)
+ private:
+  class _Internal;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::Protocol::User > users_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_Protocol_2eproto;
+};
 // ===================================================================
 
 
@@ -3239,6 +3440,26 @@ inline void C_LOGIN::set_allocated_user(::Protocol::User* user) {
   // @@protoc_insertion_point(field_set_allocated:Protocol.C_LOGIN.user)
 }
 
+// bool userDictionary = 2;
+inline void C_LOGIN::clear_userdictionary() {
+  _impl_.userdictionary_ = false;
+}
+inline bool C_LOGIN::_internal_userdictionary() const {
+  return _impl_.userdictionary_;
+}
+inline bool C_LOGIN::userdictionary() const {
+  // @@protoc_insertion_point(field_get:Protocol.C_LOGIN.userDictionary)
+  return _internal_userdictionary();
+}
+inline void C_LOGIN::_internal_set_userdictionary(bool value) {
+  
+  _impl_.userdictionary_ = value;
+}
+inline void C_LOGIN::set_userdictionary(bool value) {
+  _internal_set_userdictionary(value);
+  // @@protoc_insertion_point(field_set:Protocol.C_LOGIN.userDictionary)
+}
+
 // -------------------------------------------------------------------
 
 // S_LOGIN
@@ -3283,6 +3504,26 @@ inline void S_LOGIN::set_userid(uint64_t value) {
   // @@protoc_insertion_point(field_set:Protocol.S_LOGIN.userId)
 }
 
+// bool userDictionary = 3;
+inline void S_LOGIN::clear_userdictionary() {
+  _impl_.userdictionary_ = false;
+}
+inline bool S_LOGIN::_internal_userdictionary() const {
+  return _impl_.userdictionary_;
+}
+inline bool S_LOGIN::userdictionary() const {
+  // @@protoc_insertion_point(field_get:Protocol.S_LOGIN.userDictionary)
+  return _internal_userdictionary();
+}
+inline void S_LOGIN::_internal_set_userdictionary(bool value) {
+  
+  _impl_.userdictionary_ = value;
+}
+inline void S_LOGIN::set_userdictionary(bool value) {
+  _internal_set_userdictionary(value);
+  // @@protoc_insertion_point(field_set:Protocol.S_LOGIN.userDictionary)
+}
+
 // -------------------------------------------------------------------
 
 // C_CREATE_ROOM
@@ -4365,6 +4606,44 @@ inline ::Protocol::User* S_CHAT::mutable_user() {
   return _msg;
 }
 
+// uint64 userId = 5;
+inline bool S_CHAT::_internal_has_userid() const {
+  return is_server_case() == kUserId;
+}
+inline bool S_CHAT::has_userid() const {
+  return _internal_has_userid();
+}
+inline void S_CHAT::set_has_userid() {
+  _impl_._oneof_case_[0] = kUserId;
+}
+inline void S_CHAT::clear_userid() {
+  if (_internal_has_userid()) {
+    _impl_.is_server_.userid_ = uint64_t{0u};
+    clear_has_is_server();
+  }
+}
+inline uint64_t S_CHAT::_internal_userid() const {
+  if (_internal_has_userid()) {
+    return _impl_.is_server_.userid_;
+  }
+  return uint64_t{0u};
+}
+inline void S_CHAT::_internal_set_userid(uint64_t value) {
+  if (!_internal_has_userid()) {
+    clear_is_server();
+    set_has_userid();
+  }
+  _impl_.is_server_.userid_ = value;
+}
+inline uint64_t S_CHAT::userid() const {
+  // @@protoc_insertion_point(field_get:Protocol.S_CHAT.userId)
+  return _internal_userid();
+}
+inline void S_CHAT::set_userid(uint64_t value) {
+  _internal_set_userid(value);
+  // @@protoc_insertion_point(field_set:Protocol.S_CHAT.userId)
+}
+
 // string msg = 3;
 inline void S_CHAT::clear_msg() {
   _impl_.msg_.ClearToEmpty();
@@ -4672,6 +4951,50 @@ inline void S_OTHER_LEAVE::set_timestamp(double value) {
   // @@protoc_insertion_point(field_set:Protocol.S_OTHER_LEAVE.timestamp)
 }
 
+// -------------------------------------------------------------------
+
+// S_USER_DICTIONARY
+
+// repeated .Protocol.User users = 1;
+inline int S_USER_DICTIONARY::_internal_users_size() const {
+  return _impl_.users_.size();
+}
+inline int S_USER_DICTIONARY::users_size() const {
+  return _internal_users_size();
+}
+inline void S_USER_DICTIONARY::clear_users() {
+  _impl_.users_.Clear();
+}
+inline ::Protocol::User* S_USER_DICTIONARY::mutable_users(int index) {
+  // @@protoc_insertion_point(field_mutable:Protocol.S_USER_DICTIONARY.users)
+  return _impl_.users_.Mutable(index);
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::Protocol::User >*
+S_USER_DICTIONARY::mutable_users() {
+  // @@protoc_insertion_point(field_mutable_list:Protocol.S_USER_DICTIONARY.users)
+  return &_impl_.users_;
+}
+inline const ::Protocol::User& S_USER_DICTIONARY::_internal_users(int index) const {
+  return _impl_.users_.Get(index);
+}
+inline const ::Protocol::User& S_USER_DICTIONARY::users(int index) const {
+  // @@protoc_insertion_point(field_get:Protocol.S_USER_DICTIONARY.users)
+  return _internal_users(index);
+}
+inline ::Protocol::User* S_USER_DICTIONARY::_internal_add_users() {
+  return _impl_.users_.Add();
+}
+inline ::Protocol::User* S_USER_DICTIONARY::add_users() {
+  ::Protocol::User* _add = _internal_add_users();
+  // @@protoc_insertion_point(field_add:Protocol.S_USER_DICTIONARY.users)
+  return _add;
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::Protocol::User >&
+S_USER_DICTIONARY::users() const {
+  // @@protoc_insertion_point(field_list:Protocol.S_USER_DICTIONARY.users)
+  return _impl_.users_;
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
@@ -4705,6 +5028,8 @@ inline void S_OTHER_LEAVE::set_timestamp(double value) {
 
 // -------------------------------------------------------------------
 
+// -------------------------------------------------------------------
+
 
 // @@protoc_insertion_point(namespace_scope)
 
@@ -1,37 +1,211 @@
 ﻿#include "pch.h"
 #include "RecvBuffer.h"
 
-RecvBuffer::RecvBuffer(int bufferSize)
-	: _capacity(bufferSize * BUFFER_COUNT), _bufferSize(bufferSize)
+RecvBufferPool::RecvBufferPool()
+{
+	// 미러링 매핑은 매핑 단위의 배수여야 하므로 나누어지지 않는 크기 분류는 선형 버퍼로 사용
+	const int granularity = static_cast<int>(MirroredGranularity());
+	for (int sizeClass = 0; sizeClass < SIZE_CLASS_COUNT; sizeClass++)
+	{
+		const int size = MIN_SLAB_SIZE << (sizeClass * 2);
+		_slabSizes[sizeClass] = size;
+		_mirrorable[sizeClass] = size >= MIN_MIRRORED_SIZE && size % granularity == 0;
+	}
+}
+
+RecvBufferPool::~RecvBufferPool()
+{
+	for (int sizeClass = 0; sizeClass < SIZE_CLASS_COUNT; sizeClass++)
+	{
+		for (BYTE* slab : _mirroredSlabs[sizeClass])
+		{
+			FreeMirrored(slab, _slabSizes[sizeClass]);
+		}
+
+		for (BYTE* slab : _linearSlabs[sizeClass])
+		{
+			delete[] slab;
+		}
+	}
+}
+
+
+/**
+ * \brief 사용 가능한 슬랩을 꺼내는 함수
+ * \details 미러링할 수 있는 크기 분류라면 미러링 슬랩을 먼저 꺼내고, 매핑 수 제한에 걸렸거나 매핑에 실패하면 선형 버퍼를 꺼냅니다.
+ * \param sizeClass 꺼낼 슬랩의 크기 분류
+ * \param mirrored 꺼낸 슬랩이 미러링 슬랩인지 여부
+ * \return 사용 가능한 슬랩
+ */
+BYTE* RecvBufferPool::Pop(int sizeClass, OUT bool& mirrored)
+{
+	if (_mirrorable[sizeClass])
+	{
+		bool allocate = false;
+		{
+			lock_guard<mutex> guard(_mutex);
+
+			// 반납된 슬랩이 있다면 마지막 것을 반환
+			vector<BYTE*>& slabs = _mirroredSlabs[sizeClass];
+			if (slabs.empty() == false)
+			{
+				BYTE* slab = slabs.back();
+				slabs.pop_back();
+				mirrored = true;
+				return slab;
+			}
+
+			// 매핑할 자리를 먼저 차지
+			if (_mirroredCount.load(memory_order_relaxed) < MAX_MIRRORED_SLABS)
+			{
+				_mirroredCount.fetch_add(1, memory_order_relaxed);
+				allocate = true;
+			}
+		}
+
+		if (allocate)
+		{
+			if (BYTE* slab = AllocateMirrored(SlabSize(sizeClass)))
+			{
+				mirrored = true;
+				return slab;
+			}
+
+			lock_guard<mutex> guard(_mutex);
+			_mirroredCount.fetch_sub(1, memory_order_relaxed);
+		}
+	}
+
+	mirrored = false;
+	{
+		lock_guard<mutex> guard(_mutex);
+
+		vector<BYTE*>& slabs = _linearSlabs[sizeClass];
+		if (slabs.empty() == false)
+		{
+			BYTE* slab = slabs.back();
+			slabs.pop_back();
+			return slab;
+		}
+	}
+
+	return new BYTE[SlabSize(sizeClass)];
+}
+
+
+/**
+ * \brief 슬랩을 반납하는 함수
+ * \param slab 반납할 슬랩
+ * \param sizeClass 슬랩의 크기 분류
+ * \param mirrored 미러링 슬랩인지 여부
+ */
+void RecvBufferPool::Push(BYTE* slab, int sizeClass, bool mirrored)
+{
+	lock_guard<mutex> guard(_mutex);
+	if (mirrored)
+	{
+		_mirroredSlabs[sizeClass].push_back(slab);
+	}
+	else
+	{
+		_linearSlabs[sizeClass].push_back(slab);
+	}
+}
+
+
+RecvBuffer::RecvBuffer()
 {
-	_buffer.resize(_capacity);
 }
 
 RecvBuffer::~RecvBuffer()
 {
+	Release();
 }
 
 
 /**
  * \brief read와 write 커서의 위치를 재설정 하는 함수
+ * \details 미러링 슬랩은 링 버퍼이므로 남은 데이터를 옮기지 않습니다.
+ * \details 선형 슬랩은 쓸 수 있는 공간이 절반보다 작아졌을 때만 남은 잘린 패킷을 앞으로 옮깁니다.
  */
 void RecvBuffer::Clean()
 {
-	int dataSize = DataSize();
-	if (dataSize == 0)
+	if (DataSize() == 0)
 	{
 		_readPos = _writePos = 0;
+
+		// 큰 패킷을 위해 늘린 슬랩은 바로 반납
+		if (_sizeClass > 0)
+		{
+			Release();
+		}
 	}
-	else
+	else if (_mirrored == false && FreeSize() < _capacity / 2)
+	{
+		Compact();
+	}
+}
+
+
+/**
+ * \brief 선형 슬랩의 남은 데이터를 앞으로 옮기는 함수
+ * \details 옮기는 양은 잘린 패킷 하나의 일부로 슬랩 크기보다 작습니다.
+ */
+void RecvBuffer::Compact()
+{
+	const int dataSize = DataSize();
+	memmove(_buffer, ReadPos(), dataSize);
+	_readPos = 0;
+	_writePos = dataSize;
+}
+
+
+/**
+ * \brief packetSize 크기의 패킷을 담을 수 있는 슬랩을 준비하는 함수
+ * \details 슬랩이 없다면 풀에서 빌리고, 작다면 더 큰 슬랩으로 데이터를 옮깁니다.
+ * \param packetSize 버퍼에 온전히 담겨야 하는 패킷의 크기
+ * \return 성공 여부
+ */
+bool RecvBuffer::Reserve(int packetSize)
+{
+	if (_buffer != nullptr && packetSize <= _capacity)
 	{
-		// 여유 공간이 버퍼 1개 크기 미만
-		if (FreeSize() < _bufferSize)
+		// 선형 슬랩에서 잘린 패킷이 끝을 넘는다면 앞으로 옮김
+		if (_mirrored == false && _readPos + packetSize > _capacity)
 		{
-			memcpy(&_buffer[0], &_buffer[_readPos], dataSize);
-			_readPos = 0;
-			_writePos = dataSize;
+			Compact();
 		}
+		return true;
 	}
+
+	int sizeClass = 0;
+	while (GRecvBufferPool->SlabSize(sizeClass) < packetSize)
+	{
+		// 가장 큰 슬랩보다 큰 패킷
+		if (++sizeClass == RecvBufferPool::SIZE_CLASS_COUNT)
+		{
+			return false;
+		}
+	}
+
+	bool mirrored = false;
+	BYTE* buffer = GRecvBufferPool->Pop(sizeClass, OUT mirrored);
+
+	// 처리하지 않은 데이터를 새 슬랩의 앞으로 옮김, 미러링 되어있다면 끝을 넘어도 한번에 복사
+	int dataSize = DataSize();
+	if (dataSize > 0)
+	{
+		memcpy(buffer, ReadPos(), dataSize);
+	}
+	Release();
+
+	_buffer = buffer;
+	_mirrored = mirrored;
+	_sizeClass = sizeClass;
+	_capacity = GRecvBufferPool->SlabSize(sizeClass);
+	_readPos = 0;
+	_writePos = dataSize;
+	return true;
 }
 
 
@@ -48,8 +222,13 @@ bool RecvBuffer::OnRead(int numOfBytes)
 		return false;
 	}
 
-	// read 커서의 위치를 numOfBytes 만큼 이동
+	// read 커서의 위치를 numOfBytes 만큼 이동, 미러링된 뒷부분으로 넘어갔다면 두 커서를 앞으로 되돌림
 	_readPos += numOfBytes;
+	if (_readPos >= _capacity)
+	{
+		_readPos -= _capacity;
+		_writePos -= _capacity;
+	}
 	return true;
 }
 
@@ -71,3 +250,23 @@ bool RecvBuffer::OnWrite(int numOfBytes)
 	_writePos += numOfBytes;
 	return true;
 }
+
+
+/**
+ * \brief 슬랩을 풀에 반납하는 함수
+ * \details 남아있던 데이터는 버려지므로 데이터를 모두 처리한 뒤 호출합니다.
+ */
+void RecvBuffer::Release()
+{
+	if (_buffer == nullptr)
+	{
+		return;
+	}
+
+	GRecvBufferPool->Push(_buffer, _sizeClass, _mirrored);
+	_buffer = nullptr;
+	_mirrored = false;
+	_sizeClass = 0;
+	_capacity = 0;
+	_readPos = _writePos = 0;
+}
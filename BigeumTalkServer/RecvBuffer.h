@@ -1,42 +1,89 @@
 ﻿#pragma once
 
 
+/**
+ * \brief 수신 버퍼 풀 클래스
+ * \details 세션들이 함께 사용하는 수신 버퍼(슬랩)를 크기별로 관리합니다.
+ * \details 큰 슬랩은 같은 메모리를 두번 연속 매핑한 링 버퍼이며, 가장 작은 슬랩과 매핑 단위(Linux 페이지, Windows 64KB)로
+ * 나누어지지 않는 슬랩은 힙에서 할당한 선형 버퍼입니다. 매핑 단위로 올림하지 않으므로 크기 분류가 합쳐지지 않습니다.
+ * \details 미러링 슬랩은 하나에 매핑(VMA) 두개를 쓰므로 MAX_MIRRORED_SLABS개까지만 매핑하고, 넘으면 선형 버퍼를 줍니다.
+ * \details 객체는 Global에서 생성되며, 여러 쓰레드에서 접근 가능한 공용변수가 있기에 lock을 사용합니다.
+ */
+class RecvBufferPool
+{
+public:
+	enum
+	{
+		MIN_SLAB_SIZE = 0x1000, // 가장 작은 슬랩 크기, 대부분의 패킷은 이 크기로 충분
+		SIZE_CLASS_COUNT = 3, // 0x1000, 0x4000, 0x10000 (패킷 최대 크기 0xFFFF를 담을 수 있음)
+		MIN_MIRRORED_SIZE = 0x4000, // 이보다 작은 슬랩은 미러링하지 않음, 남은 잘린 패킷을 옮기는 비용이 작음
+		MAX_MIRRORED_SLABS = 0x2000, // 매핑해 둘 미러링 슬랩 수, VMA 0x4000개로 vm.max_map_count 기본값(65530)의 1/4
+	};
+
+public:
+	RecvBufferPool();
+	~RecvBufferPool();
+
+	BYTE* Pop(int sizeClass, OUT bool& mirrored);
+	void Push(BYTE* slab, int sizeClass, bool mirrored);
+
+	/** \brief 크기 분류에 해당하는 슬랩 크기를 반환하는 함수 \return 슬랩 크기 */
+	int SlabSize(int sizeClass) { return _slabSizes[sizeClass]; }
+
+	/** \brief 매핑되어 있는 미러링 슬랩 수를 반환하는 함수 \return 사용중인 것과 풀에 있는 것을 합한 수 */
+	int MirroredCount() { return _mirroredCount.load(memory_order_relaxed); }
+
+private:
+	mutex _mutex;
+	int _slabSizes[SIZE_CLASS_COUNT] = {};
+	bool _mirrorable[SIZE_CLASS_COUNT] = {}; // 미러링 매핑할 수 있는 크기 분류
+	vector<BYTE*> _mirroredSlabs[SIZE_CLASS_COUNT];
+	vector<BYTE*> _linearSlabs[SIZE_CLASS_COUNT];
+	atomic<int> _mirroredCount = 0; // _mutex 안에서 변경
+};
+
+
 /**
  * \brief 수신 버퍼 클래스
  * \details RecvBuffer 클래스느 다음 정책을 따릅니다.
- * \details 1. 버퍼는 요청한 크기보다 10배 크게 할당 받는다.
- * \details 2. _readPos와 _writePos가 같은 위치라면 두 위치 모두 0으로 이동한다.
- * \details 3. _writePos가 끝에 도달했다면 _readPos와 _writePos를 0부터 시작하도록 이동한다.
+ * \details 1. 버퍼는 처음 수신을 요청할 때 풀에서 가장 작은 슬랩을 빌린다.
+ * \details 2. 잘린 패킷이 슬랩보다 크다면 더 큰 슬랩으로 교체하고, 데이터를 모두 처리하면 작은 슬랩으로 돌아간다.
+ * \details 3. 미러링 슬랩은 링 버퍼이므로 끝을 넘는 데이터도 연속으로 읽고 쓰며, 데이터를 앞으로 옮기지 않는다.
+ * \details 4. 선형 슬랩은 쓸 공간이 절반보다 작아지거나 잘린 패킷이 끝을 넘을 때 남은 데이터를 앞으로 옮긴다.
+ * \details 5. _readPos는 항상 [0, _capacity) 안에 있고 _writePos는 [_readPos, _readPos + _capacity] 안에 있다. 선형 슬랩이라면 _writePos <= _capacity 이다.
  */
 class RecvBuffer
 {
-	enum { BUFFER_COUNT = 10 };
-
 public:
-	RecvBuffer(int bufferSize);
+	RecvBuffer();
 	~RecvBuffer();
 
 	void Clean();
+	bool Reserve(int packetSize);
+	void Release();
 	bool OnRead(int numOfBytes);
 	bool OnWrite(int numOfBytes);
 
-	/** \brief 현재 읽을 위치를 반환하는 함수 \return _readPos */
+	/** \brief 현재 읽을 위치를 반환하는 함수 \return _readPos, 이후 DataSize 만큼 연속으로 읽을 수 있음 */
 	BYTE* ReadPos() { return &_buffer[_readPos]; }
 
-	/** \brief 현재 쓸 위치를 반환하는 함수 \return _writePos */
+	/** \brief 현재 쓸 위치를 반환하는 함수 \return _writePos, 이후 FreeSize 만큼 연속으로 쓸 수 있음 */
 	BYTE* WritePos() { return &_buffer[_writePos]; }
 
 	/** \brief 현재 버퍼에 있는 데이터의 크기를 반환하는 함수 \return 데이터 크기 */
 	int DataSize() { return _writePos - _readPos; }
 
 	/** \brief 현재 데이터를 쓸 수 있는 공간의 크기를 반환하는 함수 \return 쓸 수있는 공간 크기 */
-	int FreeSize() { return _capacity - _writePos; }
+	int FreeSize() { return _mirrored ? _capacity - DataSize() : _capacity - _writePos; }
 
+private:
+	void Compact();
 
 private:
+	BYTE* _buffer = nullptr; // 풀에서 빌린 슬랩, 미러링 슬랩이라면 _capacity * 2 만큼 접근 가능
+	bool _mirrored = false;
+	int _sizeClass = 0;
 	int _capacity = 0;
-	int _bufferSize = 0;
 	int _readPos = 0;
 	int _writePos = 0;
-	vector<BYTE> _buffer;
 };
@@ -1,6 +1,8 @@
 ﻿#include "pch.h"
 #include "Room.h"
 #include "PacketHandler.h"
+#include "PacketCompressor.h"
+#include <optional>
 
 
 Room::Room(shared_ptr<RoomManager> owner, unsigned long long roomId, string roomName, string hostName,
@@ -16,7 +18,8 @@ Room::Room(shared_ptr<RoomManager> owner, unsigned long long roomId, string room
 Room::~Room()
 {
 #ifdef _DEBUG
-	cout << "[ROOM DESTROYED] " << '[' << _roomId << "] " << _roomName << endl;
+	cout << "[ROOM DESTROYED] " << '[' << _roomId << "] " << _roomName << " Dictionary Saved " <<
+		_dictionarySavedBytes.load() << " Bytes" << endl;
 #endif
 }
 
@@ -56,17 +59,11 @@ bool Room::Enter(shared_ptr<User> user)
 		_userCount++;
 	}
 
-	Protocol::S_OTHER_ENTER pkt;
-	auto pUser = new Protocol::User();
-	pUser->set_id(user->userId);
-	pUser->set_nickname(user->nickname);
-	pkt.set_allocated_user(pUser);
-	pkt.set_timestamp(std::chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).
-		count());
-
 	// 입장 알림
-	auto sendBuffer = PacketHandler::MakeBuffer_S_OTHER_ENTER(pkt);
-	Broadcast(sendBuffer);
+	const double timestamp = static_cast<double>(chrono::duration_cast<chrono::seconds>(
+		chrono::system_clock::now().time_since_epoch()).count());
+	auto sendBuffer = PacketCodec::MakeBuffer_S_OTHER_ENTER(user->encodedUser, timestamp);
+	Broadcast(sendBuffer, user->userId);
 
 #ifdef _DEBUG
 	cout << "[USER ENTER ROOM] " << '[' << user->userId << "] " << user->nickname << " To " << '[' << _roomId <<
@@ -106,30 +103,87 @@ void Room::Leave(shared_ptr<User> user)
 	}
 
 	// 퇴장 알림
-	Protocol::S_OTHER_LEAVE pkt;
-	auto pUser = new Protocol::User();
-	pUser->set_id(user->userId);
-	pUser->set_nickname(user->nickname);
-	pkt.set_allocated_user(pUser);
-	pkt.set_timestamp(std::chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).
-		count());
-
-
-	shared_ptr<SendBuffer> sendBuffer = PacketHandler::MakeBuffer_S_OTHER_LEAVE(pkt);
+	const double timestamp = static_cast<double>(chrono::duration_cast<chrono::seconds>(
+		chrono::system_clock::now().time_since_epoch()).count());
+	SendBufferRef sendBuffer = PacketCodec::MakeBuffer_S_OTHER_LEAVE(user->encodedUser, timestamp);
 	Broadcast(sendBuffer);
 }
 
 
 /**
  * \brief 채팅방에 있는 유저 전체에게 메시지를 보내는 함수
+ * \details 압축을 협상한 세션들에게는 한번만 압축한 버퍼를 함께 보냅니다.
  * \param sendBuffer 보낼 메시지
+ * \param introducedUserId 메시지에 ID와 닉네임이 담긴 유저, 유저 사전을 사용하는 세션은 이 유저를 알게 됨
  */
-void Room::Broadcast(shared_ptr<SendBuffer> sendBuffer)
+void Room::Broadcast(SendBufferRef sendBuffer, unsigned long long introducedUserId)
 {
+	BroadcastBuffer buffer(move(sendBuffer));
+
 	shared_lock lock(_sMutex);
 	for (auto& p : _users)
 	{
-		p.second->ownerSession->Send(sendBuffer);
+		auto& session = p.second->ownerSession;
+		session->Send(buffer.For(*session));
+
+		if (introducedUserId != 0 && session->UseUserDictionary())
+		{
+			session->LearnUser(introducedUserId);
+		}
+	}
+}
+
+
+/**
+ * \brief 채팅방에 있는 유저 전체에게 채팅을 보내는 함수
+ * \details 유저 사전을 사용하는 세션에게는 닉네임 대신 userId만 담은 S_CHAT을 보내고, 처음 보는 보낸 유저라면 S_USER_DICTIONARY를 먼저 보냅니다.
+ * \details S_USER_DICTIONARY는 채팅이 아니므로 송신 적체로 버려지지 않아 뒤따르는 채팅의 userId를 항상 풀 수 있습니다.
+ * \details 압축을 협상한 세션에게는 각 버퍼를 한번만 압축하여 보냅니다.
+ * \details 아낀 바이트 수는 사전 패킷 크기를 빼고 _dictionarySavedBytes에 더합니다.
+ * \param sender 보낸 유저
+ * \param msg 채팅 내용
+ * \param timestamp 보낸 시간
+ */
+void Room::BroadcastChat(const shared_ptr<User>& sender, string_view msg, double timestamp)
+{
+	BroadcastBuffer fullBuffer(PacketCodec::MakeBuffer_S_CHAT(sender->encodedUser, msg, timestamp));
+	optional<BroadcastBuffer> compactBuffer; // 유저 사전을 사용하는 세션이 있을 때 만듦
+	SendBufferRef dictionaryBuffer = nullptr; // 보낸 유저를 처음 보는 세션이 있을 때 만듦
+	long long savedBytes = 0;
+
+	shared_lock lock(_sMutex);
+	for (auto& p : _users)
+	{
+		auto& session = p.second->ownerSession;
+		if (session->UseUserDictionary() == false)
+		{
+			session->Send(fullBuffer.For(*session));
+			continue;
+		}
+
+		if (compactBuffer.has_value() == false)
+		{
+			compactBuffer.emplace(PacketCodec::MakeBuffer_S_CHAT_UserId(sender->userId, msg, timestamp));
+		}
+
+		// 처음 보는 유저라면 사전 패킷을 먼저 Send, 보낸 유저의 채팅은 이 스레드에서만 보내므로 다른 채팅이 앞서지 않음
+		if (session->LearnUser(sender->userId))
+		{
+			if (dictionaryBuffer == nullptr)
+			{
+				dictionaryBuffer = PacketCodec::MakeBuffer_S_USER_DICTIONARY(sender->encodedUser);
+			}
+			session->Send(dictionaryBuffer);
+			savedBytes -= dictionaryBuffer->PacketSize();
+		}
+
+		session->Send(compactBuffer->For(*session));
+		savedBytes += static_cast<long long>(fullBuffer.Original()->PacketSize()) - compactBuffer->Original()->PacketSize();
+	}
+
+	if (savedBytes != 0)
+	{
+		_dictionarySavedBytes.fetch_add(savedBytes, memory_order_relaxed);
 	}
 }
 
@@ -213,6 +267,7 @@ vector<RoomData> RoomManager::GetRoomList()
 		roomData.hostName = room.second->GetHostName();
 		roomData.maxUser = room.second->GetRoomMaxUser();
 		roomData.userCount = room.second->GetRoomUserCount();
+		roomData.dictionarySavedBytes = room.second->GetDictionarySavedBytes();
 
 		ret.push_back(roomData);
 	}
@@ -229,6 +284,7 @@ RoomData RoomManager::GetRoomData(unsigned long long roomId)
 	roomData.hostName = _rooms[roomId]->GetHostName();
 	roomData.maxUser = _rooms[roomId]->GetRoomMaxUser();
 	roomData.userCount = _rooms[roomId]->GetRoomUserCount();
+	roomData.dictionarySavedBytes = _rooms[roomId]->GetDictionarySavedBytes();
 
 	return roomData;
 }
@@ -16,7 +16,8 @@ public:
 	     unsigned int maxUser);
 	~Room();
 
-	void Broadcast(shared_ptr<SendBuffer> sendBuffer);
+	void Broadcast(SendBufferRef sendBuffer, unsigned long long introducedUserId = 0);
+	void BroadcastChat(const shared_ptr<User>& sender, string_view msg, double timestamp);
 
 	/** \brief 채팅방 이름을 반환하는 함수 \return _roomName*/
 	string GetRoomName() { return _roomName; }
@@ -33,6 +34,9 @@ public:
 	/** \brief 현재 채팅방에 있는 유저의 수를 반환하는 함수 \return 현재 채팅방에 있는 유저 수*/
 	unsigned int GetRoomUserCount() { return _userCount; }
 
+	/** \brief 유저 사전으로 아낀 송신 바이트 수를 반환하는 함수 \return 사전 패킷 크기를 뺀 _dictionarySavedBytes */
+	long long GetDictionarySavedBytes() { return _dictionarySavedBytes.load(memory_order_relaxed); }
+
 	/** \brief 현재 채팅방의 유저 배욜을 반환하는 함수 */
 	vector<pair<unsigned long long, string>> GetUsersList();
 
@@ -53,6 +57,7 @@ private:
 	unsigned int _maxUser;
 	unsigned int _userCount;
 	unsigned long long _roomId;
+	atomic<long long> _dictionarySavedBytes = 0; // 유저 사전을 사용하는 세션에게 닉네임을 빼고 보낸 바이트 수
 };
 
 
@@ -63,6 +68,7 @@ struct RoomData
 	string hostName;
 	unsigned int maxUser;
 	unsigned int userCount;
+	long long dictionarySavedBytes; // 유저 사전으로 아낀 송신 바이트 수
 };
 
 /**
@@ -1,13 +1,48 @@
 ﻿#include "pch.h"
 #include "SendBuffer.h"
 
-SendBuffer::SendBuffer(shared_ptr<SendBufferChunk> owner, BYTE* buffer, unsigned allocSize)
-	: _buffer(buffer), _allocSize(allocSize), _owner(owner)
+/**
+ * \brief SendBufferMagazine 구조체
+ * \details 쓰레드별로 반납된 청크를 보관하여 전역 풀 접근을 줄입니다. 쓰레드가 종료되면 전역 풀로 돌려줍니다.
+ */
+struct SendBufferMagazine
 {
-}
+	~SendBufferMagazine()
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (GSendBufferManager == nullptr || GSendBufferManager->PushGlobal(chunks[i]) == false)
+			{
+				delete chunks[i];
+			}
+		}
+	}
+
+	SendBufferChunk* chunks[SendBufferManager::MAGAZINE_SIZE];
+	unsigned int count = 0;
+};
+
+/**
+ * \brief SendBufferChunkHolder 구조체
+ * \details 쓰레드가 버퍼를 나눠 주고 있는 청크의 참조를 가집니다. 쓰레드가 종료되면 참조를 해제합니다.
+ */
+struct SendBufferChunkHolder
+{
+	~SendBufferChunkHolder()
+	{
+		if (chunk != nullptr && GSendBufferManager != nullptr)
+		{
+			chunk->ReleaseRef();
+		}
+	}
 
-SendBuffer::~SendBuffer()
+	SendBufferChunk* chunk = nullptr;
+};
+
+namespace
 {
+	thread_local SendBufferMagazine LSendBufferMagazine; // 쓰레드별 반납된 청크
+	thread_local SendBufferChunkHolder LSendBufferChunk; // 쓰레드가 사용중인 청크, 반납된 청크를 매거진이 받도록 매거진보다 먼저 소멸
 }
 
 
@@ -20,10 +55,26 @@ void SendBuffer::Close(unsigned writeSize)
 	// 할당받은 주소보다 더 많이 데이터를 썻다면 ASSERT
 	ASSERT_CRASH(_allocSize >= writeSize);
 	_writeSize = writeSize;
+	_packetSize = writeSize;
 	_owner->Close(writeSize);
 }
 
 
+/**
+ * \brief 체인에 이어진 버퍼 수를 반환하는 함수
+ * \return 자신을 포함하여 이어진 버퍼 수, 체인이 아니라면 1
+ */
+unsigned int SendBuffer::SegmentCount()
+{
+	unsigned int count = 0;
+	for (SendBuffer* segment = this; segment != nullptr; segment = segment->_next)
+	{
+		count++;
+	}
+	return count;
+}
+
+
 SendBufferChunk::SendBufferChunk()
 {
 	_buffer.resize(SEND_BUFFER_CHUNK_SIZE);
@@ -46,13 +97,14 @@ void SendBufferChunk::Reset()
 
 /**
  * \brief 요청한 만큼의 버퍼를 반환하는 함수
+ * \details SendBuffer 객체를 청크의 남은 공간 앞에 만들고 데이터는 그 뒤에 쓰게 합니다.
  * \param allocSize 요청할 버퍼 크기
- * \return allocSize만큼의 쓰기가 가능한 버퍼
+ * \return allocSize만큼의 쓰기가 가능한 버퍼, 남은 공간이 부족하면 nullptr
  */
-shared_ptr<SendBuffer> SendBufferChunk::Open(unsigned allocSize)
+SendBuffer* SendBufferChunk::Open(unsigned allocSize)
 {
 	// 요청한 주소가 청크 크기보다 크거나 청크가 이미 열린 상태면 ASSERT
-	ASSERT_CRASH(allocSize <= SEND_BUFFER_CHUNK_SIZE);
+	ASSERT_CRASH(allocSize <= SEND_BUFFER_CHUNK_SIZE - HEADER_SIZE);
 	ASSERT_CRASH(_open == false);
 
 
@@ -60,88 +112,235 @@ shared_ptr<SendBuffer> SendBufferChunk::Open(unsigned allocSize)
 		return nullptr;
 
 	_open = true;
-	return make_shared<SendBuffer>(shared_from_this(), Buffer(), allocSize);
+	return new(&_buffer[_usedSize]) SendBuffer(this, allocSize);
 }
 
 
 /**
  * \brief 청크에 sendBuffer가 사용한 크기를 기록하는 함수
+ * \details 다음 SendBuffer 객체가 정렬되도록 8바이트 단위로 올려 기록합니다.
  * \param writeSize sendBuffer가 청크를 사용한 크기
  */
 void SendBufferChunk::Close(unsigned writeSize)
 {
 	ASSERT_CRASH(_open == true);
 	_open = false;
-	_usedSize += writeSize;
+	_usedSize += HEADER_SIZE + ((writeSize + 7) & ~7u);
+}
+
+
+/**
+ * \brief 청크의 참조를 줄이는 함수
+ * \details 마지막 참조였다면 청크를 SendBufferManager에 반납합니다. 반납할 때 메모리를 할당하지 않습니다.
+ */
+void SendBufferChunk::ReleaseRef()
+{
+	if (_refCount.fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+		GSendBufferManager->Push(this);
+	}
+}
+
+
+SendBufferManager::SendBufferManager()
+{
+	for (size_t i = 0; i < GLOBAL_POOL_SIZE; i++)
+	{
+		_cells[i].sequence.store(i, memory_order_relaxed);
+		_cells[i].chunk = nullptr;
+	}
+}
+
+SendBufferManager::~SendBufferManager()
+{
+	while (SendBufferChunk* chunk = PopGlobal())
+	{
+		delete chunk;
+	}
 }
 
 
 /**
  * \brief 사용 가능한 SendBuffer를 반환 하는 함수
  * \param size 사용할 SendBuffer의 크기
- * \return size만큼 사용할 수 있는 shared_ptr<SendBuffeR>
+ * \return size만큼 사용할 수 있는 SendBufferRef
  */
-shared_ptr<SendBuffer> SendBufferManager::Open(unsigned size)
+SendBufferRef SendBufferManager::Open(unsigned size)
 {
-	// 청크가 없다면 새 청크를 받고 초기화
-	if (LSendBufferChunk == nullptr)
+	// 청크가 없거나 남은 사용가능한 공간이 요청한 크기보다 작다면 새 청크 받기
+	SendBufferChunk*& chunk = LSendBufferChunk.chunk;
+	if (chunk == nullptr || chunk->FreeSize() < size)
 	{
-		LSendBufferChunk = Pop();
-		LSendBufferChunk->Reset();
+		if (chunk != nullptr)
+		{
+			// 쓰레드가 가지고 있던 참조 해제, 남은 SendBufferRef가 모두 소멸되면 반납됨
+			chunk->ReleaseRef();
+		}
+
+		chunk = Pop();
+		chunk->Reset();
+		chunk->AddRef();
 	}
 
-	ASSERT_CRASH(LSendBufferChunk->IsOpen() == false);
+	ASSERT_CRASH(chunk->IsOpen() == false);
+
+	return SendBufferRef(chunk->Open(size));
+}
+
+
+/**
+ * \brief 한 청크보다 큰 데이터를 담을 SendBuffer 체인을 반환하는 함수
+ * \details 청크마다 최대한 채운 버퍼를 이어 붙이며, 각 버퍼는 요청한 크기로 미리 Close되어 있습니다.
+ * \details 데이터는 반환받은 뒤 체인의 버퍼를 차례로 따라가며 씁니다.
+ * \param size 체인 전체의 크기
+ * \return 체인의 첫 버퍼를 가리키는 SendBufferRef
+ */
+SendBufferRef SendBufferManager::OpenChain(unsigned size)
+{
+	ASSERT_CRASH(size > 0 && size <= MAX_CHAIN_SIZE);
 
-	// 청크의 남은 사용가능한 공간이 요청한 크기보다 작다면 새 청크 받기
-	if (LSendBufferChunk->FreeSize() < size)
+	SendBufferRef head;
+	SendBuffer* tail = nullptr;
+	unsigned int remain = size;
+	while (remain > 0)
 	{
-		LSendBufferChunk = Pop();
-		LSendBufferChunk->Reset();
+		const unsigned int segmentSize = min(remain, static_cast<unsigned int>(MAX_BUFFER_SIZE));
+		SendBufferRef segment = Open(segmentSize);
+		segment->Close(segmentSize);
+		remain -= segmentSize;
+
+		// 이어 붙인 버퍼의 참조는 체인의 첫 버퍼를 가리키는 head가 가짐
+		if (tail == nullptr)
+		{
+			head = move(segment);
+			tail = head.get();
+		}
+		else
+		{
+			tail->_next = segment.Detach();
+			tail = tail->_next;
+		}
 	}
 
-	return LSendBufferChunk->Open(size);
+	head->_packetSize = size;
+	return head;
 }
 
 
 /**
  * \brief 사용 가능한 새 청크를 꺼내는 함수
+ * \details 쓰레드의 매거진, 전역 풀 순서로 꺼내고 모두 비었다면 새로 생성합니다.
  * \return 사용 가능한 청크
  */
-shared_ptr<SendBufferChunk> SendBufferManager::Pop()
+SendBufferChunk* SendBufferManager::Pop()
 {
-	lock_guard<mutex> guard(_mutex);
+	SendBufferMagazine& magazine = LSendBufferMagazine;
+	if (magazine.count > 0)
+	{
+		return magazine.chunks[--magazine.count];
+	}
 
-	// _sendBufferChunks에 청크가 있다면 마지막 것을 반환
-	if (_sendBufferChunks.empty() == false)
+	if (SendBufferChunk* chunk = PopGlobal())
 	{
-		shared_ptr<SendBufferChunk> sendBufferChunk = _sendBufferChunks.back();
-		_sendBufferChunks.pop_back();
-		return sendBufferChunk;
+		return chunk;
 	}
 
-	// PushGlobal을 삭제자로 가지는 새 청크 반환
-	return shared_ptr<SendBufferChunk>(new SendBufferChunk, PushGlobal);
+	return new SendBufferChunk();
 }
 
 
 /**
  * \brief 청크를 반납하는 함수
+ * \details 매거진이 가득 찼다면 절반을 전역 풀로 옮기고, 전역 풀도 가득 찼다면 해제합니다.
  * \param chunk 반납할 청크
  */
-void SendBufferManager::Push(shared_ptr<SendBufferChunk> chunk)
+void SendBufferManager::Push(SendBufferChunk* chunk)
+{
+	SendBufferMagazine& magazine = LSendBufferMagazine;
+	if (magazine.count == MAGAZINE_SIZE)
+	{
+		while (magazine.count > MAGAZINE_SIZE / 2)
+		{
+			SendBufferChunk* moved = magazine.chunks[--magazine.count];
+			if (PushGlobal(moved) == false)
+			{
+				delete moved;
+			}
+		}
+	}
+
+	magazine.chunks[magazine.count++] = chunk;
+}
+
+
+/**
+ * \brief 전역 풀에 청크를 넣는 함수
+ * \param chunk 넣을 청크
+ * \return 성공 여부, 풀이 가득 찼다면 false
+ */
+bool SendBufferManager::PushGlobal(SendBufferChunk* chunk)
 {
-	lock_guard<mutex> guard(_mutex);
-	_sendBufferChunks.push_back(chunk);
+	size_t pos = _pushPos.load(memory_order_relaxed);
+	while (true)
+	{
+		Cell& cell = _cells[pos & (GLOBAL_POOL_SIZE - 1)];
+		const size_t sequence = cell.sequence.load(memory_order_acquire);
+		const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+		if (diff == 0)
+		{
+			// 빈 칸, 자리를 차지한 뒤 청크를 쓰고 꺼낼 수 있는 상태로 표시
+			if (_pushPos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+			{
+				cell.chunk = chunk;
+				cell.sequence.store(pos + 1, memory_order_release);
+				return true;
+			}
+		}
+		else if (diff < 0)
+		{
+			// 아직 꺼내지 않은 칸, 풀이 가득 참
+			return false;
+		}
+		else
+		{
+			// 다른 쓰레드가 먼저 넣음
+			pos = _pushPos.load(memory_order_relaxed);
+		}
+	}
 }
 
 
 /**
- * \brief shared_ptr<SendBufferChunk>의 삭제자 함수
- * \param buffer 소멸될 SendBufferChunk 객체 주소
+ * \brief 전역 풀에서 청크를 꺼내는 함수
+ * \return 꺼낸 청크, 풀이 비었다면 nullptr
  */
-void SendBufferManager::PushGlobal(SendBufferChunk* buffer)
+SendBufferChunk* SendBufferManager::PopGlobal()
 {
-	// 참조가 다해 소멸될 buffer를 소멸 시키지 않고
-	// 이후 다시 사용하도록 함
-	GSendBufferManager->Push(shared_ptr<SendBufferChunk>(buffer, PushGlobal));
+	size_t pos = _popPos.load(memory_order_relaxed);
+	while (true)
+	{
+		Cell& cell = _cells[pos & (GLOBAL_POOL_SIZE - 1)];
+		const size_t sequence = cell.sequence.load(memory_order_acquire);
+		const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+		if (diff == 0)
+		{
+			// 채워진 칸, 자리를 차지한 뒤 청크를 읽고 한바퀴 뒤에 넣을 수 있는 상태로 표시
+			if (_popPos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+			{
+				SendBufferChunk* chunk = cell.chunk;
+				cell.sequence.store(pos + GLOBAL_POOL_SIZE, memory_order_release);
+				return chunk;
+			}
+		}
+		else if (diff < 0)
+		{
+			// 아직 넣지 않은 칸, 풀이 비어있음
+			return nullptr;
+		}
+		else
+		{
+			// 다른 쓰레드가 먼저 꺼냄
+			pos = _popPos.load(memory_order_relaxed);
+		}
+	}
 }
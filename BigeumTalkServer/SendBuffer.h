@@ -6,15 +6,16 @@ class SendBufferChunk;
 /**
  * \brief SendBuffer 클래스
  * \details 사용자가 전달한 데이터가 실질적으로 작성되는 버퍼입니다.
+ * \details 객체는 청크 메모리 안에 데이터 바로 앞에 놓이며 따로 할당되지 않습니다. SendBufferRef를 통해서만 다룹니다.
+ * \details 한 청크보다 큰 패킷은 여러 청크의 SendBuffer를 _next로 이어 붙인 체인으로 담고, 첫 SendBuffer가 체인 전체를 대표합니다.
  */
 class SendBuffer
 {
+	friend class SendBufferChunk;
+	friend class SendBufferManager;
 public:
-	SendBuffer(shared_ptr<SendBufferChunk> owner, BYTE* buffer, unsigned int allocSize);
-	~SendBuffer();
-
-	/** \brief 버퍼의 주소를 반환하는 함수 \return _buffer의 시작 주소 */
-	BYTE* Buffer() { return _buffer; }
+	/** \brief 버퍼의 주소를 반환하는 함수 \return 객체 바로 뒤에 이어지는 데이터의 시작 주소 */
+	BYTE* Buffer() { return reinterpret_cast<BYTE*>(this + 1); }
 
 	/** \brief 버퍼의 할당 크기를 반환하는 함수 \return _allocSize */
 	unsigned int AllocSize() { return _allocSize; }
@@ -22,13 +23,30 @@ public:
 	/** \brief 버퍼에 쓴 데이터의 크기를 반환하는 함수 \return _writeSize */
 	unsigned int WriteSize() { return _writeSize; }
 
+	/** \brief 체인 전체의 데이터 크기를 반환하는 함수 \return 체인의 첫 SendBuffer라면 _packetSize */
+	unsigned int PacketSize() { return _packetSize; }
+
+	/** \brief 체인에서 이어지는 다음 버퍼를 반환하는 함수 \return _next, 마지막 버퍼라면 nullptr */
+	SendBuffer* Next() { return _next; }
+
+	unsigned int SegmentCount();
+
+	/** \brief 버퍼가 속한 청크를 반환하는 함수 \return _owner */
+	SendBufferChunk* Owner() { return _owner; }
+
 	void Close(unsigned int writeSize);
 
 private:
-	BYTE* _buffer;
+	SendBuffer(SendBufferChunk* owner, unsigned int allocSize) : _owner(owner), _allocSize(allocSize)
+	{
+	}
+
+private:
+	SendBufferChunk* _owner; // 참조는 SendBufferRef가 청크 단위로 가짐
+	SendBuffer* _next = nullptr; // 체인으로 이어진 다음 버퍼
 	unsigned int _allocSize = 0;
 	unsigned int _writeSize = 0;
-	shared_ptr<SendBufferChunk> _owner;
+	unsigned int _packetSize = 0; // 체인 전체의 크기, 체인이 아니라면 _writeSize
 };
 
 
@@ -36,8 +54,9 @@ private:
  * \brief SendBufferChunk 클래스
  * \details SendBuffer로 나눌 수 있는 큰 메모리 공간을 가지는 클래스입니다.
  * \details 청크는 쓰레드 별로(TLS) 존재하며 SendBufferManager에 의해 관리됩니다.
+ * \details 청크를 가리키는 SendBufferRef와 현재 청크로 사용중인 쓰레드가 참조를 가지며, 참조가 다하면 SendBufferManager에 반납됩니다.
  */
-class SendBufferChunk : public enable_shared_from_this<SendBufferChunk>
+class SendBufferChunk
 {
 	enum
 	{
@@ -46,19 +65,33 @@ class SendBufferChunk : public enable_shared_from_this<SendBufferChunk>
 
 	friend class SendBufferManager;
 	friend class SendBuffer;
+	friend class SendBufferRef;
+	friend struct SendBufferMagazine;
+	friend struct SendBufferChunkHolder;
 private:
 	SendBufferChunk();
 	~SendBufferChunk();
 
+	/** \brief 청크 안에서 SendBuffer 객체가 차지하는 크기, 데이터가 정렬되도록 8바이트 단위로 맞춤 */
+	static constexpr unsigned int HEADER_SIZE = (sizeof(SendBuffer) + 7) & ~7u;
+
 	void Reset();
-	shared_ptr<SendBuffer> Open(unsigned int allocSize);
+	SendBuffer* Open(unsigned int allocSize);
 	void Close(unsigned int writeSize);
 
+	/* 참조 */
+	void AddRef() { _refCount.fetch_add(1, memory_order_relaxed); }
+	void ReleaseRef();
+
 	/** \brief 현재 사용 가능한 버퍼의 첫 주소를 반환합니다. \return &_buffer[_usedSize] */
 	BYTE* Buffer() { return &_buffer[_usedSize]; }
 
-	/** \brief 청크에 남은 사용 가능한 크기를 반환합니다. \return 청크에서 사용 가능한 크기 */
-	unsigned int FreeSize() { return _buffer.size() - _usedSize; }
+	/** \brief 청크에 남은 데이터를 쓸 수 있는 크기를 반환합니다. \return SendBuffer 객체 자리를 뺀 사용 가능한 크기 */
+	unsigned int FreeSize()
+	{
+		const unsigned int remain = static_cast<unsigned int>(_buffer.size()) - _usedSize;
+		return remain > HEADER_SIZE ? remain - HEADER_SIZE : 0;
+	}
 
 	/** \brief 청크가 열린 상태인지 여부를 반환합니다. \return _open */
 	bool IsOpen() { return _open; }
@@ -67,24 +100,141 @@ private:
 	vector<BYTE> _buffer;
 	unsigned int _usedSize = 0;
 	bool _open;
+	atomic<int> _refCount = 0;
+};
+
+
+/**
+ * \brief SendBufferRef 클래스
+ * \details 청크 안의 SendBuffer를 가리키는 핸들입니다. SendBufferRef처럼 복사하여 여러 세션에 전달합니다.
+ * \details 버퍼마다 참조를 두지 않고 복사, 소멸될 때 청크의 참조만 늘리고 줄이므로 패킷마다 힙 할당이 없습니다.
+ * \details 체인이라면 이어진 버퍼의 청크마다 참조를 가집니다.
+ */
+class SendBufferRef
+{
+public:
+	SendBufferRef() = default;
+	SendBufferRef(nullptr_t) {}
+	~SendBufferRef() { Release(); }
+
+	/** \brief Open으로 받은 버퍼를 가리키며 체인의 청크마다 참조를 늘리는 생성자 */
+	explicit SendBufferRef(SendBuffer* sendBuffer) : _sendBuffer(sendBuffer)
+	{
+		for (SendBuffer* segment = _sendBuffer; segment != nullptr; segment = segment->Next())
+			segment->Owner()->AddRef();
+	}
+
+	SendBufferRef(const SendBufferRef& other) : SendBufferRef(other._sendBuffer) {}
+	SendBufferRef(SendBufferRef&& other) noexcept : _sendBuffer(other._sendBuffer) { other._sendBuffer = nullptr; }
+
+	SendBufferRef& operator=(const SendBufferRef& other)
+	{
+		SendBufferRef(other).Swap(*this);
+		return *this;
+	}
+
+	SendBufferRef& operator=(SendBufferRef&& other) noexcept
+	{
+		SendBufferRef(move(other)).Swap(*this);
+		return *this;
+	}
+
+	SendBufferRef& operator=(nullptr_t)
+	{
+		Release();
+		return *this;
+	}
+
+	SendBuffer* operator->() const { return _sendBuffer; }
+	SendBuffer* get() const { return _sendBuffer; }
+	bool operator==(nullptr_t) const { return _sendBuffer == nullptr; }
+	bool operator!=(nullptr_t) const { return _sendBuffer != nullptr; }
+
+private:
+	friend class SendBufferManager;
+
+	void Swap(SendBufferRef& other) noexcept { swap(_sendBuffer, other._sendBuffer); }
+
+	/** \brief 참조를 줄이지 않고 버퍼를 놓는 함수, 참조는 체인을 이어 받은 쪽이 가짐 \return 놓은 버퍼 */
+	SendBuffer* Detach()
+	{
+		SendBuffer* sendBuffer = _sendBuffer;
+		_sendBuffer = nullptr;
+		return sendBuffer;
+	}
+
+	void Release()
+	{
+		// 참조를 줄인 청크는 재사용될 수 있으므로 다음 버퍼를 먼저 읽음
+		SendBuffer* segment = _sendBuffer;
+		_sendBuffer = nullptr;
+		while (segment != nullptr)
+		{
+			SendBuffer* next = segment->Next();
+			segment->Owner()->ReleaseRef();
+			segment = next;
+		}
+	}
+
+private:
+	SendBuffer* _sendBuffer = nullptr;
 };
 
 
 /**
  * \brief SendBufferMananger 클래스
- * \details 청크를 관리하는 클래스 입니다. 객체는 Global에서 생성되며, 여러 쓰레드에서 접근 가능한 공용변수가 있기에 lock을 사용합니다.
+ * \details 청크를 관리하는 클래스 입니다. 객체는 Global에서 생성됩니다.
+ * \details 반납된 청크는 먼저 쓰레드별 매거진에 보관하고, 매거진이 차면 절반을 lock-free 전역 풀로 옮깁니다.
+ * \details 전역 풀은 크기가 고정된 MPMC 링 큐이며, 가득 차면 더 반납된 청크는 해제하여 메모리를 돌려줍니다.
+ * \details 한 청크에 담을 수 있는 크기까지는 Open으로 연속된 버퍼를, 그보다 크면 OpenChain으로 여러 청크에 걸친 체인을 받습니다.
  */
 class SendBufferManager
 {
 public:
-	shared_ptr<SendBuffer> Open(unsigned int size);
+	enum
+	{
+		GLOBAL_POOL_SIZE = 1024, // 전역 풀에 보관할 최대 청크 수 (2의 거듭제곱), 넘으면 해제
+		MAGAZINE_SIZE = 16, // 쓰레드별로 보관할 최대 청크 수
+	};
+
+	/** \brief Open으로 받을 수 있는 가장 큰 연속 버퍼 크기 */
+	static constexpr unsigned int MAX_BUFFER_SIZE = SendBufferChunk::SEND_BUFFER_CHUNK_SIZE - SendBufferChunk::HEADER_SIZE;
+
+	/** \brief 체인에 이을 수 있는 최대 버퍼 수, 체인은 한번의 송신에 모두 담겨야 하므로 SendEvent의 버퍼 수를 넘지 않음 */
+	static constexpr unsigned int MAX_CHAIN_COUNT = 64;
+
+	/** \brief OpenChain으로 받을 수 있는 가장 큰 크기 */
+	static constexpr unsigned int MAX_CHAIN_SIZE = MAX_CHAIN_COUNT * MAX_BUFFER_SIZE;
+
+	SendBufferManager();
+	~SendBufferManager();
+
+	SendBufferRef Open(unsigned int size);
+	SendBufferRef OpenChain(unsigned int size);
 
 private:
-	shared_ptr<SendBufferChunk> Pop();
-	void Push(shared_ptr<SendBufferChunk> chunk);
-	static void PushGlobal(SendBufferChunk* buffer);
+	friend class SendBufferChunk;
+	friend struct SendBufferMagazine;
+
+	SendBufferChunk* Pop();
+	void Push(SendBufferChunk* chunk);
+
+	/* 전역 풀 */
+	bool PushGlobal(SendBufferChunk* chunk);
+	SendBufferChunk* PopGlobal();
 
 private:
-	mutex _mutex;
-	vector<shared_ptr<SendBufferChunk>> _sendBufferChunks;
+	/**
+	 * \brief 전역 풀의 칸
+	 * \details sequence로 칸의 상태를 구분하여 lock 없이 넣고 꺼냅니다. (Dmitry Vyukov의 bounded MPMC queue)
+	 */
+	struct Cell
+	{
+		atomic<size_t> sequence;
+		SendBufferChunk* chunk;
+	};
+
+	Cell _cells[GLOBAL_POOL_SIZE];
+	alignas(64) atomic<size_t> _pushPos = 0;
+	alignas(64) atomic<size_t> _popPos = 0;
 };
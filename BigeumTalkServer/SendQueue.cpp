@@ -0,0 +1,260 @@
+﻿#include "pch.h"
+#include "SendQueue.h"
+
+/**
+ * \brief SendNodeMagazine 구조체
+ * \details 쓰레드별로 반납된 노드를 보관하여 전역 풀 접근을 줄입니다.
+ * \details 노드를 꺼내고 넣는 묶음(current)과 가득 찬 예비 묶음(full)을 두어, 반납과 재사용이 번갈아도 전역 풀에 한 묶음씩만 오가게 합니다.
+ * \details 쓰레드가 종료되면 가득 찬 묶음은 전역 풀로 돌려주고 나머지는 해제합니다.
+ */
+struct SendNodeMagazine
+{
+	~SendNodeMagazine()
+	{
+		if (full != nullptr && (GSendNodePool == nullptr || GSendNodePool->PushGlobal(full) == false))
+		{
+			SendNodePool::DeleteBatch(full);
+		}
+		SendNodePool::DeleteBatch(current);
+	}
+
+	SendNode* current = nullptr; // next로 이어진 노드
+	unsigned int count = 0; // current의 노드 수
+	SendNode* full = nullptr; // BATCH_SIZE개가 이어진 묶음
+};
+
+namespace
+{
+	thread_local SendNodeMagazine LSendNodeMagazine; // 쓰레드별 반납된 노드
+}
+
+
+SendQueue::SendQueue()
+{
+	SendNode* stub = GSendNodePool->Pop();
+	_head.store(stub);
+	_tail.store(stub);
+}
+
+SendQueue::~SendQueue()
+{
+	while (Pop() != nullptr)
+	{
+	}
+	GSendNodePool->Push(_tail.load());
+}
+
+
+/**
+ * \brief 큐에 SendBuffer를 넣는 함수
+ * \details 여러 스레드에서 동시에 호출할 수 있습니다.
+ * \param sendBuffer 넣을 SendBuffer
+ */
+void SendQueue::Push(SendBufferRef sendBuffer)
+{
+	SendNode* node = GSendNodePool->Pop();
+	node->sendBuffer = move(sendBuffer);
+
+	// 새 노드를 마지막 노드로 교체한 뒤 이전 마지막 노드에 연결
+	SendNode* prev = _head.exchange(node, memory_order_acq_rel);
+	prev->next.store(node, memory_order_release);
+}
+
+
+/**
+ * \brief 큐에서 SendBuffer를 꺼내는 함수
+ * \details 한번에 하나의 스레드만 호출해야 합니다.
+ * \return 꺼낸 SendBuffer. 비어있거나 아직 연결 중인 노드뿐이라면 nullptr
+ */
+SendBufferRef SendQueue::Pop()
+{
+	SendNode* tail = _tail.load(memory_order_relaxed);
+	SendNode* next = tail->next.load(memory_order_acquire);
+	if (next == nullptr)
+	{
+		return nullptr;
+	}
+
+	// 꺼낸 노드가 새 더미 노드가 되고, 이전 더미 노드는 풀에 반납
+	_tail.store(next, memory_order_release);
+	GSendNodePool->Push(tail);
+
+	return move(next->sendBuffer);
+}
+
+
+/**
+ * \brief 큐가 비었는지 확인하는 함수
+ * \details 노드를 참조하지 않으므로 어느 스레드에서든 호출할 수 있습니다. 연결 중인 노드가 있어도 비어있지 않다고 판단합니다.
+ * \return 큐가 비었는지 여부
+ */
+bool SendQueue::Empty()
+{
+	return _head.load(memory_order_acquire) == _tail.load(memory_order_acquire);
+}
+
+
+SendNodePool::SendNodePool()
+{
+	for (size_t i = 0; i < GLOBAL_POOL_SIZE; i++)
+	{
+		_cells[i].sequence.store(i, memory_order_relaxed);
+		_cells[i].batch = nullptr;
+	}
+}
+
+SendNodePool::~SendNodePool()
+{
+	while (SendNode* batch = PopGlobal())
+	{
+		DeleteBatch(batch);
+	}
+}
+
+
+/**
+ * \brief 사용 가능한 노드를 꺼내는 함수
+ * \details 쓰레드의 매거진, 예비 묶음, 전역 풀 순서로 꺼내고 모두 비었다면 새로 생성합니다.
+ * \return next와 sendBuffer가 비어있는 노드
+ */
+SendNode* SendNodePool::Pop()
+{
+	SendNodeMagazine& magazine = LSendNodeMagazine;
+	if (magazine.count == 0)
+	{
+		if (magazine.full != nullptr)
+		{
+			magazine.current = magazine.full;
+			magazine.full = nullptr;
+		}
+		else
+		{
+			magazine.current = PopGlobal();
+			if (magazine.current == nullptr)
+			{
+				return new SendNode();
+			}
+		}
+		magazine.count = BATCH_SIZE;
+	}
+
+	SendNode* node = magazine.current;
+	magazine.current = node->next.load(memory_order_relaxed);
+	magazine.count--;
+
+	node->next.store(nullptr, memory_order_relaxed);
+	return node;
+}
+
+
+/**
+ * \brief 노드를 반납하는 함수
+ * \details 매거진의 묶음이 가득 찼다면 예비 묶음으로 돌리고, 이미 예비 묶음이 있다면 그것을 전역 풀로 옮깁니다. 전역 풀도 가득 찼다면 해제합니다.
+ * \param node 반납할 노드, sendBuffer는 이미 꺼내져 있어야 함
+ */
+void SendNodePool::Push(SendNode* node)
+{
+	SendNodeMagazine& magazine = LSendNodeMagazine;
+	if (magazine.count == BATCH_SIZE)
+	{
+		if (magazine.full != nullptr && PushGlobal(magazine.full) == false)
+		{
+			DeleteBatch(magazine.full);
+		}
+		magazine.full = magazine.current;
+		magazine.current = nullptr;
+		magazine.count = 0;
+	}
+
+	node->next.store(magazine.current, memory_order_relaxed);
+	magazine.current = node;
+	magazine.count++;
+}
+
+
+/**
+ * \brief 전역 풀에 노드 묶음을 넣는 함수
+ * \param batch 넣을 묶음
+ * \return 성공 여부, 풀이 가득 찼다면 false
+ */
+bool SendNodePool::PushGlobal(SendNode* batch)
+{
+	size_t pos = _pushPos.load(memory_order_relaxed);
+	while (true)
+	{
+		Cell& cell = _cells[pos & (GLOBAL_POOL_SIZE - 1)];
+		const size_t sequence = cell.sequence.load(memory_order_acquire);
+		const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+		if (diff == 0)
+		{
+			// 빈 칸, 자리를 차지한 뒤 묶음을 쓰고 꺼낼 수 있는 상태로 표시
+			if (_pushPos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+			{
+				cell.batch = batch;
+				cell.sequence.store(pos + 1, memory_order_release);
+				return true;
+			}
+		}
+		else if (diff < 0)
+		{
+			// 아직 꺼내지 않은 칸, 풀이 가득 참
+			return false;
+		}
+		else
+		{
+			// 다른 쓰레드가 먼저 넣음
+			pos = _pushPos.load(memory_order_relaxed);
+		}
+	}
+}
+
+
+/**
+ * \brief 전역 풀에서 노드 묶음을 꺼내는 함수
+ * \return 꺼낸 묶음, 풀이 비었다면 nullptr
+ */
+SendNode* SendNodePool::PopGlobal()
+{
+	size_t pos = _popPos.load(memory_order_relaxed);
+	while (true)
+	{
+		Cell& cell = _cells[pos & (GLOBAL_POOL_SIZE - 1)];
+		const size_t sequence = cell.sequence.load(memory_order_acquire);
+		const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+		if (diff == 0)
+		{
+			// 채워진 칸, 자리를 차지한 뒤 묶음을 읽고 한바퀴 뒤에 넣을 수 있는 상태로 표시
+			if (_popPos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+			{
+				SendNode* batch = cell.batch;
+				cell.sequence.store(pos + GLOBAL_POOL_SIZE, memory_order_release);
+				return batch;
+			}
+		}
+		else if (diff < 0)
+		{
+			// 아직 넣지 않은 칸, 풀이 비어있음
+			return nullptr;
+		}
+		else
+		{
+			// 다른 쓰레드가 먼저 꺼냄
+			pos = _popPos.load(memory_order_relaxed);
+		}
+	}
+}
+
+
+/**
+ * \brief next로 이어진 노드를 모두 해제하는 함수
+ * \param batch 해제할 첫 노드
+ */
+void SendNodePool::DeleteBatch(SendNode* batch)
+{
+	while (batch != nullptr)
+	{
+		SendNode* next = batch->next.load(memory_order_relaxed);
+		delete batch;
+		batch = next;
+	}
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+class SendBufferRef;
+
+
+/**
+ * \brief SendQueue 노드 구조체
+ * \details 하나의 SendBuffer가 여러 세션에 전송되므로 노드를 SendBuffer에 두지 않고 큐에 넣을 때마다 SendNodePool에서 받습니다.
+ */
+struct SendNode
+{
+	atomic<SendNode*> next = nullptr; // 풀에 보관 중일 때는 같은 묶음의 다음 노드
+	SendBufferRef sendBuffer = nullptr;
+};
+
+
+/**
+ * \brief SendQueue 클래스
+ * \details 여러 스레드가 Push하고 하나의 스레드만 Pop하는 lock-free 큐입니다. (MPSC)
+ * \details _head는 마지막으로 들어온 노드, _tail은 이미 꺼낸 더미 노드이며 꺼낼 데이터는 _tail 다음부터 있습니다.
+ * \details 노드는 SendNodePool에서 받고 돌려주므로 풀이 채워진 뒤에는 Push, Pop에 힙 할당이 없습니다.
+ */
+class SendQueue
+{
+public:
+	SendQueue();
+	~SendQueue();
+
+	void Push(SendBufferRef sendBuffer);
+	SendBufferRef Pop();
+	bool Empty();
+
+private:
+	atomic<SendNode*> _head; // 생산자 스레드들이 교체
+	atomic<SendNode*> _tail; // 소비자 스레드만 교체
+};
+
+
+/**
+ * \brief SendNodePool 클래스
+ * \details SendQueue 노드를 재사용하는 풀입니다. 객체는 Global에서 생성됩니다.
+ * \details 노드는 Push한 쓰레드가 받고 Pop한 쓰레드가 반납하므로 쓰레드 사이를 흘러갑니다.
+ * \details 반납된 노드는 쓰레드별 매거진에 BATCH_SIZE개씩 묶어 보관하고, 묶음이 넘치면 전역 풀로 옮깁니다.
+ * \details 전역 풀은 SendBufferManager와 같은 크기가 고정된 MPMC 링 큐이며 칸마다 노드 묶음 하나를 담습니다. 가득 차면 더 반납된 묶음은 해제합니다.
+ */
+class SendNodePool
+{
+public:
+	enum
+	{
+		BATCH_SIZE = 64, // 매거진과 전역 풀이 주고받는 노드 묶음의 크기
+		GLOBAL_POOL_SIZE = 256, // 전역 풀에 보관할 최대 묶음 수 (2의 거듭제곱), 넘으면 해제
+	};
+
+	SendNodePool();
+	~SendNodePool();
+
+	SendNode* Pop();
+	void Push(SendNode* node);
+
+private:
+	friend struct SendNodeMagazine;
+
+	/* 전역 풀 */
+	bool PushGlobal(SendNode* batch);
+	SendNode* PopGlobal();
+
+	static void DeleteBatch(SendNode* batch);
+
+private:
+	/**
+	 * \brief 전역 풀의 칸
+	 * \details sequence로 칸의 상태를 구분하여 lock 없이 넣고 꺼냅니다. (Dmitry Vyukov의 bounded MPMC queue)
+	 */
+	struct Cell
+	{
+		atomic<size_t> sequence;
+		SendNode* batch; // next로 이어진 BATCH_SIZE개의 노드
+	};
+
+	Cell _cells[GLOBAL_POOL_SIZE];
+	alignas(64) atomic<size_t> _pushPos = 0;
+	alignas(64) atomic<size_t> _popPos = 0;
+};
@@ -4,8 +4,15 @@
 #include "Session.h"
 
 Service::Service(shared_ptr<Iocp> iocp, wstring ip, unsigned short port)
-	: _iocp(iocp)
+	: Service(vector<shared_ptr<Iocp>>{iocp}, ip, port)
 {
+}
+
+Service::Service(vector<shared_ptr<Iocp>> iocps, wstring ip, unsigned short port)
+	: _iocps(iocps), _sessionPools(iocps.size()), _loggedBatchHistograms(iocps.size())
+{
+	ASSERT_CRASH(_iocps.empty() == false);
+
 	_address.sin_family = AF_INET;
 	_address.sin_port = htons(port);
 	InetPtonW(AF_INET, ip.c_str(), &_address.sin_addr);
@@ -17,8 +24,18 @@ Service::~Service()
 {
 	WSACleanup();
 	_sessions.clear();
-	_iocp = nullptr;
-	_listener = nullptr;
+	_listeners.clear();
+
+	for (vector<Session*>& sessionPool : _sessionPools)
+	{
+		for (Session* session : sessionPool)
+		{
+			delete session;
+		}
+	}
+	_sessionPools.clear();
+
+	_iocps.clear();
 }
 
 
@@ -28,17 +45,31 @@ Service::~Service()
  */
 bool Service::Start()
 {
-	// 리슨 소켓 생성
-	_listener = make_shared<Listener>();
-	if (_listener == nullptr)
-	{
-		return false;
-	}
+#ifdef _WIN32
+	// AcceptEx 완료는 리슨 소켓의 CP로 오므로 리슨 소켓 하나가 세션을 샤드에 나눠 배정
+	// 리슨 소켓은 0번 샤드의 Iocp에 등록되므로 모든 AcceptEx 완료와 함께 받은 첫 패킷 처리는 0번 샤드의 워커 스레드에서 실행됨
+	// 세션의 이후 IO 완료는 배정된 샤드의 Iocp로 옴
+	const unsigned int listenerCount = 1;
+#else
+	// SO_REUSEPORT로 샤드마다 리슨 소켓을 두고 커널이 연결을 분산
+	const unsigned int listenerCount = GetShardCount();
+#endif
 
-	// 리슨 소켓 Accept 시작
-	if (_listener->StartAccept(shared_from_this()) == false)
+	for (unsigned int shard = 0; shard < listenerCount; shard++)
 	{
-		return false;
+		// 리슨 소켓 생성
+		auto listener = make_shared<Listener>();
+		if (listener == nullptr)
+		{
+			return false;
+		}
+
+		// 리슨 소켓 Accept 시작
+		if (listener->StartAccept(shared_from_this(), shard) == false)
+		{
+			return false;
+		}
+		_listeners.push_back(listener);
 	}
 
 	cout << "[SERVER STARTED]" << endl;
@@ -47,18 +78,151 @@ bool Service::Start()
 }
 
 
+/**
+ * \brief 샤드의 워커 스레드에서 주기적으로 호출되는 함수
+ * \details 해당 샤드에 등록된 리슨 소켓의 첫 데이터 대기 시간과 접속률을 확인합니다.
+ * \details 0번 샤드는 METRICS_LOG_SECONDS마다 송신 적체 집계와 샤드별 완료 패킷 배치 히스토그램도 출력합니다.
+ * \param shard 호출한 워커 스레드의 샤드 번호
+ */
+void Service::Tick(unsigned int shard)
+{
+	for (shared_ptr<Listener>& listener : _listeners)
+	{
+		if (listener->GetShard() == shard)
+		{
+			listener->CheckAcceptTimeout();
+			listener->UpdateAcceptRate();
+		}
+	}
+
+	if (shard == 0)
+	{
+		const auto now = chrono::steady_clock::now();
+		if (now - _metricsLogTime >= chrono::seconds(METRICS_LOG_SECONDS))
+		{
+			_metricsLogTime = now;
+			LogSendMetrics();
+			LogBatchHistograms();
+		}
+	}
+}
+
+
+/**
+ * \brief 송신 적체 정책이 동작한 횟수를 출력하는 함수
+ * \details 지난 출력 이후 정책이 동작했을 때만 누적 횟수를 출력합니다.
+ */
+void Service::LogSendMetrics()
+{
+	const unsigned long long disconnect = GSendMetrics->disconnectCount.load(memory_order_relaxed);
+	const unsigned long long dropOldestChat = GSendMetrics->dropOldestChatCount.load(memory_order_relaxed);
+	const unsigned long long dropNewChat = GSendMetrics->dropNewChatCount.load(memory_order_relaxed);
+	const unsigned long long oversizeDisconnect = GSendMetrics->oversizeDisconnectCount.load(memory_order_relaxed);
+
+	const unsigned long long total = disconnect + dropOldestChat + dropNewChat + oversizeDisconnect;
+	if (total == _loggedSendActions)
+	{
+		return;
+	}
+	_loggedSendActions = total;
+
+	cout << "[SEND METRICS] Disconnect " << disconnect << " DropOldestChat " << dropOldestChat << " DropNewChat " << dropNewChat <<
+		" OversizeDisconnect " << oversizeDisconnect << endl;
+}
+
+
+/**
+ * \brief 샤드별로 Dispatch 한번에 처리한 완료 패킷 수의 분포를 출력하는 함수
+ * \details 지난 출력 이후 늘어난 만큼을 0, 1, 2-3, 4-7 ... 처럼 2의 거듭제곱 구간으로 묶어 출력합니다. 0은 완료 패킷 없이 깨어난 횟수입니다.
+ * \details 지난 출력 이후 완료 패킷이 없던 샤드는 출력하지 않습니다.
+ */
+void Service::LogBatchHistograms()
+{
+	for (unsigned int shard = 0; shard < GetShardCount(); shard++)
+	{
+		const vector<unsigned long long> histogram = _iocps[shard]->GetBatchHistogram();
+		vector<unsigned long long>& logged = _loggedBatchHistograms[shard];
+		logged.resize(histogram.size());
+
+		unsigned long long completions = 0;
+		for (size_t count = 0; count < histogram.size(); count++)
+		{
+			completions += (histogram[count] - logged[count]) * count;
+		}
+
+		if (completions > 0)
+		{
+			cout << "[DISPATCH BATCH] Shard " << shard << " Completions " << completions << " Dispatches";
+
+			size_t begin = 0;
+			while (begin < histogram.size())
+			{
+				const size_t end = begin == 0 ? 1 : min(begin * 2, histogram.size());
+				unsigned long long dispatches = 0;
+				for (size_t count = begin; count < end; count++)
+				{
+					dispatches += histogram[count] - logged[count];
+				}
+
+				if (end - begin == 1)
+				{
+					cout << ' ' << begin << ':' << dispatches;
+				}
+				else
+				{
+					cout << ' ' << begin << '-' << end - 1 << ':' << dispatches;
+				}
+				begin = end;
+			}
+			cout << endl;
+		}
+
+		logged = histogram;
+	}
+}
+
+
 /**
  * \brief 세션 생성 함수
+ * \param shard 세션을 등록할 샤드 번호
  * \return 생성된 빈 세션
  */
-shared_ptr<Session> Service::CreateSession()
+shared_ptr<Session> Service::CreateSession(unsigned int shard)
 {
 	// 세션 생성 함수
 
-	auto session = make_shared<Session>();
+	Session* recycled = nullptr;
+	{
+		// 샤드의 세션 풀에 반납된 세션이 있다면 재사용
+		lock_guard<mutex> guard(_mutexPool);
+		vector<Session*>& sessionPool = _sessionPools[shard];
+		if (sessionPool.empty() == false)
+		{
+			recycled = sessionPool.back();
+			sessionPool.pop_back();
+		}
+	}
+
+	// PushSession을 삭제자로 가지는 세션 생성
+	shared_ptr<Session> session(recycled != nullptr ? recycled : new Session(), PushSession);
+
+	// 재사용한 세션에도 현재 설정 적용
+	session->SetZeroByteRecv(_sessionConfig.zeroByteRecv);
+	session->SetSendLimit(_sessionConfig.maxSendSegments, _sessionConfig.maxSendBytes);
+	session->SetSendPolicy(_sessionConfig.sendPolicy, _sessionConfig.maxPendingBytes, _sessionConfig.maxPendingCount);
+
+#ifdef _WIN32
+	// TF_REUSE_SOCKET으로 끊은 소켓은 이미 샤드의 CP에 연결되어 있음
+	if (recycled != nullptr)
+	{
+		return session;
+	}
+#endif
+
 	session->SetService(shared_from_this());
+	session->_shard = shard;
 
-	if (_iocp->Register(session) == false)
+	if (_iocps[shard]->Register(session) == false)
 	{
 		return nullptr;
 	}
@@ -67,6 +231,40 @@ shared_ptr<Session> Service::CreateSession()
 }
 
 
+/**
+ * \brief shared_ptr<Session>의 삭제자 함수
+ * \details 연결 종료가 완료된 세션은 소멸시키지 않고 초기화하여 샤드의 세션 풀에 반납합니다.
+ * \details 풀이 MAX_POOLED_SESSIONS개로 가득 찼다면 접속이 몰린 뒤 줄어든 것이므로 해제합니다.
+ * \param session 모든 참조가 해제된 세션 객체 주소
+ */
+void Service::PushSession(Session* session)
+{
+	shared_ptr<Service> service = session->GetService();
+	if (service == nullptr || session->_recyclable == false)
+	{
+		delete session;
+		return;
+	}
+
+	bool full = false;
+	{
+		lock_guard<mutex> guard(service->_mutexPool);
+		full = service->_sessionPools[session->_shard].size() >= MAX_POOLED_SESSIONS;
+	}
+
+	if (full)
+	{
+		delete session;
+		return;
+	}
+
+	session->Reset();
+
+	lock_guard<mutex> guard(service->_mutexPool);
+	service->_sessionPools[session->_shard].push_back(session);
+}
+
+
 /**
  * \brief 연결된 세션을 서비스에 등록하는 함수
  * \param session 연결이 완료된 세션
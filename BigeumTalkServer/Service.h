@@ -10,46 +10,84 @@
  * \brief Service 클래스 \n
  * \details 서버의 서비스를 담당하는 클래스입니다.
  * \details 연결된 세션 정보 및 컨텐츠 정보 등 을 가지고 있습니다.
+ * \details 여러 Iocp를 샤드로 가지면 세션은 생성될 때 배정된 샤드의 워커 스레드에서만 처리됩니다.
  */
 class Service : public enable_shared_from_this<Service>
 {
 public:
+	enum
+	{
+		MAX_POOLED_SESSIONS = 1024, // 샤드마다 세션 풀에 보관할 최대 세션 수, 넘는 세션은 해제
+		METRICS_LOG_SECONDS = 10, // 송신 적체 집계와 배치 히스토그램을 확인하여 출력하는 간격
+	};
+
 	Service(shared_ptr<Iocp> iocp, wstring ip, unsigned short port);
+	Service(vector<shared_ptr<Iocp>> iocps, wstring ip, unsigned short port);
 	~Service();
 
 	bool Start();
+	void Tick(unsigned int shard);
 
 	/* 세션 생성/소멸 */
-	shared_ptr<Session> CreateSession();
+	shared_ptr<Session> CreateSession(unsigned int shard = 0);
 	void AddSession(shared_ptr<Session> session);
 	void ReleaseSession(shared_ptr<Session> session);
 
+	static void PushSession(Session* session);
+
 	/* 로그인 */
 	bool UseNickname(string nickname);
 	void ReleaseNickname(string nickname);
 	bool IsExistNickname(string nickname);
 
-	/** \brief shared_ptr<Iocp> 반환 함수 \return _iocp */
-	shared_ptr<Iocp> GetIocp() { return _iocp; }
+	/** \brief 샤드의 shared_ptr<Iocp> 반환 함수 \param shard 샤드 번호 \return _iocps[shard] */
+	shared_ptr<Iocp> GetIocp(unsigned int shard = 0) { return _iocps[shard]; }
+
+	/** \brief 샤드(Iocp) 개수 반환 함수 \return _iocps의 크기 */
+	unsigned int GetShardCount() { return static_cast<unsigned int>(_iocps.size()); }
 
 	/** \brief 해당 세션의 소켓 주소 반환 함수 \return _address */
 	SOCKADDR_IN& GetSockAddr() { return _address; }
 
+	/** \brief 리슨 소켓의 Accept 설정 반환 함수 \return _acceptConfig */
+	const AcceptConfig& GetAcceptConfig() { return _acceptConfig; }
+
+	/** \brief 리슨 소켓의 Accept 설정 함수, Start 전에 호출 */
+	void SetAcceptConfig(const AcceptConfig& config) { _acceptConfig = config; }
+
+	/** \brief 세션 설정 반환 함수 \return _sessionConfig */
+	const SessionConfig& GetSessionConfig() { return _sessionConfig; }
+
+	/** \brief 세션 설정 함수, Start 전에 호출 */
+	void SetSessionConfig(const SessionConfig& config) { _sessionConfig = config; }
+
 	/** \brief 해당 세션의 룸 매니저 반환 함수 \return _roomManager */
 	shared_ptr<RoomManager> GetRoomManager() { return _roomManager; }
 
 private:
-	mutex _mutexSession, _mutexNickname;
+	void LogSendMetrics();
+	void LogBatchHistograms();
 
-	shared_ptr<Iocp> _iocp;
+private:
+	mutex _mutexSession, _mutexNickname, _mutexPool;
+
+	vector<shared_ptr<Iocp>> _iocps; // 샤드별 Iocp, 세션은 하나의 샤드에서만 처리됨
 	SOCKADDR_IN _address;
-	shared_ptr<Listener> _listener = nullptr;
+	vector<shared_ptr<Listener>> _listeners;
+	AcceptConfig _acceptConfig;
+	SessionConfig _sessionConfig;
 
 	/* 세션 관련 */
 	int _sessionCount = 0;
 	set<shared_ptr<Session>> _sessions;
+	vector<vector<Session*>> _sessionPools; // 샤드별로 연결이 끊겨 반납된 세션
 	set<string> _usedNickname;
 
 	/* 컨텐츠 관련 */
 	shared_ptr<RoomManager> _roomManager;
+
+	/* 집계 출력, 0번 샤드 스레드에서만 변경 */
+	chrono::steady_clock::time_point _metricsLogTime = chrono::steady_clock::now();
+	unsigned long long _loggedSendActions = 0; // 마지막으로 출력한 정책 동작 횟수의 합
+	vector<vector<unsigned long long>> _loggedBatchHistograms; // 샤드별로 마지막으로 출력한 배치 히스토그램
 };
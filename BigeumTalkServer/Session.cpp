@@ -1,13 +1,13 @@
 ﻿#include "pch.h"
 #include "Session.h"
 #include "PacketHandler.h"
+#include "PacketCompressor.h"
 #include "Service.h"
 #include "SocketUtils.h"
 #include "User.h"
 #include "Room.h"
 
 Session::Session()
-	: _recvBuffer(BUFFER_SIZE)
 {
 	// 세션 생성시 소켓 생성
 	_socket = SocketUtils::CreateSocket();
@@ -15,6 +15,8 @@ Session::Session()
 
 Session::~Session()
 {
+	// 기초 클래스 소멸자에서는 GetHandle을 부를 수 없으므로 먼저 분리
+	Unregister();
 	closesocket(_socket);
 
 #ifdef _DEBUG
@@ -59,34 +61,137 @@ void Session::Disconnect(const WCHAR* cause)
  * \brief 해당 세션에게 패킷을 보내는 함수
  * \param sendBuffer 보낼 데이터가 담긴 버퍼
  */
-void Session::Send(shared_ptr<SendBuffer> sendBuffer)
+void Session::Send(SendBufferRef sendBuffer)
 {
-	if (IsConnected() == false)
+	if (IsConnected() == false || sendBuffer == nullptr)
 	{
 		return;
 	}
 
-	bool registerSend = false;
+	// 압축을 협상한 세션에게는 큰 패킷을 압축하여 보냄, 압축하면 64KB 이하로 줄어들 수도 있음
+	if (UseCompression() && PacketCompressor::ShouldCompress(sendBuffer))
+	{
+		SendBufferRef compressed = PacketCompressor::Compress(sendBuffer);
+		if (compressed != nullptr)
+		{
+			sendBuffer = move(compressed);
+		}
+	}
 
+	// v1 세션은 64KB를 넘는 패킷을 받을 수 없음, 응답 없이 기다리지 않도록 연결을 끊음
+	if (sendBuffer->PacketSize() > numeric_limits<decltype(PacketHeader::size)>::max() && GetFrameMode() != FrameMode::V2)
 	{
-		// Scatter-Gather IO를 위한 큐에 메모리 버퍼 저장
-		lock_guard lock(_mutex);
+		GSendMetrics->oversizeDisconnectCount.fetch_add(1, memory_order_relaxed);
 
-		_sendQueue.push(sendBuffer);
+		char ip[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, &_address.sin_addr, ip, INET_ADDRSTRLEN);
+		cout << "[PACKET TOO LARGE] " << ip << ':' << ntohs(_address.sin_port) << " Size " << sendBuffer->PacketSize() << " Without V2 Framing" << endl;
 
-		if (_sendRegistered.exchange(true) == false)
-		{
-			registerSend = true;
-		}
+		Disconnect(L"Packet Too Large For V1");
+		return;
+	}
+
+	// 송신되지 않은 데이터가 제한을 넘었다면 적체 정책 적용
+	const unsigned int writeSize = sendBuffer->PacketSize();
+	if (IsPendingOver(writeSize) && ApplySendPolicy(sendBuffer) == false)
+	{
+		return;
 	}
 
-	if (registerSend)
+	_pendingBytes.fetch_add(writeSize, memory_order_relaxed);
+	_pendingCount.fetch_add(1, memory_order_relaxed);
+
+	// Scatter-Gather IO를 위한 큐에 메모리 버퍼 저장, 여러 스레드에서 lock 없이 Push
+	_sendQueue.Push(move(sendBuffer));
+
+	// 송신 중인 스레드가 없다면 이 스레드가 송신을 맡음
+	if (_sendRegistered.exchange(true) == false)
 	{
 		RegisterSend();
 	}
 }
 
 
+/**
+ * \brief 한번의 송신 요청으로 보낼 양을 제한하는 함수
+ * \details 제한을 넘는 데이터는 큐에 남아 앞선 송신이 완료된 뒤 이어서 보냅니다.
+ * \param maxSegmentCount 최대 버퍼 수. SendEvent::MAX_SEGMENT_COUNT를 넘을 수 없음
+ * \param maxBytes 최대 바이트 수. 버퍼 하나가 이보다 크다면 그 버퍼만 보냄
+ */
+void Session::SetSendLimit(unsigned int maxSegmentCount, unsigned int maxBytes)
+{
+	_maxSendSegments = clamp<unsigned int>(maxSegmentCount, 1, SendEvent::MAX_SEGMENT_COUNT);
+	_maxSendBytes = max(maxBytes, 1u);
+}
+
+
+/**
+ * \brief 송신 적체 제한과 정책을 설정하는 함수
+ * \details 큐에 있거나 송신 중인 데이터가 제한을 넘으면 policy에 따라 처리합니다.
+ * \param policy 제한을 넘었을 때의 처리 방법
+ * \param maxPendingBytes 송신 완료되지 않은 최대 바이트 수
+ * \param maxPendingCount 송신 완료되지 않은 최대 버퍼 수
+ */
+void Session::SetSendPolicy(SendPolicy policy, unsigned int maxPendingBytes, unsigned int maxPendingCount)
+{
+	_sendPolicy = policy;
+	_maxPendingBytes = max(maxPendingBytes, 1u);
+	_maxPendingCount = max(maxPendingCount, 1u);
+}
+
+
+/**
+ * \brief 받을 수 있는 v2 프레임의 크기를 제한하는 함수
+ * \details 이 크기를 넘는 길이를 보낸 연결은 메모리를 잡아두지 않도록 바로 끊습니다.
+ * \param maxFrameSize 헤더를 포함한 최대 프레임 크기
+ */
+void Session::SetMaxFrameSize(unsigned int maxFrameSize)
+{
+	_maxFrameSize = max<unsigned int>(maxFrameSize, sizeof(PacketHeaderV2));
+}
+
+
+/**
+ * \brief 세션이 받을 수 있는 패킷의 크기를 반환하는 함수
+ * \details 압축한 패킷을 풀 때 풀린 크기가 이를 넘으면 거부합니다.
+ * \return v2 프레이밍이라면 _maxFrameSize, 아니라면 PacketHeader의 최대 크기
+ */
+unsigned int Session::GetMaxPacketSize()
+{
+	if (GetFrameMode() == FrameMode::V2)
+	{
+		return _maxFrameSize;
+	}
+	return numeric_limits<decltype(PacketHeader::size)>::max();
+}
+
+
+/**
+ * \brief 유저 사전을 사용하도록 설정하는 함수
+ * \details 로그인할 때 클라이언트가 요청하면 켜며, 이후 S_CHAT은 닉네임 대신 userId만 담아 보냅니다.
+ */
+void Session::EnableUserDictionary()
+{
+	_userDictionary.store(true, memory_order_release);
+}
+
+
+/**
+ * \brief 클라이언트가 유저의 ID와 닉네임을 알게 되었음을 기록하는 함수
+ * \details 알게 된 유저의 채팅은 닉네임 없이 보내므로 유저 정보를 담은 패킷이 그 유저의 채팅보다 먼저 큐에 들어가야 합니다.
+ * \details Broadcast처럼 채팅과 다른 스레드에서 알린다면 정보 패킷을 Send한 뒤에 호출합니다.
+ * \details BroadcastChat처럼 반환값으로 사전 패킷을 보낼지 정한다면 호출한 스레드가 채팅보다 먼저 사전 패킷을 Send합니다.
+ * \details 여러 스레드의 Broadcast에서 동시에 호출될 수 있습니다.
+ * \param userId 알린 유저 ID
+ * \return 처음 알린 유저인지 여부
+ */
+bool Session::LearnUser(unsigned long long userId)
+{
+	lock_guard lock(_knownUsersMutex);
+	return _knownUsers.insert(userId).second;
+}
+
+
 /**
  * \brief TODO
  * \return TODO
@@ -105,19 +210,15 @@ bool Session::RegisterConnect()
 bool Session::RegisterDisconnect()
 {
 	_disconnectEvent.Init();
-	_disconnectEvent._owner = shared_from_this(); // ADD REF
+	_disconnectEvent._owner = this;
+	AddRef(); // ADD REF
 
 	// Disconnect 비동기 IO 작업 요청
-	if (false == SocketUtils::DisconnectEx(
-		_socket, &_disconnectEvent, TF_REUSE_SOCKET, 0
-	))
+	if (false == SocketUtils::Disconnect(_socket, &_disconnectEvent))
 	{
-		int errorCode = WSAGetLastError();
-		if (errorCode != WSA_IO_PENDING)
-		{
-			_disconnectEvent._owner = nullptr;
-			return false;
-		}
+		_disconnectEvent._owner = nullptr;
+		ReleaseRef(); // RELEASE REF
+		return false;
 	}
 
 	return true;
@@ -135,25 +236,39 @@ void Session::RegisterRecv()
 		return;
 	}
 
-	_recvEvent.Init();
-	_recvEvent._owner = shared_from_this(); // ADD REF
+	// 0 바이트 수신 모드에서 처리할 데이터가 없다면 버퍼를 반납하고 데이터가 도착하기만 기다림
+	// 0 바이트 수신이 완료된 직후이거나 v2 프레임을 모으는 중이라면 읽을 데이터가 이어지므로 실제로 수신
+	_recvProbing = _zeroByteRecv && _recvProbing == false && _recvBuffer.DataSize() == 0 && _frameSize == 0;
 
-	WSABUF wsaBuf;
-	wsaBuf.buf = reinterpret_cast<CHAR*>(_recvBuffer.WritePos());
-	wsaBuf.len = _recvBuffer.FreeSize();
+	WSABUF wsaBuf = {};
+	if (_recvProbing)
+	{
+		_recvBuffer.Release();
+	}
+	else
+	{
+		// 수신 버퍼는 실제로 수신을 요청할 때 풀에서 빌림
+		if (_recvBuffer.Reserve(sizeof(PacketHeader)) == false)
+		{
+			Disconnect(L"Reserve Failed");
+			return;
+		}
+
+		wsaBuf.buf = reinterpret_cast<CHAR*>(_recvBuffer.WritePos());
+		wsaBuf.len = _recvBuffer.FreeSize();
+	}
 
-	DWORD numOfBytes = 0;
-	DWORD flags = 0;
+	_recvEvent.Init();
+	_recvEvent._owner = this;
+	AddRef(); // ADD REF
 
-	// WSARecv 비동기 IO 작업 요청
-	if (SOCKET_ERROR == WSARecv(_socket, &wsaBuf, 1, OUT &numOfBytes, OUT &flags, &_recvEvent, nullptr))
+	// Recv 비동기 IO 작업 요청
+	if (false == SocketUtils::Recv(_socket, &wsaBuf, 1, &_recvEvent))
 	{
 		int errorCode = WSAGetLastError();
-		if (errorCode != WSA_IO_PENDING)
-		{
-			_recvEvent._owner = nullptr; // RELEASE REF
-			HandleError(errorCode);
-		}
+		_recvEvent._owner = nullptr;
+		HandleError(errorCode);
+		ReleaseRef(); // RELEASE REF
 	}
 }
 
@@ -169,53 +284,115 @@ void Session::RegisterSend()
 	}
 
 	_sendEvent.Init();
-	_sendEvent._owner = shared_from_this(); // ADD REF
+	_sendStagingSize = 0;
+	_sendEventBytes = 0;
+	_sendEventCount = 0;
 
+	while (true)
 	{
-		// _sendQueue에 쌓여있는 데이터를 _sendEvent의 _sendBuffers로 이동
+		// _sendQueue에 쌓여있는 데이터를 _sendEvent로 이동
 		// Scatter-Gather IO : 여러개의 메모리 버퍼를 지정하여 전송
-		lock_guard lock(_mutex);
-		int writeSize = 0;
-		while (_sendQueue.empty() == false)
+		// _sendRegistered를 가진 스레드만 꺼내므로 소비자는 항상 하나
+		// 오래된 채팅을 버리는 스레드와는 _sendPopLock으로 구분
+		while (_sendPopLock.exchange(true, memory_order_acquire))
 		{
-			shared_ptr<SendBuffer> sendBuffer = _sendQueue.front();
-			_sendQueue.pop();
+			this_thread::yield();
+		}
 
-			writeSize += sendBuffer->WriteSize();
+		while (_sendEvent._wsaBufCount < _maxSendSegments && _sendEventBytes < _maxSendBytes)
+		{
+			SendBufferRef sendBuffer = PopSendBuffer();
+			if (sendBuffer == nullptr)
+			{
+				break;
+			}
+
+			if (sendBuffer->Next() != nullptr)
+			{
+				// 체인은 나누지 않고 한번의 송신에 담음, 남은 자리가 부족하면 다음 송신으로 미룸
+				const unsigned int segmentCount = sendBuffer->SegmentCount();
+				if (_sendEvent._wsaBufCount > 0 && _sendEvent._wsaBufCount + segmentCount > _maxSendSegments)
+				{
+					_sendKept.push_front(move(sendBuffer));
+					break;
+				}
+
+				_sendEventBytes += sendBuffer->PacketSize();
+				_sendEventCount++;
+				for (SendBuffer* segment = sendBuffer.get(); segment != nullptr; segment = segment->Next())
+				{
+					_sendEvent._wsaBufs[_sendEvent._wsaBufCount++] = {segment->WriteSize(), reinterpret_cast<CHAR*>(segment->Buffer())};
+				}
+				_sendEvent._sendBuffers[_sendEvent._sendBufferCount++] = move(sendBuffer);
+				continue;
+			}
+
+			const unsigned int writeSize = sendBuffer->WriteSize();
+			_sendEventBytes += writeSize;
+			_sendEventCount++;
+
+			if (writeSize <= SEND_COALESCE_SIZE && _sendStagingSize + writeSize <= SEND_STAGING_SIZE)
+			{
+				// 작은 버퍼는 스테이징 공간에 복사하고 바로 참조 해제
+				CHAR* staging = reinterpret_cast<CHAR*>(&_sendStaging[_sendStagingSize]);
+				memcpy(staging, sendBuffer->Buffer(), writeSize);
+				_sendStagingSize += writeSize;
+
+				// 바로 앞 버퍼에 이어서 복사되었다면 하나의 버퍼로 합침
+				if (_sendEvent._wsaBufCount > 0)
+				{
+					WSABUF& last = _sendEvent._wsaBufs[_sendEvent._wsaBufCount - 1];
+					if (last.buf + last.len == staging)
+					{
+						last.len += writeSize;
+						continue;
+					}
+				}
+
+				_sendEvent._wsaBufs[_sendEvent._wsaBufCount++] = {writeSize, staging};
+				continue;
+			}
+
+			_sendEvent._wsaBufs[_sendEvent._wsaBufCount++] = {writeSize, reinterpret_cast<CHAR*>(sendBuffer->Buffer())};
+			_sendEvent._sendBuffers[_sendEvent._sendBufferCount++] = move(sendBuffer);
+		}
 
-			_sendEvent._sendBuffers.push_back(sendBuffer);
+		_sendPopLock.store(false, memory_order_release);
+
+		if (_sendEvent._wsaBufCount > 0)
+		{
+			break;
 		}
-	}
 
-	vector<WSABUF> wsaBufs;
-	wsaBufs.reserve(_sendEvent._sendBuffers.size());
-	for (auto sendBuffer : _sendEvent._sendBuffers)
-	{
-		WSABUF wsaBuf;
-		wsaBuf.buf = reinterpret_cast<char*>(sendBuffer->Buffer());
-		wsaBuf.len = static_cast<ULONG>(sendBuffer->WriteSize());
-		wsaBufs.push_back(wsaBuf);
+		// 다른 스레드가 먼저 모두 송신했거나 아직 Push 중인 데이터뿐이라면 송신 중 표시 해제
+		if (ReleaseSendRegistered() == false)
+		{
+			return;
+		}
 	}
 
-	DWORD numOfBytes = 0;
-	if (SOCKET_ERROR == WSASend(_socket, wsaBufs.data(), wsaBufs.size(), OUT &numOfBytes, 0, &_sendEvent, nullptr))
+	_sendEvent._owner = this;
+	AddRef(); // ADD REF
+
+	// Send 비동기 IO 작업 요청
+	if (false == SocketUtils::Send(_socket, _sendEvent._wsaBufs, static_cast<int>(_sendEvent._wsaBufCount), &_sendEvent))
 	{
 		int errorCode = WSAGetLastError();
-		if (errorCode != WSA_IO_PENDING)
-		{
-			HandleError(errorCode);
-			_sendEvent._owner = nullptr;
-			_sendEvent._sendBuffers.clear();
-			_sendRegistered.store(false);
-		}
+		HandleError(errorCode);
+		_sendEvent._owner = nullptr;
+		_sendEvent.Clear();
+		CompleteSendEvent();
+		_sendRegistered.store(false);
+		ReleaseRef(); // RELEASE REF
 	}
 }
 
 
 /**
  * \brief Connect 비동기 IO 작업 완료 패킷 처리 함수
+ * \param numOfBytes 연결과 함께 _recvBuffer에 받은 첫 데이터의 크기
  */
-void Session::ProcessConnect()
+void Session::ProcessConnect(int numOfBytes)
 {
 	// Listener ProcessAccept 에서도 호출 됨
 	_connectEvent._owner = nullptr;
@@ -223,6 +400,13 @@ void Session::ProcessConnect()
 
 	GetService()->AddSession(GetSessionRef()); // 서비스에 세션 등록
 
+	if (numOfBytes > 0)
+	{
+		// 첫 데이터는 Recv 완료와 같이 바로 처리, 이후 RegisterRecv 호출됨
+		ProcessRecv(numOfBytes);
+		return;
+	}
+
 	RegisterRecv();
 }
 
@@ -233,6 +417,7 @@ void Session::ProcessConnect()
 void Session::ProcessDisconnect()
 {
 	_disconnectEvent._owner = nullptr;
+	_recyclable = true; // 모든 참조가 해제되면 세션 풀에 반납
 
 	if (_user != nullptr)
 	{
@@ -260,6 +445,13 @@ void Session::ProcessRecv(int numOfBytes)
 {
 	_recvEvent._owner = nullptr;
 
+	if (_recvProbing)
+	{
+		// 읽을 데이터가 도착했거나 연결이 끊김, 버퍼를 빌려 실제로 수신하며 확인
+		RegisterRecv();
+		return;
+	}
+
 	if (numOfBytes == 0)
 	{
 		// 수신받은 데이터의 크기가 0이면 연결이 끊긴 상황
@@ -276,39 +468,23 @@ void Session::ProcessRecv(int numOfBytes)
 
 	// 패킷 처리
 	int processLen = 0;
+	int pendingSize = 0; // 아직 다 받지 못한 패킷의 크기
 	int totalDataSize = _recvBuffer.DataSize();
 
-	while (true)
+	while (processLen < totalDataSize)
 	{
-		int dataSize = totalDataSize - processLen;
-
-		// 패킷 헤더 파싱 가능 여부
-		if (dataSize < sizeof(PacketHeader))
+		const int frameLen = ProcessFrame(&_recvBuffer.ReadPos()[processLen], totalDataSize - processLen, pendingSize);
+		if (frameLen < 0)
 		{
-			break;
+			return;
 		}
 
-		BYTE* buffer = &_recvBuffer.ReadPos()[processLen];
-
-		// 헤더 파싱
-		PacketHeader header = *(reinterpret_cast<PacketHeader*>(buffer));
-
-		// 데이터 파싱 가능 여부
-		if (dataSize < header.size)
+		if (frameLen == 0)
 		{
 			break;
 		}
 
-		shared_ptr<Session> session = static_pointer_cast<Session>(shared_from_this());
-
-		// 패킷 핸들러 함수 호출
-		if (PacketHandler::HandlePacket(session, buffer, header.size) == false)
-		{
-			Disconnect(L"OnRead Overflow");
-			return;
-		}
-
-		processLen += header.size;
+		processLen += frameLen;
 	}
 
 	if (processLen < 0 || _recvBuffer.DataSize() < processLen || _recvBuffer.OnRead(processLen) == false)
@@ -320,13 +496,186 @@ void Session::ProcessRecv(int numOfBytes)
 		return;
 	}
 
-	// 커서 정리
+	// 커서 정리, 잘린 패킷이 버퍼보다 크다면 더 큰 버퍼로 교체
 	_recvBuffer.Clean();
+	if (_recvBuffer.Reserve(pendingSize) == false)
+	{
+		Disconnect(L"Reserve Overflow");
+		return;
+	}
 
 	RegisterRecv();
 }
 
 
+/**
+ * \brief 수신 버퍼의 데이터에서 프레임 하나를 처리하는 함수
+ * \details 수신 버퍼에 다 담기지 않는 v2 프레임은 _frameBuffer에 받은 만큼 옮겨 모으고, 다 모이면 처리합니다.
+ * \param buffer 처리할 데이터의 시작 주소
+ * \param dataSize 처리할 수 있는 데이터의 크기
+ * \param pendingSize 수신 버퍼에 더 받아야 하는 잘린 패킷의 크기
+ * \return 처리한 바이트 수, 더 받아야 한다면 0, 연결을 끊었다면 -1
+ */
+int Session::ProcessFrame(BYTE* buffer, int dataSize, OUT int& pendingSize)
+{
+	shared_ptr<Session> session = static_pointer_cast<Session>(shared_from_this());
+
+	if (_frameSize > 0)
+	{
+		// 모으는 중인 v2 프레임에 이어서 복사
+		const unsigned int copySize = min(static_cast<unsigned int>(dataSize), _frameSize - _frameReceived);
+		memcpy(&_frameBuffer[_frameReceived], buffer, copySize);
+		_frameReceived += copySize;
+
+		if (_frameReceived == _frameSize)
+		{
+			const bool handled = PacketHandler::HandlePacket(session, _frameBuffer.data(), static_cast<int>(_frameSize));
+
+			// 큰 프레임의 메모리를 잡아두지 않도록 해제
+			vector<BYTE>().swap(_frameBuffer);
+			_frameSize = 0;
+			_frameReceived = 0;
+
+			if (handled == false)
+			{
+				Disconnect(L"HandlePacket Failed");
+				return -1;
+			}
+		}
+
+		return static_cast<int>(copySize);
+	}
+
+	// 패킷 헤더 파싱 가능 여부
+	if (static_cast<unsigned int>(dataSize) < sizeof(PacketHeader))
+	{
+		return 0;
+	}
+
+	// 헤더 파싱
+	PacketHeader header = *(reinterpret_cast<PacketHeader*>(buffer));
+
+	if (header.size == 0)
+	{
+		// 64KB를 넘는 v2 프레임
+		if (GetFrameMode() != FrameMode::V2)
+		{
+			Disconnect(L"Frame Not Negotiated");
+			return -1;
+		}
+
+		if (static_cast<unsigned int>(dataSize) < sizeof(PacketHeaderV2))
+		{
+			pendingSize = sizeof(PacketHeaderV2);
+			return 0;
+		}
+
+		const unsigned int frameSize = reinterpret_cast<PacketHeaderV2*>(buffer)->size;
+		if (frameSize < sizeof(PacketHeaderV2) || frameSize > _maxFrameSize)
+		{
+			Disconnect(L"Frame Size Invalid");
+			return -1;
+		}
+
+		if (frameSize > static_cast<unsigned int>(dataSize))
+		{
+			// 수신 버퍼 크기와 상관없이 받은 만큼 옮겨 모음
+			_frameBuffer.resize(frameSize);
+			_frameSize = frameSize;
+			_frameReceived = 0;
+			return ProcessFrame(buffer, dataSize, pendingSize);
+		}
+
+		if (PacketHandler::HandlePacket(session, buffer, static_cast<int>(frameSize)) == false)
+		{
+			Disconnect(L"HandlePacket Failed");
+			return -1;
+		}
+
+		return static_cast<int>(frameSize);
+	}
+
+	if (header.size < sizeof(PacketHeader))
+	{
+		Disconnect(L"Frame Size Invalid");
+		return -1;
+	}
+
+	// 데이터 파싱 가능 여부
+	if (dataSize < header.size)
+	{
+		pendingSize = header.size;
+		return 0;
+	}
+
+	if (header.id == PACKET_ID_FRAME_V2 && header.size == sizeof(PacketHeader))
+	{
+		NegotiateFrameV2();
+		return header.size;
+	}
+
+	if (header.id == PACKET_ID_COMPRESSION && header.size == sizeof(PacketHeader))
+	{
+		NegotiateCompression();
+		return header.size;
+	}
+
+	// 패킷 핸들러 함수 호출
+	if (PacketHandler::HandlePacket(session, buffer, header.size) == false)
+	{
+		Disconnect(L"HandlePacket Failed");
+		return -1;
+	}
+
+	return header.size;
+}
+
+
+/**
+ * \brief 클라이언트의 v2 프레이밍 요청을 수락하는 함수
+ * \details 수락 패킷을 큐에 넣은 뒤 v2로 바꾸므로, 64KB를 넘는 패킷은 항상 수락 패킷 뒤에 송신됩니다.
+ */
+void Session::NegotiateFrameV2()
+{
+	if (GetFrameMode() == FrameMode::V2)
+	{
+		return;
+	}
+
+	SendBufferRef sendBuffer = GSendBufferManager->Open(sizeof(PacketHeader));
+	auto header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
+	header->size = sizeof(PacketHeader);
+	header->id = PACKET_ID_FRAME_V2;
+	sendBuffer->Close(sizeof(PacketHeader));
+	Send(move(sendBuffer));
+
+	_frameMode.store(FrameMode::V2, memory_order_release);
+}
+
+
+/**
+ * \brief 클라이언트의 패킷 압축 요청을 수락하는 함수
+ * \details 수락 패킷을 큐에 넣은 뒤 압축을 켜므로, 압축한 패킷은 항상 수락 패킷 뒤에 송신됩니다.
+ * \details 클라이언트도 수락 패킷을 받은 뒤부터 압축한 패킷을 보낼 수 있습니다.
+ */
+void Session::NegotiateCompression()
+{
+	if (UseCompression())
+	{
+		return;
+	}
+
+	SendBufferRef sendBuffer = GSendBufferManager->Open(sizeof(PacketHeader));
+	auto header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
+	header->size = sizeof(PacketHeader);
+	header->id = PACKET_ID_COMPRESSION;
+	sendBuffer->Close(sizeof(PacketHeader));
+	Send(move(sendBuffer));
+
+	_compression.store(true, memory_order_release);
+}
+
+
 /**
  * \brief Send 비동기 IO 작업 완료 패킷 처리 함수
  * \param numOfBytes 완료 패킷의 크기
@@ -334,7 +683,8 @@ void Session::ProcessRecv(int numOfBytes)
 void Session::ProcessSend(int numOfBytes)
 {
 	_sendEvent._owner = nullptr;
-	_sendEvent._sendBuffers.clear();
+	_sendEvent.Clear();
+	CompleteSendEvent();
 
 	if (numOfBytes == 0)
 	{
@@ -342,19 +692,212 @@ void Session::ProcessSend(int numOfBytes)
 		return;
 	}
 
-	unique_lock lock(_mutex);
-	if (_sendQueue.empty())
+	if (ReleaseSendRegistered())
 	{
-		_sendRegistered.store(false);
+		RegisterSend();
 	}
-	else
+}
+
+
+/**
+ * \brief 송신 중 표시를 해제하는 함수
+ * \details 해제하는 사이 Push된 데이터가 있고 다른 스레드가 송신을 맡지 않았다면 다시 송신 중으로 표시합니다.
+ * \return 이어서 송신해야 하는지 여부
+ */
+bool Session::ReleaseSendRegistered()
+{
+	// exchange로 해제해야 먼저 Push한 스레드의 데이터가 보임
+	_sendRegistered.exchange(false);
+	return _sendQueue.Empty() == false && _sendRegistered.exchange(true) == false;
+}
+
+
+/**
+ * \brief 송신 큐에서 다음으로 보낼 버퍼를 꺼내는 함수
+ * \details _sendPopLock을 가진 스레드만 호출합니다. 오래된 채팅을 버리며 보관한 패킷을 먼저 꺼냅니다.
+ * \return 보낼 버퍼, 없다면 nullptr
+ */
+SendBufferRef Session::PopSendBuffer()
+{
+	if (_sendKept.empty() == false)
 	{
-		lock.unlock();
-		RegisterSend();
+		SendBufferRef sendBuffer = move(_sendKept.front());
+		_sendKept.pop_front();
+		return sendBuffer;
+	}
+
+	return _sendQueue.Pop();
+}
+
+
+/**
+ * \brief 송신 요청에 담았던 데이터를 적체량에서 빼는 함수
+ */
+void Session::CompleteSendEvent()
+{
+	_pendingBytes.fetch_sub(_sendEventBytes, memory_order_relaxed);
+	_pendingCount.fetch_sub(_sendEventCount, memory_order_relaxed);
+	_sendEventBytes = 0;
+	_sendEventCount = 0;
+}
+
+
+/**
+ * \brief 새 데이터를 더하면 송신 적체 제한을 넘는지 확인하는 함수
+ * \param incomingBytes 새로 보낼 데이터의 크기
+ * \return 제한을 넘는지 여부
+ */
+bool Session::IsPendingOver(unsigned int incomingBytes)
+{
+	return _pendingBytes.load(memory_order_relaxed) + incomingBytes > _maxPendingBytes
+		|| _pendingCount.load(memory_order_relaxed) + 1 > _maxPendingCount;
+}
+
+
+/**
+ * \brief 송신 적체 제한을 넘었을 때 정책을 적용하는 함수
+ * \param sendBuffer 새로 보낼 버퍼
+ * \return 새로 보낼 버퍼를 큐에 넣어야 하는지 여부
+ */
+bool Session::ApplySendPolicy(const SendBufferRef& sendBuffer)
+{
+	switch (_sendPolicy)
+	{
+	case SendPolicy::Disconnect:
+		GSendMetrics->disconnectCount.fetch_add(1, memory_order_relaxed);
+		Disconnect(L"Send Backpressure");
+		return false;
+	case SendPolicy::DropOldestChat:
+		if (DropOldestChat(sendBuffer->PacketSize()))
+		{
+			return true;
+		}
+		// 오래된 패킷을 버리지 못했다면 새 채팅 패킷을 버림
+		[[fallthrough]];
+	case SendPolicy::DropNewChat:
+		if (IsChat(sendBuffer))
+		{
+			GSendMetrics->dropNewChatCount.fetch_add(1, memory_order_relaxed);
+			return false;
+		}
+		// 채팅 외 패킷은 제한을 넘어도 보냄
+		return true;
+	default:
+		return true;
 	}
 }
 
 
+/**
+ * \brief 큐에 쌓인 오래된 채팅 패킷부터 제한 아래로 내려갈 때까지 버리는 함수
+ * \details 큐 앞에서 꺼낸 채팅 외 패킷은 _sendKept에 순서대로 보관하여 먼저 보냅니다.
+ * \details 송신 스레드가 큐에서 꺼내는 중이라면 버리지 않습니다.
+ * \param incomingBytes 새로 보낼 데이터의 크기
+ * \return 큐를 정리했는지 여부. 송신 스레드가 꺼내는 중이었다면 false
+ */
+bool Session::DropOldestChat(unsigned int incomingBytes)
+{
+	if (_sendPopLock.exchange(true, memory_order_acquire))
+	{
+		return false;
+	}
+
+	while (IsPendingOver(incomingBytes))
+	{
+		SendBufferRef sendBuffer = _sendQueue.Pop();
+		if (sendBuffer == nullptr)
+		{
+			break;
+		}
+
+		if (IsChat(sendBuffer) == false)
+		{
+			_sendKept.push_back(move(sendBuffer));
+			continue;
+		}
+
+		_pendingBytes.fetch_sub(sendBuffer->PacketSize(), memory_order_relaxed);
+		_pendingCount.fetch_sub(1, memory_order_relaxed);
+		GSendMetrics->dropOldestChatCount.fetch_add(1, memory_order_relaxed);
+	}
+
+	_sendPopLock.store(false, memory_order_release);
+	return true;
+}
+
+
+/**
+ * \brief 버리거나 늦게 보내도 되는 채팅 패킷인지 확인하는 함수
+ * \param sendBuffer 확인할 버퍼
+ * \return 압축 여부를 뺀 패킷 헤더의 id가 S_CHAT인지 여부
+ */
+bool Session::IsChat(const SendBufferRef& sendBuffer)
+{
+	if (sendBuffer->WriteSize() < sizeof(PacketHeader))
+	{
+		return false;
+	}
+
+	PacketHeader* header = reinterpret_cast<PacketHeader*>(sendBuffer->Buffer());
+	return (header->id & ~PACKET_ID_COMPRESSED_FLAG) == Protocol::PACKET_ID_S_CHAT;
+}
+
+
+/**
+ * \brief 연결이 끊긴 세션을 새 연결을 받을 수 있도록 초기화하는 함수
+ * \details 모든 참조가 해제되어 세션 풀에 반납될 때 호출되며, 버퍼는 그대로 재사용합니다.
+ * \details Windows는 TF_REUSE_SOCKET으로 끊은 소켓을 재사용하고, Linux는 새 소켓으로 교체합니다.
+ */
+void Session::Reset()
+{
+#ifdef _DEBUG
+	// TEMP LOG
+	SOCKADDR_IN sockAddr = _address;
+	char ip[INET_ADDRSTRLEN];
+	inet_ntop(AF_INET, &sockAddr.sin_addr, ip, INET_ADDRSTRLEN);
+	cout << "[SESSION RECYCLED] " << ip << ':' << ntohs(sockAddr.sin_port) << " Disconnected" << endl;
+#endif
+
+	_recyclable = false;
+	_address = {};
+	_user = nullptr;
+	_userDictionary.store(false);
+	{
+		lock_guard lock(_knownUsersMutex);
+		unordered_set<unsigned long long>().swap(_knownUsers);
+	}
+
+	// 처리하지 못한 수신 데이터 폐기
+	_recvBuffer.OnRead(_recvBuffer.DataSize());
+	_recvBuffer.Clean();
+	_recvProbing = false;
+	_frameMode.store(FrameMode::V1);
+	_compression.store(false);
+	vector<BYTE>().swap(_frameBuffer);
+	_frameSize = 0;
+	_frameReceived = 0;
+
+	// 보내지 못한 송신 데이터 폐기
+	while (_sendQueue.Pop() != nullptr)
+	{
+	}
+	_sendKept = {};
+	_sendEvent.Clear();
+	_sendStagingSize = 0;
+	_sendEventBytes = 0;
+	_sendEventCount = 0;
+	_pendingBytes.store(0);
+	_pendingCount.store(0);
+	_sendRegistered.store(false);
+
+#ifndef _WIN32
+	Unregister();
+	closesocket(_socket);
+	_socket = SocketUtils::CreateSocket();
+#endif
+}
+
+
 /**
  * \brief 에러 처리 함수
  * \param errorCode WSAGetLastError로 부터 반환된 값
@@ -4,10 +4,72 @@
 
 #include "Iocp.h"
 #include "RecvBuffer.h"
+#include "SendQueue.h"
 
 class Service;
 class User;
 
+/**
+ * \brief 송신 적체 정책 열거형
+ * \details 세션에 쌓인 송신 데이터가 제한을 넘었을 때의 처리 방법입니다.
+ */
+enum class SendPolicy
+{
+	Disconnect, // 연결을 끊음
+	DropOldestChat, // 큐에 쌓인 오래된 채팅 패킷부터 버림, 송신 스레드가 큐를 꺼내는 중이면 새 채팅 패킷을 버림
+	DropNewChat, // 새로 보낼 채팅 패킷을 버림, 채팅 외 패킷은 그대로 보냄
+};
+
+
+/**
+ * \brief 프레이밍 방식 열거형
+ * \details 연결마다 협상하며, 처음에는 V1로 시작합니다.
+ */
+enum class FrameMode : BYTE
+{
+	V1, // 16비트 크기의 PacketHeader만 사용, 패킷은 64KB 이하이며 더 큰 패킷을 보내려 하면 연결을 끊음
+	V2, // 64KB를 넘는 패킷에 32비트 크기의 PacketHeaderV2 사용
+};
+
+
+/**
+ * \brief SessionConfig 구조체
+ * \details Service가 세션을 생성하거나 재사용할 때 세션에 적용하는 설정입니다.
+ */
+struct SessionConfig
+{
+	enum
+	{
+		DEFAULT_SEND_BYTES = 0x10000, // 한번의 송신 요청으로 보낼 바이트 수 기본값
+		DEFAULT_PENDING_BYTES = 0x100000, // 송신 완료되지 않은 바이트 수 제한 기본값
+		DEFAULT_PENDING_COUNT = 0x1000, // 송신 완료되지 않은 버퍼 수 제한 기본값
+	};
+
+	bool zeroByteRecv = false; // 유휴 상태에서는 수신 버퍼를 반납하고 0 바이트 수신으로 대기
+
+	/* 송신 (Session::SetSendLimit) */
+	unsigned int maxSendSegments = SendEvent::MAX_SEGMENT_COUNT; // 한번의 송신 요청에 담을 최대 버퍼 수
+	unsigned int maxSendBytes = DEFAULT_SEND_BYTES; // 한번의 송신 요청에 담을 최대 바이트 수
+
+	/* 송신 적체 (Session::SetSendPolicy) */
+	SendPolicy sendPolicy = SendPolicy::DropOldestChat;
+	unsigned int maxPendingBytes = DEFAULT_PENDING_BYTES;
+	unsigned int maxPendingCount = DEFAULT_PENDING_COUNT;
+};
+
+
+/**
+ * \brief SendMetrics 구조체
+ * \details 송신 적체 정책이 동작한 횟수를 전체 세션에 대해 집계합니다. Service::Tick이 주기적으로 출력합니다.
+ */
+struct SendMetrics
+{
+	atomic<unsigned long long> disconnectCount = 0;
+	atomic<unsigned long long> dropOldestChatCount = 0;
+	atomic<unsigned long long> dropNewChatCount = 0;
+	atomic<unsigned long long> oversizeDisconnectCount = 0; // v1 세션에 64KB를 넘는 패킷을 보내려다 끊은 수
+};
+
 /**
  * \brief Session 클래스 \n
  * \details 클라이언트의 연결 정보를 담고 있습니다.
@@ -17,7 +79,9 @@ class Session : public IocpObject
 {
 	enum
 	{
-		BUFFER_SIZE = 0x10000,
+		SEND_STAGING_SIZE = 0x1000, // 작은 버퍼를 모아 보낼 연속 공간 크기
+		SEND_COALESCE_SIZE = 0x100, // 이 크기 이하의 버퍼는 스테이징 공간에 복사하여 보냄
+		DEFAULT_MAX_FRAME_SIZE = 0x100000, // 받을 수 있는 v2 프레임 크기 제한 기본값
 	};
 
 	friend class Listener;
@@ -30,7 +94,13 @@ public:
 	/* 외부 사용 */
 	bool Connect();
 	void Disconnect(const WCHAR* cause);
-	void Send(shared_ptr<SendBuffer> sendBuffer);
+	void Send(SendBufferRef sendBuffer);
+	void SetSendLimit(unsigned int maxSegmentCount, unsigned int maxBytes);
+	void SetSendPolicy(SendPolicy policy, unsigned int maxPendingBytes, unsigned int maxPendingCount);
+	void SetMaxFrameSize(unsigned int maxFrameSize);
+
+	/** \brief 0 바이트 수신 모드를 설정하는 함수 \details 켜면 데이터가 도착한 뒤에만 수신 버퍼를 빌립니다. */
+	void SetZeroByteRecv(bool enable) { _zeroByteRecv = enable; }
 
 	/* 정보 */
 	/** \brief 세션의 서비스를 반환하는 함수 \return _service의 shared_ptr */
@@ -54,9 +124,22 @@ public:
 	/** \brief 세션이 연결되었는지 확인하는 함수 \return _connected */
 	bool IsConnected() { return _connected; }
 
+	/** \brief 세션의 프레이밍 방식을 반환하는 함수 \return _frameMode */
+	FrameMode GetFrameMode() { return _frameMode.load(memory_order_acquire); }
+
+	unsigned int GetMaxPacketSize();
+
+	/** \brief 패킷 압축을 협상했는지 확인하는 함수 \return _compression */
+	bool UseCompression() { return _compression.load(memory_order_acquire); }
+
 public:
 	/* 컨텐츠 함수 */
 	bool EnterRoom(unsigned long long roomId);
+	void EnableUserDictionary();
+	bool LearnUser(unsigned long long userId);
+
+	/** \brief 유저 사전을 사용하는지 확인하는 함수 \return _userDictionary */
+	bool UseUserDictionary() { return _userDictionary.load(memory_order_acquire); }
 
 private:
 	/* 비동기 IO 요청 */
@@ -64,14 +147,25 @@ private:
 	bool RegisterDisconnect();
 	void RegisterRecv();
 	void RegisterSend();
+	bool ReleaseSendRegistered();
+	SendBufferRef PopSendBuffer();
+	void CompleteSendEvent();
+	bool ApplySendPolicy(const SendBufferRef& sendBuffer);
+	bool DropOldestChat(unsigned int incomingBytes);
+	bool IsPendingOver(unsigned int incomingBytes);
+	static bool IsChat(const SendBufferRef& sendBuffer);
 
 	/* 완료 패킷 처리 */
-	void ProcessConnect();
+	void ProcessConnect(int numOfBytes = 0);
 	void ProcessDisconnect();
 	void ProcessRecv(int numOfBytes);
+	int ProcessFrame(BYTE* buffer, int dataSize, OUT int& pendingSize);
+	void NegotiateFrameV2();
+	void NegotiateCompression();
 	void ProcessSend(int numOfBytes);
 
 	void HandleError(int errorCode);
+	void Reset();
 
 private:
 	/* IocpObject 인터페이스 */
@@ -79,20 +173,43 @@ private:
 	void Dispatch(IocpEvent* iocpEvent, int numOfBytes) override;
 
 private:
-	mutex _mutex;
-
 	/* 세션 정보 */
 	weak_ptr<Service> _service;
 	SOCKET _socket = INVALID_SOCKET;
 	SOCKADDR_IN _address = {};
 	atomic<bool> _connected = false;
+	unsigned int _shard = 0; // 세션이 등록된 샤드, 재사용 시 같은 샤드의 풀로 반납
+	bool _recyclable = false; // 연결 종료가 완료되어 소켓을 재사용할 수 있는지 여부
 
 	/* 송신 */
 	RecvBuffer _recvBuffer;
+	bool _zeroByteRecv = false; // 유휴 상태에서는 버퍼 없이 0 바이트 수신으로 대기
+	bool _recvProbing = false; // 요청 중인 수신이 0 바이트 수신인지 여부
+	atomic<FrameMode> _frameMode = FrameMode::V1; // 다른 스레드의 Send에서도 확인
+	unsigned int _maxFrameSize = DEFAULT_MAX_FRAME_SIZE;
+	vector<BYTE> _frameBuffer; // 수신 버퍼에 다 담기지 않는 v2 프레임을 모으는 공간
+	unsigned int _frameSize = 0; // 모으는 중인 v2 프레임 크기, 0이면 모으는 중이 아님
+	unsigned int _frameReceived = 0; // 모은 크기
+	atomic<bool> _compression = false; // 패킷 압축 협상 여부, 다른 스레드의 Send에서도 확인
 
 	/* 수신 */
-	queue<shared_ptr<SendBuffer>> _sendQueue;
+	SendQueue _sendQueue; // 여러 스레드가 Push, _sendRegistered를 가진 스레드만 Pop
 	atomic<bool> _sendRegistered = false;
+	unsigned int _maxSendSegments = SendEvent::MAX_SEGMENT_COUNT;
+	unsigned int _maxSendBytes = SessionConfig::DEFAULT_SEND_BYTES; // 이 크기에 도달하면 큐에서 그만 꺼냄
+	BYTE _sendStaging[SEND_STAGING_SIZE]; // 송신 중인 작은 버퍼들의 복사본
+	unsigned int _sendStagingSize = 0;
+
+	/* 송신 적체 */
+	SendPolicy _sendPolicy = SendPolicy::DropOldestChat;
+	unsigned int _maxPendingBytes = SessionConfig::DEFAULT_PENDING_BYTES;
+	unsigned int _maxPendingCount = SessionConfig::DEFAULT_PENDING_COUNT;
+	atomic<unsigned int> _pendingBytes = 0; // 큐에 있거나 송신 중인 바이트 수
+	atomic<unsigned int> _pendingCount = 0; // 큐에 있거나 송신 중인 버퍼 수
+	unsigned int _sendEventBytes = 0; // 현재 송신 요청에 담긴 바이트 수
+	unsigned int _sendEventCount = 0; // 현재 송신 요청에 담긴 버퍼 수
+	atomic<bool> _sendPopLock = false; // 송신 스레드와 오래된 채팅을 버리는 스레드 사이의 Pop 잠금
+	deque<SendBufferRef> _sendKept; // 오래된 채팅을 버리며 꺼낸 채팅 외 패킷과 다음 송신으로 미룬 체인, 큐보다 먼저 보냄
 
 	/* IOCP 이벤트 재사용 */
 	ConnectEvent _connectEvent;
@@ -100,6 +217,11 @@ private:
 	RecvEvent _recvEvent;
 	SendEvent _sendEvent;
 
+	/* 유저 사전 */
+	atomic<bool> _userDictionary = false; // 다른 스레드의 Broadcast에서도 확인
+	mutex _knownUsersMutex;
+	unordered_set<unsigned long long> _knownUsers; // ID와 닉네임을 이미 알린 유저
+
 public:
 	/* 콘텐츠 정보 */
 	shared_ptr<User> _user = nullptr; // Cycle, 게임의 경우 가변 배열로 나의 캐릭터들 표현
@@ -114,3 +236,25 @@ struct PacketHeader
 	unsigned short size;
 	unsigned short id;
 };
+
+
+/**
+ * \brief PacketHeaderV2 구조체 \n
+ * \details v2 프레이밍에서 64KB를 넘는 패킷의 헤더입니다. size가 0인 PacketHeader 뒤에 32비트 크기가 이어집니다.
+ * \details 64KB 이하의 패킷은 v2에서도 PacketHeader를 그대로 사용하므로, 한번 만든 버퍼를 v1, v2 세션에 함께 보낼 수 있습니다.
+ */
+struct PacketHeaderV2
+{
+	unsigned short mark; // 항상 0, PacketHeader의 size 자리
+	unsigned short id;
+	unsigned int size; // 헤더를 포함한 패킷 크기
+};
+
+/** \brief v2 프레이밍을 요청하고 수락할 때 주고받는 헤더만 있는 패킷의 id */
+constexpr unsigned short PACKET_ID_FRAME_V2 = 0xFFFF;
+
+/** \brief 패킷 압축을 요청하고 수락할 때 주고받는 헤더만 있는 패킷의 id, 프리셋 사전의 버전을 겸함 */
+constexpr unsigned short PACKET_ID_COMPRESSION = 0xFFFE;
+
+/** \brief 압축한 패킷의 헤더 id에 켜는 비트, 프로토콜 ID는 이 비트를 쓰지 않음 */
+constexpr unsigned short PACKET_ID_COMPRESSED_FLAG = 0x8000;
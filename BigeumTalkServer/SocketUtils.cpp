@@ -1,9 +1,12 @@
 ﻿#include "pch.h"
 #include "SocketUtils.h"
+#include "Iocp.h"
 
+#ifdef _WIN32
 LPFN_CONNECTEX SocketUtils::ConnectEx = nullptr;
 LPFN_DISCONNECTEX SocketUtils::DisconnectEx = nullptr;
 LPFN_ACCEPTEX SocketUtils::AcceptEx = nullptr;
+#endif
 
 SocketUtils::SocketUtils()
 {
@@ -20,6 +23,7 @@ SocketUtils::~SocketUtils()
  */
 void SocketUtils::Init()
 {
+#ifdef _WIN32
 	WSADATA wsaData;
 	ASSERT_CRASH(WSAStartup(MAKEWORD(2, 2), OUT & wsaData) == 0);
 
@@ -29,6 +33,10 @@ void SocketUtils::Init()
 	ASSERT_CRASH(BindWindowsFunction(dummySocket, WSAID_DISCONNECTEX, reinterpret_cast<LPVOID*>(&DisconnectEx)));
 	ASSERT_CRASH(BindWindowsFunction(dummySocket, WSAID_ACCEPTEX, reinterpret_cast<LPVOID*>(&AcceptEx)));
 	closesocket(dummySocket);
+#else
+	// 끊긴 소켓에 writev 시 프로세스가 종료되지 않도록 EPIPE로 받음
+	signal(SIGPIPE, SIG_IGN);
+#endif
 }
 
 void SocketUtils::Clear()
@@ -37,6 +45,7 @@ void SocketUtils::Clear()
 }
 
 
+#ifdef _WIN32
 /**
  * \brief 비동기 IO 함수의 주소를 받아오는 함수
  * \param socket 더미 소켓
@@ -50,6 +59,7 @@ bool SocketUtils::BindWindowsFunction(SOCKET socket, GUID guid, LPVOID* fn)
 	return SOCKET_ERROR != WSAIoctl(socket, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), fn, sizeof(*fn),
 	                                OUT &bytes, nullptr, nullptr);
 }
+#endif
 
 
 /**
@@ -58,5 +68,117 @@ bool SocketUtils::BindWindowsFunction(SOCKET socket, GUID guid, LPVOID* fn)
  */
 SOCKET SocketUtils::CreateSocket()
 {
+#ifdef _WIN32
 	return WSASocket(AF_INET, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+#else
+	return socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+#endif
+}
+
+
+/**
+ * \brief Accept 비동기 IO 작업을 요청하는 함수
+ * \details buffer와 receiveLength는 AcceptEx에만 쓰이며 Linux는 Accept 완료 뒤에 첫 데이터를 읽습니다.
+ * \param listenSocket 리슨 소켓
+ * \param acceptSocket 연결된 클라이언트를 받을 미리 생성된 소켓
+ * \param buffer 첫 데이터와 주소 정보를 받을 버퍼. receiveLength + (sizeof(SOCKADDR_IN) + 16) * 2 크기
+ * \param receiveLength 연결과 함께 받을 첫 데이터의 최대 크기. 0이 아니면 데이터가 도착해야 완료됨 (Windows)
+ * \param iocpEvent 완료 시 전달받을 이벤트
+ * \return 작업 요청 성공 여부
+ */
+bool SocketUtils::Accept(SOCKET listenSocket, SOCKET acceptSocket, [[maybe_unused]] BYTE* buffer,
+                         [[maybe_unused]] DWORD receiveLength, IocpEvent* iocpEvent)
+{
+#ifdef _WIN32
+	DWORD bytes = 0;
+	if (false == AcceptEx(listenSocket, acceptSocket, buffer, receiveLength, sizeof(SOCKADDR_IN) + 16, sizeof(SOCKADDR_IN) + 16,
+	                      OUT &bytes, static_cast<LPOVERLAPPED>(iocpEvent)))
+	{
+		return WSAGetLastError() == WSA_IO_PENDING;
+	}
+	return true;
+#else
+	iocpEvent->_socket = listenSocket;
+	iocpEvent->_acceptSocket = acceptSocket;
+	return Iocp::Post(iocpEvent);
+#endif
+}
+
+
+/**
+ * \brief Disconnect 비동기 IO 작업을 요청하는 함수
+ * \param socket 연결을 끊을 소켓
+ * \param iocpEvent 완료 시 전달받을 이벤트
+ * \return 작업 요청 성공 여부
+ */
+bool SocketUtils::Disconnect(SOCKET socket, IocpEvent* iocpEvent)
+{
+#ifdef _WIN32
+	if (false == DisconnectEx(socket, static_cast<LPOVERLAPPED>(iocpEvent), TF_REUSE_SOCKET, 0))
+	{
+		return WSAGetLastError() == WSA_IO_PENDING;
+	}
+	return true;
+#else
+	iocpEvent->_socket = socket;
+	return Iocp::Post(iocpEvent);
+#endif
+}
+
+
+/**
+ * \brief Recv 비동기 IO 작업을 요청하는 함수
+ * \param socket 수신할 소켓
+ * \param wsaBufs 수신 데이터를 담을 버퍼 배열
+ * \param bufCount 버퍼 배열의 길이
+ * \param iocpEvent 완료 시 전달받을 이벤트
+ * \return 작업 요청 성공 여부
+ */
+bool SocketUtils::Recv(SOCKET socket, WSABUF* wsaBufs, int bufCount, IocpEvent* iocpEvent)
+{
+#ifdef _WIN32
+	DWORD numOfBytes = 0;
+	DWORD flags = 0;
+	if (SOCKET_ERROR == WSARecv(socket, wsaBufs, bufCount, OUT &numOfBytes, OUT &flags, iocpEvent, nullptr))
+	{
+		return WSAGetLastError() == WSA_IO_PENDING;
+	}
+	return true;
+#else
+	iocpEvent->_socket = socket;
+	for (int i = 0; i < bufCount; i++)
+	{
+		iocpEvent->_iovs.push_back({wsaBufs[i].buf, wsaBufs[i].len});
+	}
+	return Iocp::Post(iocpEvent);
+#endif
+}
+
+
+/**
+ * \brief Send 비동기 IO 작업을 요청하는 함수
+ * \details 여러개의 버퍼를 한번에 전송합니다. (Scatter-Gather IO)
+ * \param socket 송신할 소켓
+ * \param wsaBufs 보낼 데이터가 담긴 버퍼 배열
+ * \param bufCount 버퍼 배열의 길이
+ * \param iocpEvent 완료 시 전달받을 이벤트
+ * \return 작업 요청 성공 여부
+ */
+bool SocketUtils::Send(SOCKET socket, WSABUF* wsaBufs, int bufCount, IocpEvent* iocpEvent)
+{
+#ifdef _WIN32
+	DWORD numOfBytes = 0;
+	if (SOCKET_ERROR == WSASend(socket, wsaBufs, bufCount, OUT &numOfBytes, 0, iocpEvent, nullptr))
+	{
+		return WSAGetLastError() == WSA_IO_PENDING;
+	}
+	return true;
+#else
+	iocpEvent->_socket = socket;
+	for (int i = 0; i < bufCount; i++)
+	{
+		iocpEvent->_iovs.push_back({wsaBufs[i].buf, wsaBufs[i].len});
+	}
+	return Iocp::Post(iocpEvent);
+#endif
 }
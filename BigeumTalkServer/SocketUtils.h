@@ -1,9 +1,8 @@
 ﻿#pragma once
 
-#include <WinSock2.h>
-#include <MSWSock.h>
-#include <WS2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
+#include "Platform.h"
+
+class IocpEvent;
 
 
 /**
@@ -16,15 +15,26 @@ public:
 	SocketUtils();
 	~SocketUtils();
 
+#ifdef _WIN32
 public:
 	static LPFN_CONNECTEX ConnectEx;
 	static LPFN_DISCONNECTEX DisconnectEx;
 	static LPFN_ACCEPTEX AcceptEx;
+#endif
 
 public:
 	static void Init();
 	static void Clear();
 
+#ifdef _WIN32
 	static bool BindWindowsFunction(SOCKET socket, GUID guid, LPVOID* fn);
+#endif
 	static SOCKET CreateSocket();
+
+	/* 비동기 IO 요청, 실패 시 WSAGetLastError로 원인 확인 */
+	static bool Accept(SOCKET listenSocket, SOCKET acceptSocket, BYTE* buffer, DWORD receiveLength,
+	                   IocpEvent* iocpEvent);
+	static bool Disconnect(SOCKET socket, IocpEvent* iocpEvent);
+	static bool Recv(SOCKET socket, WSABUF* wsaBufs, int bufCount, IocpEvent* iocpEvent);
+	static bool Send(SOCKET socket, WSABUF* wsaBufs, int bufCount, IocpEvent* iocpEvent);
 };
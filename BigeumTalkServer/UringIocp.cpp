@@ -0,0 +1,800 @@
+﻿#include "pch.h"
+#include "Iocp.h"
+
+#if !defined(_WIN32) && defined(USE_IO_URING)
+
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+namespace
+{
+	enum : unsigned int
+	{
+		SQ_ENTRIES = 4096,
+	};
+
+	/* user_data 하위 2비트에 담는 완료 종류 */
+	enum : uint64_t
+	{
+		TAG_EVENT = 0, // 단발 요청 (Send, Disconnect, 버퍼 부족 시 Recv), 포인터가 없으면 결과를 보지 않는 내부 요청
+		TAG_COMPLETED = 1, // 요청 즉시 완료되어 NOP로 전달되는 이벤트
+		TAG_ACCEPT = 2, // 멀티샷 Accept, IocpObject
+		TAG_RECV = 3, // 멀티샷 Recv, IocpObject
+		TAG_MASK = 3,
+	};
+
+	// Dispatch 중인 스레드가 자기 링에 넣은 요청은 다음 io_uring_enter에서 완료 대기와 함께 제출
+	thread_local Iocp* LDispatching = nullptr;
+
+	uint64_t MakeUserData(void* ptr, uint64_t tag)
+	{
+		return reinterpret_cast<uint64_t>(ptr) | tag;
+	}
+}
+
+Iocp::Iocp(unsigned int batchSize)
+	: _batchSize(clamp<unsigned int>(batchSize, 1, MAX_BATCH_SIZE))
+{
+	// io_uring 생성
+	io_uring_params params = {};
+	_iocpHandle = static_cast<int>(syscall(__NR_io_uring_setup, SQ_ENTRIES, &params));
+	ASSERT_CRASH(_iocpHandle >= 0);
+	ASSERT_CRASH(params.features & IORING_FEAT_SINGLE_MMAP);
+
+	// 제출/완료 큐 매핑
+	const size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	const size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	_ringSize = max(sqSize, cqSize);
+	void* ring = mmap(nullptr, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _iocpHandle,
+	                  IORING_OFF_SQ_RING);
+	ASSERT_CRASH(ring != MAP_FAILED);
+	_ringMemory = static_cast<BYTE*>(ring);
+
+	void* sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+	                  MAP_SHARED | MAP_POPULATE, _iocpHandle, IORING_OFF_SQES);
+	ASSERT_CRASH(sqes != MAP_FAILED);
+	_sqes = static_cast<io_uring_sqe*>(sqes);
+
+	_sqHead = reinterpret_cast<unsigned int*>(_ringMemory + params.sq_off.head);
+	_sqTail = reinterpret_cast<unsigned int*>(_ringMemory + params.sq_off.tail);
+	_sqArray = reinterpret_cast<unsigned int*>(_ringMemory + params.sq_off.array);
+	_sqMask = *reinterpret_cast<unsigned int*>(_ringMemory + params.sq_off.ring_mask);
+	_sqEntries = params.sq_entries;
+
+	_cqHead = reinterpret_cast<unsigned int*>(_ringMemory + params.cq_off.head);
+	_cqTail = reinterpret_cast<unsigned int*>(_ringMemory + params.cq_off.tail);
+	_cqMask = *reinterpret_cast<unsigned int*>(_ringMemory + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<io_uring_cqe*>(_ringMemory + params.cq_off.cqes);
+
+	// 커널 제공 수신 버퍼 링 등록
+	void* bufferRing = mmap(nullptr, RECV_BUFFER_COUNT * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+	                        MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	ASSERT_CRASH(bufferRing != MAP_FAILED);
+	_bufferRing = static_cast<io_uring_buf_ring*>(bufferRing);
+	_bufferRing->tail = 0;
+
+	io_uring_buf_reg reg = {};
+	reg.ring_addr = reinterpret_cast<uint64_t>(_bufferRing);
+	reg.ring_entries = RECV_BUFFER_COUNT;
+	reg.bgid = RECV_BUFFER_GROUP;
+	ASSERT_CRASH(syscall(__NR_io_uring_register, _iocpHandle, IORING_REGISTER_PBUF_RING, &reg, 1) == 0);
+
+	_recvBuffers.resize(RECV_BUFFER_COUNT * RECV_BUFFER_SIZE);
+	for (unsigned short bufferId = 0; bufferId < RECV_BUFFER_COUNT; bufferId++)
+	{
+		RecycleBuffer(bufferId);
+	}
+}
+
+Iocp::~Iocp()
+{
+	munmap(_bufferRing, RECV_BUFFER_COUNT * sizeof(io_uring_buf));
+	munmap(_sqes, _sqEntries * sizeof(io_uring_sqe));
+	munmap(_ringMemory, _ringSize);
+	close(_iocpHandle);
+}
+
+
+/**
+ * \brief io_uring에 객체를 연결
+ * \details io_uring은 요청마다 소켓을 지정하므로 요청을 받을 Iocp만 기록합니다.
+ * \param iocpObject 연결할 iocpObject(Session, Listener)
+ * \return 연결 성공 여부
+ */
+bool Iocp::Register(shared_ptr<IocpObject> iocpObject)
+{
+	iocpObject->_iocp = this;
+	return true;
+}
+
+
+/**
+ * \brief 객체를 io_uring에서 분리하는 함수
+ * \details 전달되지 못한 멀티샷 결과를 정리합니다. Recv의 커널 제공 버퍼는 링에 반납하고 Accept 소켓은 닫습니다.
+ * \param iocpObject 분리할 객체. 완료되지 않은 비동기 IO가 없어야 합니다.
+ */
+void Iocp::Unregister(IocpObject* iocpObject)
+{
+	lock_guard lock(iocpObject->_ioMutex);
+	for (const UringResult& ready : iocpObject->_readyReads)
+	{
+		if (ready.result <= 0)
+		{
+			continue;
+		}
+
+		if (ready.type == EventType::Accept)
+		{
+			closesocket(ready.result);
+		}
+		else
+		{
+			RecycleBuffer(ready.bufferId);
+		}
+	}
+	iocpObject->_readyReads.clear();
+	iocpObject->_pendingReads.clear();
+}
+
+
+/**
+ * \brief io_uring 완료 패킷 처리 함수
+ * \details 쌓인 요청의 제출과 완료 대기를 한번의 io_uring_enter로 처리하고, 최대 _batchSize개의 완료를 꺼내 처리합니다.
+ * \param timeoutMs 완료를 기다릴 시간. 기본값은 INFINITE
+ * \return 완료 패킷 처리 성공 여부
+ */
+bool Iocp::Dispatch(unsigned timeoutMs)
+{
+	LDispatching = this;
+
+	io_uring_cqe cqes[MAX_BATCH_SIZE];
+	unsigned int count = Reap(OUT cqes, _batchSize);
+	if (count > 0)
+	{
+		// 완료 큐가 비지 않았어도 쌓인 요청은 제출
+		Submit();
+	}
+	else
+	{
+		const unsigned int toSubmit = _unsubmitted.exchange(0);
+		if (timeoutMs == INFINITE)
+		{
+			Enter(toSubmit, 1, IORING_ENTER_GETEVENTS);
+		}
+		else
+		{
+			__kernel_timespec ts = {};
+			ts.tv_sec = timeoutMs / 1000;
+			ts.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+
+			io_uring_getevents_arg arg = {};
+			arg.sigmask_sz = _NSIG / 8;
+			arg.ts = reinterpret_cast<uint64_t>(&ts);
+			Enter(toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+		}
+
+		count = Reap(OUT cqes, _batchSize);
+		if (count == 0)
+		{
+			// 타임아웃 또는 시그널 인터럽트
+			return false;
+		}
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const io_uring_cqe& cqe = cqes[i];
+		void* ptr = reinterpret_cast<void*>(cqe.user_data & ~static_cast<uint64_t>(TAG_MASK));
+		switch (cqe.user_data & TAG_MASK)
+		{
+		case TAG_EVENT:
+			if (ptr != nullptr)
+			{
+				OnEvent(static_cast<IocpEvent*>(ptr), cqe.res);
+			}
+			break;
+		case TAG_COMPLETED:
+			Complete(static_cast<IocpEvent*>(ptr));
+			break;
+		case TAG_ACCEPT:
+			OnAccept(static_cast<IocpObject*>(ptr), cqe.res, cqe.flags);
+			break;
+		case TAG_RECV:
+			OnRecv(static_cast<IocpObject*>(ptr), cqe.res, cqe.flags);
+			break;
+		default:
+			break;
+		}
+	}
+
+	RecordBatch(count);
+	return true;
+}
+
+
+/**
+ * \brief 비동기 IO 작업 요청 함수
+ * \details Accept/Recv는 객체당 하나의 멀티샷 요청을 유지하고, 이미 도착한 결과가 있으면 바로 완료합니다.
+ * \param iocpEvent 작업 정보가 담긴 이벤트. _owner가 Register된 객체여야 합니다.
+ * \return 작업 요청 성공 여부
+ */
+bool Iocp::Post(IocpEvent* iocpEvent)
+{
+	// 요청한 쪽이 객체의 참조를 가지고 있으므로 요청 도중 다른 스레드에서 완료되어도 객체가 유지됨
+	IocpObject* iocpObject = iocpEvent->_owner;
+	Iocp* iocp = iocpObject->_iocp;
+	if (iocp == nullptr)
+	{
+		errno = EBADF;
+		return false;
+	}
+
+	switch (iocpEvent->GetEventType())
+	{
+	case EventType::Accept:
+	case EventType::Recv:
+		{
+			bool completed = false;
+			bool arm = false;
+			{
+				lock_guard lock(iocpObject->_ioMutex);
+				if (iocpObject->_readyReads.empty() == false)
+				{
+					if (iocpEvent->GetEventType() == EventType::Accept)
+					{
+						Adopt(iocpEvent, iocpObject->_readyReads.front().result);
+						iocpObject->_readyReads.pop_front();
+					}
+					else
+					{
+						iocp->Fill(iocpEvent, iocpObject->_readyReads);
+					}
+					completed = true;
+				}
+				else
+				{
+					iocpObject->_pendingReads.push_back(iocpEvent);
+					if (iocpObject->_multishotArmed == false)
+					{
+						iocpObject->_multishotArmed = true;
+						iocpObject->AddRef();
+						arm = true;
+					}
+				}
+			}
+
+			if (completed)
+			{
+				iocp->PostCompleted(iocpEvent);
+			}
+			else if (arm)
+			{
+				iocp->Arm(iocpObject, iocpEvent->GetEventType());
+			}
+			break;
+		}
+	case EventType::Send:
+		{
+			// Scatter-Gather IO, 여러 세션의 송신은 한번의 io_uring_enter로 함께 제출됨
+			// IOV_MAX를 넘는 버퍼는 부분 송신과 같이 완료 후 이어서 송신
+			iocp->PushMessage(iocpEvent, IORING_OP_SENDMSG);
+			break;
+		}
+	case EventType::Disconnect:
+		{
+			// 멀티샷 Recv는 shutdown으로 0 바이트 완료되며 종료됨
+			io_uring_sqe sqe = {};
+			sqe.opcode = IORING_OP_SHUTDOWN;
+			sqe.fd = iocpEvent->_socket;
+			sqe.len = SHUT_RDWR;
+			sqe.user_data = MakeUserData(iocpEvent, TAG_EVENT);
+			iocp->Push(sqe);
+			break;
+		}
+	default:
+		errno = EINVAL;
+		return false;
+	}
+
+	if (LDispatching != iocp)
+	{
+		// 다른 샤드의 링은 그 스레드가 대기중일 수 있으므로 바로 제출
+		iocp->Submit();
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief 대기중인 Accept/Recv 작업을 취소하는 함수
+ * \details CancelIoEx처럼 아직 수행되지 않은 작업을 대기열에서 빼고 ECANCELED 실패로 완료합니다.
+ * \param iocpEvent 취소할 이벤트. 요청한 객체의 샤드 스레드에서 호출해야 합니다.
+ * \return 취소 여부. 이미 수행되었거나 완료되었다면 false
+ */
+bool Iocp::Cancel(IocpEvent* iocpEvent)
+{
+	IocpObject* iocpObject = iocpEvent->_owner;
+	Iocp* iocp = iocpObject->_iocp;
+	if (iocp == nullptr)
+	{
+		return false;
+	}
+
+	{
+		lock_guard lock(iocpObject->_ioMutex);
+		auto it = find(iocpObject->_pendingReads.begin(), iocpObject->_pendingReads.end(), iocpEvent);
+		if (it == iocpObject->_pendingReads.end())
+		{
+			return false;
+		}
+		iocpObject->_pendingReads.erase(it);
+	}
+
+	iocpEvent->_errorCode = ECANCELED;
+	iocpEvent->_numOfBytes = 0;
+	iocp->PostCompleted(iocpEvent);
+	if (LDispatching != iocp)
+	{
+		iocp->Submit();
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief 객체의 멀티샷 Accept/Recv 요청 함수
+ * \param iocpObject 요청할 객체. _multishotArmed가 설정되어 있어야 합니다.
+ * \param type Accept 또는 Recv
+ */
+void Iocp::Arm(IocpObject* iocpObject, EventType type)
+{
+	io_uring_sqe sqe = {};
+	sqe.fd = iocpObject->GetHandle();
+
+	if (type == EventType::Accept)
+	{
+		sqe.opcode = IORING_OP_ACCEPT;
+		sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+		// 송수신은 SENDMSG/RECVMSG로 요청하여 O_NONBLOCK 소켓이어도 준비될 때까지 커널이 기다림
+		sqe.accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+		sqe.user_data = MakeUserData(iocpObject, TAG_ACCEPT);
+	}
+	else
+	{
+		sqe.opcode = IORING_OP_RECV;
+		sqe.ioprio = IORING_RECV_MULTISHOT;
+		sqe.flags = IOSQE_BUFFER_SELECT;
+		sqe.buf_group = RECV_BUFFER_GROUP;
+		sqe.user_data = MakeUserData(iocpObject, TAG_RECV);
+	}
+
+	Push(sqe);
+}
+
+
+/**
+ * \brief 이벤트의 버퍼로 단발 SENDMSG/RECVMSG를 요청하는 함수
+ * \details 소켓 요청은 준비되지 않았다면 커널이 준비 알림을 기다렸다가 수행하므로 소켓을 블로킹으로 바꾸지 않습니다.
+ * \param iocpEvent 버퍼 목록(_iovs)이 담긴 이벤트, IOV_MAX개까지만 요청
+ * \param opcode IORING_OP_SENDMSG 또는 IORING_OP_RECVMSG
+ */
+void Iocp::PushMessage(IocpEvent* iocpEvent, unsigned char opcode)
+{
+	iocpEvent->_msg = {};
+	iocpEvent->_msg.msg_iov = iocpEvent->_iovs.data();
+	iocpEvent->_msg.msg_iovlen = min<size_t>(iocpEvent->_iovs.size(), IOV_MAX);
+
+	io_uring_sqe sqe = {};
+	sqe.opcode = opcode;
+	sqe.fd = iocpEvent->_socket;
+	sqe.addr = reinterpret_cast<uint64_t>(&iocpEvent->_msg);
+	sqe.len = 1;
+	sqe.user_data = MakeUserData(iocpEvent, TAG_EVENT);
+	Push(sqe);
+}
+
+
+/**
+ * \brief 이미 완료된 이벤트를 NOP 요청으로 완료 큐에 전달하는 함수
+ * \param iocpEvent 결과가 채워진 이벤트
+ */
+void Iocp::PostCompleted(IocpEvent* iocpEvent)
+{
+	io_uring_sqe sqe = {};
+	sqe.opcode = IORING_OP_NOP;
+	sqe.user_data = MakeUserData(iocpEvent, TAG_COMPLETED);
+	Push(sqe);
+}
+
+
+/**
+ * \brief 제출 큐에 요청을 넣는 함수
+ * \param sqe 요청 내용
+ */
+void Iocp::Push(const io_uring_sqe& sqe)
+{
+	lock_guard lock(_sqMutex);
+	while (true)
+	{
+		const unsigned int head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+		const unsigned int tail = *_sqTail;
+		if (tail - head < _sqEntries)
+		{
+			const unsigned int index = tail & _sqMask;
+			_sqes[index] = sqe;
+			_sqArray[index] = index;
+			__atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+			_unsubmitted.fetch_add(1);
+			return;
+		}
+
+		// 제출 큐가 가득 참, 커널에 넘긴 후 재시도
+		Enter(_unsubmitted.exchange(0), 0, 0);
+	}
+}
+
+
+/**
+ * \brief 쌓인 요청을 기다리지 않고 제출하는 함수
+ */
+void Iocp::Submit()
+{
+	const unsigned int toSubmit = _unsubmitted.exchange(0);
+	if (toSubmit > 0)
+	{
+		Enter(toSubmit, 0, 0);
+	}
+}
+
+
+/**
+ * \brief io_uring_enter 시스템 콜 함수
+ * \return 제출된 요청 수. 실패 시 -1
+ */
+int Iocp::Enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, _iocpHandle, toSubmit, minComplete, flags, arg, argSize));
+}
+
+
+/**
+ * \brief 완료 큐에서 완료 정보를 꺼내는 함수
+ * \param cqes 꺼낸 완료 정보를 담을 배열
+ * \param maxCount 꺼낼 최대 개수
+ * \return 꺼낸 완료 정보 수
+ */
+unsigned int Iocp::Reap(io_uring_cqe* cqes, unsigned int maxCount)
+{
+	lock_guard lock(_cqMutex);
+	const unsigned int head = *_cqHead;
+	const unsigned int count = min(__atomic_load_n(_cqTail, __ATOMIC_ACQUIRE) - head, maxCount);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		cqes[i] = _cqes[(head + i) & _cqMask];
+	}
+
+	if (count > 0)
+	{
+		__atomic_store_n(_cqHead, head + count, __ATOMIC_RELEASE);
+	}
+	return count;
+}
+
+
+/**
+ * \brief 단발 요청 완료 처리 함수
+ * \param iocpEvent 요청한 이벤트
+ * \param result 완료 결과. 음수면 -errno
+ */
+void Iocp::OnEvent(IocpEvent* iocpEvent, int result)
+{
+	if (result < 0)
+	{
+		// IOCP와 같이 실패한 작업은 0 바이트로 완료
+		iocpEvent->_errorCode = -result;
+		iocpEvent->_numOfBytes = 0;
+		Complete(iocpEvent);
+		return;
+	}
+
+	if (iocpEvent->GetEventType() == EventType::Send)
+	{
+		iocpEvent->_numOfBytes += result;
+
+		// 부분 송신이면 보낸 만큼 버퍼를 소모하고 나머지 송신
+		size_t numOfBytes = result;
+		auto iov = iocpEvent->_iovs.begin();
+		while (iov != iocpEvent->_iovs.end() && numOfBytes >= iov->iov_len)
+		{
+			numOfBytes -= iov->iov_len;
+			++iov;
+		}
+		iocpEvent->_iovs.erase(iocpEvent->_iovs.begin(), iov);
+
+		if (iocpEvent->_iovs.empty() == false && result > 0)
+		{
+			iocpEvent->_iovs.front().iov_base = static_cast<BYTE*>(iocpEvent->_iovs.front().iov_base) + numOfBytes;
+			iocpEvent->_iovs.front().iov_len -= numOfBytes;
+
+			PushMessage(iocpEvent, IORING_OP_SENDMSG);
+			return;
+		}
+	}
+	else
+	{
+		iocpEvent->_numOfBytes = result;
+	}
+
+	Complete(iocpEvent);
+}
+
+
+/**
+ * \brief 멀티샷 Accept 완료 처리 함수
+ * \param iocpObject 리슨 객체
+ * \param result 연결된 소켓. 음수면 -errno
+ * \param flags 완료 플래그
+ */
+void Iocp::OnAccept(IocpObject* iocpObject, int result, unsigned flags)
+{
+	IocpEvent* iocpEvent = nullptr;
+	bool arm = false;
+	bool disarmed = false;
+	{
+		lock_guard lock(iocpObject->_ioMutex);
+
+		if (result >= 0)
+		{
+			if (iocpObject->_pendingReads.empty() == false)
+			{
+				iocpEvent = iocpObject->_pendingReads.front();
+				iocpObject->_pendingReads.pop_front();
+			}
+			else
+			{
+				iocpObject->_readyReads.push_back({result, 0, 0, EventType::Accept});
+			}
+		}
+
+		if ((flags & IORING_CQE_F_MORE) == 0)
+		{
+			// 멀티샷 종료, 대기중인 Accept가 있으면 다시 요청
+			arm = iocpObject->_pendingReads.empty() == false;
+			if (arm == false)
+			{
+				iocpObject->_multishotArmed = false;
+				disarmed = true;
+			}
+		}
+	}
+
+	if (arm)
+	{
+		Arm(iocpObject, EventType::Accept);
+	}
+
+	if (iocpEvent != nullptr)
+	{
+		Adopt(iocpEvent, result);
+		Complete(iocpEvent);
+	}
+
+	if (disarmed)
+	{
+		// 멀티샷 요청이 가지고 있던 참조 해제
+		iocpObject->ReleaseRef();
+	}
+}
+
+
+/**
+ * \brief 멀티샷 Recv 완료 처리 함수
+ * \details 대기중인 RecvEvent가 있으면 커널 제공 버퍼의 데이터를 옮겨 완료하고, 없으면 다음 요청까지 보관합니다.
+ * \details 보관한 결과가 MAX_READY_RECV개가 되면 멀티샷 요청을 취소하여 한 세션이 버퍼 링을 모두 차지하지 못하게 합니다.
+ * \param iocpObject 세션 객체
+ * \param result 수신 바이트 수. 음수면 -errno
+ * \param flags 완료 플래그, 상위 비트에 버퍼 id
+ */
+void Iocp::OnRecv(IocpObject* iocpObject, int result, unsigned flags)
+{
+	IocpEvent* iocpEvent = nullptr;
+	bool fallback = false;
+	bool cancel = false;
+	bool arm = false;
+	bool disarmed = false;
+	{
+		lock_guard lock(iocpObject->_ioMutex);
+
+		const bool more = (flags & IORING_CQE_F_MORE) != 0;
+		const bool cancelled = more == false && iocpObject->_recvCancelling && result == -ECANCELED;
+		if (more == false)
+		{
+			iocpObject->_recvCancelling = false;
+		}
+
+		if (result == -ENOBUFS)
+		{
+			// 커널 제공 버퍼 부족, 대기중인 요청은 세션 버퍼로 단발 수신
+			if (iocpObject->_pendingReads.empty() == false)
+			{
+				iocpEvent = iocpObject->_pendingReads.front();
+				iocpObject->_pendingReads.pop_front();
+				fallback = true;
+			}
+		}
+		else if (cancelled == false)
+		{
+			// 오류는 연결 종료와 같이 0 바이트로 처리
+			const unsigned short bufferId = static_cast<unsigned short>(flags >> IORING_CQE_BUFFER_SHIFT);
+			if (result > 0)
+			{
+				iocpObject->_readyReads.push_back({result, bufferId, 0, EventType::Recv});
+			}
+			else
+			{
+				if (flags & IORING_CQE_F_BUFFER)
+				{
+					RecycleBuffer(bufferId);
+				}
+				iocpObject->_readyReads.push_back({0, 0, 0, EventType::Recv});
+			}
+
+			if (iocpObject->_pendingReads.empty() == false)
+			{
+				iocpEvent = iocpObject->_pendingReads.front();
+				iocpObject->_pendingReads.pop_front();
+				Fill(iocpEvent, iocpObject->_readyReads);
+			}
+			else if (more && iocpObject->_recvCancelling == false
+				&& iocpObject->_readyReads.size() >= MAX_READY_RECV)
+			{
+				// 세션이 처리하는 것보다 빨리 받는 중, 보관한 결과를 가져갈 때까지 수신 중단
+				iocpObject->_recvCancelling = true;
+				cancel = true;
+			}
+		}
+
+		if (more == false)
+		{
+			// 멀티샷 종료, 대기중인 Recv가 남아 있으면 다시 요청하고 아니면 다음 Post에서 요청
+			arm = iocpObject->_pendingReads.empty() == false;
+			if (arm == false)
+			{
+				iocpObject->_multishotArmed = false;
+				disarmed = true;
+			}
+		}
+	}
+
+	if (cancel)
+	{
+		// 취소 결과는 멀티샷 요청의 마지막 완료(-ECANCELED)로 받으므로 취소 요청 자체의 완료는 받지 않음
+		io_uring_sqe sqe = {};
+		sqe.opcode = IORING_OP_ASYNC_CANCEL;
+		sqe.flags = IOSQE_CQE_SKIP_SUCCESS;
+		sqe.addr = MakeUserData(iocpObject, TAG_RECV);
+		sqe.user_data = MakeUserData(nullptr, TAG_EVENT);
+		Push(sqe);
+	}
+
+	if (arm)
+	{
+		Arm(iocpObject, EventType::Recv);
+	}
+
+	if (fallback)
+	{
+		PushMessage(iocpEvent, IORING_OP_RECVMSG);
+	}
+	else if (iocpEvent != nullptr)
+	{
+		Complete(iocpEvent);
+	}
+
+	if (disarmed)
+	{
+		// 멀티샷 요청이 가지고 있던 참조 해제
+		iocpObject->ReleaseRef();
+	}
+}
+
+
+/**
+ * \brief 완료된 이벤트를 Dispatch 하는 함수
+ * \param iocpEvent 완료된 이벤트
+ */
+void Iocp::Complete(IocpEvent* iocpEvent)
+{
+	// 처리 후 이벤트가 가지고 있던 참조 해제
+	IocpObject* iocpObject = iocpEvent->_owner;
+	iocpObject->Dispatch(iocpEvent, iocpEvent->_numOfBytes);
+	iocpObject->ReleaseRef();
+}
+
+
+/**
+ * \brief 연결된 소켓을 AcceptEx처럼 미리 생성한 세션 소켓 자리로 옮기는 함수
+ * \param iocpEvent AcceptEvent
+ * \param socket 멀티샷 Accept로 받은 소켓
+ */
+void Iocp::Adopt(IocpEvent* iocpEvent, SOCKET socket)
+{
+	if (socket < 0)
+	{
+		iocpEvent->_errorCode = -socket;
+		return;
+	}
+
+	if (dup2(socket, iocpEvent->_acceptSocket) == SOCKET_ERROR)
+	{
+		iocpEvent->_errorCode = errno;
+	}
+	closesocket(socket);
+}
+
+
+/**
+ * \brief 보관된 수신 데이터를 RecvEvent의 버퍼로 옮기는 함수
+ * \details _ioMutex를 잡은 상태에서 호출합니다. 다 옮긴 커널 제공 버퍼는 링에 반납합니다.
+ * \param iocpEvent 데이터를 받을 RecvEvent
+ * \param readyReads 보관된 수신 결과
+ */
+void Iocp::Fill(IocpEvent* iocpEvent, deque<UringResult>& readyReads)
+{
+	int numOfBytes = 0;
+	for (iovec& iov : iocpEvent->_iovs)
+	{
+		size_t written = 0;
+		while (written < iov.iov_len && readyReads.empty() == false)
+		{
+			UringResult& ready = readyReads.front();
+			if (ready.result == 0)
+			{
+				// 연결 종료는 앞선 데이터를 모두 전달한 뒤 0 바이트로 완료
+				if (numOfBytes == 0)
+				{
+					readyReads.pop_front();
+				}
+				iocpEvent->_numOfBytes = numOfBytes;
+				return;
+			}
+
+			const size_t len = min(iov.iov_len - written, static_cast<size_t>(ready.result - ready.offset));
+			memcpy(static_cast<BYTE*>(iov.iov_base) + written,
+			       &_recvBuffers[ready.bufferId * RECV_BUFFER_SIZE + ready.offset], len);
+			written += len;
+			numOfBytes += static_cast<int>(len);
+			ready.offset += static_cast<int>(len);
+
+			if (ready.offset == ready.result)
+			{
+				RecycleBuffer(ready.bufferId);
+				readyReads.pop_front();
+			}
+		}
+	}
+
+	iocpEvent->_numOfBytes = numOfBytes;
+}
+
+
+/**
+ * \brief 커널 제공 버퍼를 링에 반납하는 함수
+ * \param bufferId 반납할 버퍼 id
+ */
+void Iocp::RecycleBuffer(unsigned short bufferId)
+{
+	lock_guard lock(_bufferMutex);
+	const unsigned short tail = _bufferRing->tail;
+	// C++에서는 bufs 멤버의 오프셋이 커널 레이아웃과 달라 링 시작 주소를 배열로 사용
+	io_uring_buf& buf = reinterpret_cast<io_uring_buf*>(_bufferRing)[tail & (RECV_BUFFER_COUNT - 1)];
+	buf.addr = reinterpret_cast<uint64_t>(&_recvBuffers[bufferId * RECV_BUFFER_SIZE]);
+	buf.len = RECV_BUFFER_SIZE;
+	buf.bid = bufferId;
+	__atomic_store_n(&_bufferRing->tail, static_cast<unsigned short>(tail + 1), __ATOMIC_RELEASE);
+}
+#endif
@@ -15,6 +15,7 @@ public:
 
 	unsigned long long userId = 0;
 	string nickname;
+	string encodedUser; // 직렬화된 Protocol::User, 로그인할 때 만들어 브로드캐스트 패킷에 그대로 붙여 씀
 	shared_ptr<Session> ownerSession; // Cycle
 	shared_ptr<Room> room;
 };
@@ -8,6 +8,7 @@
 #include <shared_mutex>
 #include <memory>
 #include <vector>
+#include <array>
 #include <list>
 #include <queue>
 #include <stack>
@@ -16,11 +17,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <atomic>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <chrono>
 
-#include <WinSock2.h>
-#include <MSWSock.h>
-#include <WS2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
+#include "Platform.h"
 
 using namespace std;
 
@@ -29,11 +31,13 @@ using namespace std;
 #include "Session.h"
 
 /* Libraries */
+#ifdef _WIN32
 #ifdef _DEBUG
 #pragma comment(lib, "protobuf\\Debug\\libprotobufd.lib")
 #else
 #pragma comment(lib, "protobuf\\Release\\libprotobuf.lib")
 #endif
+#endif
 
 /* Macro */
 #define CRASH(cause)						\
@@ -51,6 +55,3 @@ using namespace std;
 		__analysis_assume(expr);	\
 	}								\
 }
-
-/* Thread Local Storage */
-extern thread_local shared_ptr<SendBufferChunk> LSendBufferChunk; // 스레드 로컬 송신 버퍼
@@ -0,0 +1,128 @@
+﻿#include "pch.h"
+#include "PacketHandler.h"
+#include "TestUtils.h"
+
+/*
+ * 패킷 디스패치 테이블 테스트
+ * PacketHandlerTable이 만든 배열이 등록한 ID만 처리 함수로 보내고 나머지 ID는 거부하는지 확인합니다.
+ *  - 시험용 항목 : 처리 함수가 불린 횟수를 세어 등록한 ID는 자기 함수로, 빈 칸은 HandleInvalid로 가는지 확인
+ *  - GPacketHandler : 클라이언트 패킷만 등록되어 있는지 확인하고 HandlePacket으로 범위 밖, 빈 칸, 깨진 패킷을 거부하는지 확인
+ */
+
+namespace
+{
+	int GHandled[0x20] = {}; // 시험용 항목이 ID별로 불린 횟수
+
+	/**
+	 * \brief 시험용 테이블 항목
+	 * \details PacketHandlerEntry와 같은 모양이며 파싱 없이 불린 횟수만 셉니다.
+	 */
+	template <unsigned short Id>
+	struct CountingEntry
+	{
+		static constexpr unsigned short ID = Id;
+
+		static bool Handle(shared_ptr<Session>&, BYTE*, int len)
+		{
+			GHandled[Id]++;
+			return len == Id;
+		}
+	};
+
+	using CountingTable = PacketHandlerTable<CountingEntry<9>, CountingEntry<1>, CountingEntry<4>>;
+
+	constexpr auto GCountingHandler = CountingTable::Build();
+
+	static_assert(CountingTable::SIZE == 10, "table size must be max id + 1");
+	static_assert(GCountingHandler[0] == &CountingTable::HandleInvalid, "unregistered id must be rejected");
+	static_assert(GCountingHandler[1] == &CountingEntry<1>::Handle, "registered id must dispatch to its entry");
+	static_assert(GCountingHandler[9] == &CountingEntry<9>::Handle, "registered id must dispatch to its entry");
+
+	void TestCountingTable()
+	{
+		shared_ptr<Session> session;
+		BYTE buffer[sizeof(PacketHeader)] = {};
+
+		for (unsigned short id = 0; id < CountingTable::SIZE; id++)
+		{
+			const bool registered = id == 1 || id == 4 || id == 9;
+			TEST_CHECK(GCountingHandler[id](session, buffer, id) == registered);
+			TEST_CHECK(GCountingHandler[id](session, buffer, id + 1) == false);
+		}
+
+		for (unsigned short id = 0; id < size(GHandled); id++)
+		{
+			const bool registered = id == 1 || id == 4 || id == 9;
+			TEST_CHECK(GHandled[id] == (registered ? 2 : 0));
+		}
+	}
+
+	/**
+	 * \brief 헤더와 본문으로 패킷을 만드는 함수
+	 */
+	vector<BYTE> MakePacket(unsigned short id, const vector<BYTE>& body)
+	{
+		vector<BYTE> packet(sizeof(PacketHeader) + body.size());
+		auto header = reinterpret_cast<PacketHeader*>(packet.data());
+		header->id = id;
+		header->size = static_cast<unsigned short>(packet.size());
+		copy(body.begin(), body.end(), packet.begin() + sizeof(PacketHeader));
+		return packet;
+	}
+
+	void TestPacketHandler()
+	{
+		static const unsigned short clientIds[] = {
+			Protocol::PACKET_ID_C_LOGIN, Protocol::PACKET_ID_C_CREATE_ROOM, Protocol::PACKET_ID_C_ENTER_ROOM,
+			Protocol::PACKET_ID_C_LEAVE_ROOM, Protocol::PACKET_ID_C_ROOM_LIST, Protocol::PACKET_ID_C_CHAT,
+		};
+
+		TEST_CHECK(GPacketHandler.size() == Protocol::PACKET_ID_C_CHAT + 1);
+		for (unsigned short id = 0; id < GPacketHandler.size(); id++)
+		{
+			const bool registered = find(begin(clientIds), end(clientIds), id) != end(clientIds);
+			TEST_CHECK((GPacketHandler[id] != &PacketHandlerList::HandleInvalid) == registered);
+		}
+
+		// 세션이 없으므로 처리 함수까지 가면 멈추지만, 아래 패킷은 모두 그 전에 거부되어야 함
+		shared_ptr<Session> session;
+
+		// 테이블 밖의 ID, 압축 표시가 없으면 세션을 보지 않고 거부
+		for (unsigned int id = static_cast<unsigned int>(GPacketHandler.size()); id < PACKET_ID_COMPRESSED_FLAG; id++)
+		{
+			auto packet = MakePacket(static_cast<unsigned short>(id), {});
+			TEST_CHECK(PacketHandler::HandlePacket(session, packet.data(), static_cast<int>(packet.size())) == false);
+		}
+
+		// 테이블 안의 빈 칸 (NONE과 서버 패킷)
+		for (unsigned short id = 0; id < GPacketHandler.size(); id++)
+		{
+			if (find(begin(clientIds), end(clientIds), id) != end(clientIds))
+			{
+				continue;
+			}
+			auto packet = MakePacket(id, {0x0A, 0x01, 'a'});
+			TEST_CHECK(PacketHandler::HandlePacket(session, packet.data(), static_cast<int>(packet.size())) == false);
+		}
+
+		// 등록한 ID라도 파싱에 실패하면 처리 함수를 부르지 않음 (길이가 본문을 넘는 필드, 끝난 varint)
+		for (unsigned short id : clientIds)
+		{
+			for (const vector<BYTE>& body : {vector<BYTE>{0x0A, 0x05, 'a'}, vector<BYTE>{0x08, 0x80}, vector<BYTE>{0x0F}})
+			{
+				auto packet = MakePacket(id, body);
+				TEST_CHECK(PacketHandler::HandlePacket(session, packet.data(), static_cast<int>(packet.size())) == false);
+			}
+		}
+
+		PacketHandler::ResetArena();
+	}
+}
+
+
+int main()
+{
+	TestCountingTable();
+	TestPacketHandler();
+	return 0;
+}
@@ -0,0 +1,347 @@
+﻿#include "pch.h"
+#include "Service.h"
+#include "Session.h"
+#include "PacketHandler.h"
+#include "TestUtils.h"
+#include <optional>
+
+/*
+ * 수신 프레임 조립 테스트
+ * 루프백에 서비스를 띄우고 실제 소켓으로 바이트를 보내 Session::ProcessRecv와 ProcessFrame이 프레임을 나누고 모으는지 확인합니다.
+ *  - 잘린 헤더 : 패킷을 1 바이트씩 나누어 보내도, 여러 패킷을 한번에 이어 보내도 패킷마다 응답하는지 확인
+ *  - 큰 프레임 : v2를 협상한 뒤 수신 버퍼(최대 64KB)보다 큰 프레임을 나누어 보내면 _frameBuffer에 모아 처리하는지 확인
+ *  - 잘못된 크기 : 협상하지 않은 size 0 헤더, 헤더보다 작은 크기, 최대 프레임 크기를 넘는 v2 프레임이면 연결을 끊는지 확인
+ * 0 바이트 수신을 켠 서비스와 끈 서비스에서 모두 확인합니다.
+ */
+
+namespace
+{
+	enum
+	{
+		BASE_PORT = 3917, // 0 바이트 수신을 끈 서비스, 켠 서비스는 다음 포트
+		RECV_TIMEOUT_MS = 5000, // 응답을 기다리는 시간, 넘으면 실패
+		LARGE_NICKNAME_SIZE = 0x30000, // 가장 큰 수신 버퍼(0x10000)보다 큰 프레임이 되는 닉네임 크기
+		MAX_FRAME_SIZE = 0x100000, // Session의 최대 v2 프레임 크기 기본값
+	};
+
+	atomic<bool> GRunning = true;
+	int GNicknameId = 0; // 서비스 안에서 닉네임이 겹치지 않도록 붙이는 번호
+
+	struct Packet
+	{
+		unsigned short id;
+		string body;
+	};
+
+	/**
+	 * \brief 루프백 서비스에 접속하는 함수
+	 * \param port 접속할 포트
+	 * \return 수신 시간 제한을 설정한 클라이언트 소켓
+	 */
+	SOCKET ConnectClient(unsigned short port)
+	{
+		SOCKET client = socket(AF_INET, SOCK_STREAM, 0);
+		TEST_CHECK(client != INVALID_SOCKET);
+
+		// 나누어 보낸 바이트가 모이지 않고 각각 도착하도록 Nagle 끄기
+		int noDelay = 1;
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+		timeval timeout = {RECV_TIMEOUT_MS / 1000, 0};
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+		SOCKADDR_IN address = {};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		TEST_CHECK(connect(client, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) == 0);
+
+		return client;
+	}
+
+	/**
+	 * \brief 바이트열을 보내는 함수
+	 * \param chunkSize 한번에 보낼 크기, 0이면 한번에 보냄
+	 */
+	void SendBytes(SOCKET client, const string& bytes, size_t chunkSize = 0)
+	{
+		if (chunkSize == 0)
+		{
+			chunkSize = bytes.size();
+		}
+
+		for (size_t offset = 0; offset < bytes.size(); offset += chunkSize)
+		{
+			const size_t size = min(chunkSize, bytes.size() - offset);
+			TEST_CHECK(send(client, bytes.data() + offset, size, MSG_NOSIGNAL) == static_cast<ssize_t>(size));
+
+			if (chunkSize < sizeof(PacketHeader))
+			{
+				// 서버가 잘린 헤더를 먼저 받도록 잠시 대기
+				this_thread::sleep_for(chrono::milliseconds(1));
+			}
+		}
+	}
+
+	/**
+	 * \brief 정확히 size 바이트를 받는 함수
+	 * \return 다 받았으면 true, 연결이 끊겼으면 false
+	 */
+	bool RecvBytes(SOCKET client, char* buffer, size_t size)
+	{
+		size_t received = 0;
+		while (received < size)
+		{
+			const ssize_t len = recv(client, buffer + received, size - received, 0);
+			if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				// 시간 제한을 넘도록 응답도 연결 종료도 없음
+				fprintf(stderr, "recv timed out\n");
+				exit(1);
+			}
+
+			if (len <= 0)
+			{
+				return false;
+			}
+			received += static_cast<size_t>(len);
+		}
+		return true;
+	}
+
+	/**
+	 * \brief 서버가 보낸 패킷 하나를 받는 함수
+	 * \return 받은 패킷, 연결이 끊겼으면 nullopt
+	 */
+	optional<Packet> RecvPacket(SOCKET client)
+	{
+		PacketHeader header;
+		if (RecvBytes(client, reinterpret_cast<char*>(&header), sizeof(header)) == false)
+		{
+			return nullopt;
+		}
+
+		unsigned int size = header.size;
+		unsigned int headerSize = sizeof(PacketHeader);
+		if (size == 0)
+		{
+			if (RecvBytes(client, reinterpret_cast<char*>(&size), sizeof(size)) == false)
+			{
+				return nullopt;
+			}
+			headerSize = sizeof(PacketHeaderV2);
+		}
+
+		TEST_CHECK(size >= headerSize);
+		Packet packet = {header.id, string(size - headerSize, '\0')};
+		if (RecvBytes(client, packet.body.data(), packet.body.size()) == false)
+		{
+			return nullopt;
+		}
+		return packet;
+	}
+
+	/** \brief 서버가 연결을 끊었는지 확인하는 함수 */
+	bool IsClosedByServer(SOCKET client)
+	{
+		return RecvPacket(client).has_value() == false;
+	}
+
+	/**
+	 * \brief 헤더와 본문으로 프레임을 만드는 함수
+	 * \details 64KB를 넘으면 v2 헤더를 사용합니다.
+	 */
+	string MakeFrame(unsigned short id, const string& body)
+	{
+		string frame;
+		if (body.size() + sizeof(PacketHeader) <= 0xFFFF)
+		{
+			PacketHeader header = {static_cast<unsigned short>(body.size() + sizeof(PacketHeader)), id};
+			frame.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+		else
+		{
+			PacketHeaderV2 header = {0, id, static_cast<unsigned int>(body.size() + sizeof(PacketHeaderV2))};
+			frame.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+		return frame + body;
+	}
+
+	/** \brief 헤더만 있는 프레임을 만드는 함수 */
+	string MakeHeader(unsigned short size, unsigned short id)
+	{
+		PacketHeader header = {size, id};
+		return string(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+
+	/** \brief 겹치지 않는 닉네임으로 로그인하는 프레임을 만드는 함수 */
+	string MakeLogin(size_t nicknameSize = 8)
+	{
+		string nickname = to_string(GNicknameId++);
+		nickname.resize(max(nicknameSize, nickname.size()), 'n');
+
+		Protocol::C_LOGIN pkt;
+		pkt.mutable_user()->set_nickname(nickname);
+		return MakeFrame(Protocol::PACKET_ID_C_LOGIN, pkt.SerializeAsString());
+	}
+
+	/** \brief 로그인 응답을 받았는지 확인하는 함수 */
+	void CheckLoggedIn(SOCKET client)
+	{
+		optional<Packet> packet = RecvPacket(client);
+		TEST_CHECK(packet.has_value());
+		TEST_CHECK(packet->id == Protocol::PACKET_ID_S_LOGIN);
+
+		Protocol::S_LOGIN pkt;
+		TEST_CHECK(pkt.ParseFromString(packet->body));
+		TEST_CHECK(pkt.success());
+	}
+
+	/** \brief v2 프레이밍을 협상하는 함수 */
+	void NegotiateFrameV2(SOCKET client)
+	{
+		SendBytes(client, MakeHeader(sizeof(PacketHeader), PACKET_ID_FRAME_V2));
+
+		optional<Packet> packet = RecvPacket(client);
+		TEST_CHECK(packet.has_value());
+		TEST_CHECK(packet->id == PACKET_ID_FRAME_V2);
+		TEST_CHECK(packet->body.empty());
+	}
+
+	void TestSplitHeader(unsigned short port)
+	{
+		// 1 바이트씩
+		SOCKET client = ConnectClient(port);
+		SendBytes(client, MakeLogin(), 1);
+		CheckLoggedIn(client);
+
+		// 헤더 중간에서 잘린 패킷, 앞 패킷과 함께 도착
+		const string first = MakeLogin();
+		const string second = MakeLogin();
+		SendBytes(client, first + second.substr(0, 3));
+		CheckLoggedIn(client);
+		SendBytes(client, second.substr(3));
+		CheckLoggedIn(client);
+
+		// 본문 중간에서 잘린 패킷
+		const string third = MakeLogin(0x100);
+		SendBytes(client, third.substr(0, 0x80));
+		SendBytes(client, third.substr(0x80));
+		CheckLoggedIn(client);
+
+		closesocket(client);
+	}
+
+	void TestLargeFrame(unsigned short port)
+	{
+		for (size_t chunkSize : {static_cast<size_t>(0), static_cast<size_t>(0x1000), static_cast<size_t>(3)})
+		{
+			SOCKET client = ConnectClient(port);
+			NegotiateFrameV2(client);
+
+			const string large = MakeLogin(LARGE_NICKNAME_SIZE);
+			TEST_CHECK(large.size() > 0x10000);
+			if (chunkSize == 3)
+			{
+				// v2 헤더를 잘라 보낸 뒤 나머지는 한번에
+				SendBytes(client, large.substr(0, sizeof(PacketHeaderV2) - 1), 3);
+				SendBytes(client, large.substr(sizeof(PacketHeaderV2) - 1));
+			}
+			else
+			{
+				SendBytes(client, large, chunkSize);
+			}
+			CheckLoggedIn(client);
+
+			// 큰 프레임 뒤에 바로 이어지는 작은 프레임
+			SendBytes(client, MakeLogin(LARGE_NICKNAME_SIZE) + MakeLogin());
+			CheckLoggedIn(client);
+			CheckLoggedIn(client);
+
+			closesocket(client);
+		}
+	}
+
+	void TestInvalidSize(unsigned short port)
+	{
+		// 협상하지 않은 v2 헤더
+		SOCKET client = ConnectClient(port);
+		SendBytes(client, MakeFrame(Protocol::PACKET_ID_C_LOGIN, string(0x10000, 'n')));
+		TEST_CHECK(IsClosedByServer(client));
+		closesocket(client);
+
+		// 헤더보다 작은 크기
+		client = ConnectClient(port);
+		SendBytes(client, MakeHeader(sizeof(PacketHeader) - 1, Protocol::PACKET_ID_C_LOGIN));
+		TEST_CHECK(IsClosedByServer(client));
+		closesocket(client);
+
+		// v2 헤더보다 작은 v2 프레임
+		client = ConnectClient(port);
+		NegotiateFrameV2(client);
+		PacketHeaderV2 small = {0, Protocol::PACKET_ID_C_LOGIN, sizeof(PacketHeaderV2) - 1};
+		SendBytes(client, string(reinterpret_cast<const char*>(&small), sizeof(small)));
+		TEST_CHECK(IsClosedByServer(client));
+		closesocket(client);
+
+		// 최대 프레임 크기를 넘는 v2 프레임, 본문을 보내기 전에 헤더만 보고 끊음
+		client = ConnectClient(port);
+		NegotiateFrameV2(client);
+		PacketHeaderV2 large = {0, Protocol::PACKET_ID_C_LOGIN, MAX_FRAME_SIZE + 1};
+		SendBytes(client, string(reinterpret_cast<const char*>(&large), sizeof(large)));
+		TEST_CHECK(IsClosedByServer(client));
+		closesocket(client);
+
+		// 최대 크기 그대로는 받음, 모으는 중인 프레임이 깨져 있으면 처리할 때 끊음
+		client = ConnectClient(port);
+		NegotiateFrameV2(client);
+		SendBytes(client, MakeFrame(Protocol::PACKET_ID_C_LOGIN, string(MAX_FRAME_SIZE - sizeof(PacketHeaderV2), '\x0F')), 0x10000);
+		TEST_CHECK(IsClosedByServer(client));
+		closesocket(client);
+	}
+}
+
+
+int main()
+{
+	signal(SIGPIPE, SIG_IGN);
+
+	// 서비스마다 샤드 하나와 워커 스레드 하나
+	vector<shared_ptr<Service>> services;
+	vector<thread> workers;
+	for (bool zeroByteRecv : {false, true})
+	{
+		auto iocp = make_shared<Iocp>(Iocp::MAX_BATCH_SIZE);
+		auto service = make_shared<Service>(iocp, L"127.0.0.1", static_cast<unsigned short>(BASE_PORT + services.size()));
+
+		SessionConfig sessionConfig;
+		sessionConfig.zeroByteRecv = zeroByteRecv;
+		service->SetSessionConfig(sessionConfig);
+
+		TEST_CHECK(service->Start());
+		services.push_back(service);
+
+		workers.push_back(thread([=]()
+		{
+			while (GRunning.load())
+			{
+				service->GetIocp()->Dispatch(10);
+				PacketHandler::ResetArena();
+			}
+		}));
+	}
+
+	for (unsigned short port = BASE_PORT; port < BASE_PORT + services.size(); port++)
+	{
+		TestSplitHeader(port);
+		TestLargeFrame(port);
+		TestInvalidSize(port);
+	}
+
+	GRunning.store(false);
+	for (thread& worker : workers)
+	{
+		worker.join();
+	}
+	return 0;
+}
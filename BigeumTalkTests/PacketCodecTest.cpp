@@ -0,0 +1,465 @@
+﻿#include "pch.h"
+#include "PacketCodec.h"
+#include "PacketHandler.h"
+#include "TestUtils.h"
+#include <cstring>
+
+/*
+ * PacketCodec 동등성 테스트
+ * 손으로 작성한 C_CHAT 파서와 S_CHAT 인코더가 Protocol.pb.cc의 생성 코드와 같게 동작하는지 확인합니다.
+ *  - 파서 : 무작위로 만들고 변형한 입력을 C_CHAT_View와 Protocol::C_CHAT에 함께 넣어 수락 여부와 필드를 비교
+ *  - 인코더 : PacketCodec의 MakeBuffer와 생성 코드의 MakeBuffer가 만든 바이트열을 비교하고 Protocol::S_CHAT으로 다시 파싱
+ */
+
+namespace
+{
+	enum
+	{
+		DECODE_ITERATIONS = 200000,
+		ENCODE_ITERATIONS = 50000,
+		MAX_GROUP_DEPTH = 4, // 무작위 입력의 그룹 중첩 깊이
+	};
+
+	TestRandom R(0xB16E);
+
+	void WriteVarint(string& out, unsigned long long value)
+	{
+		while (value >= 0x80)
+		{
+			out += static_cast<char>(value | 0x80);
+			value >>= 7;
+		}
+		out += static_cast<char>(value);
+	}
+
+	void WriteTag(string& out, unsigned int field, unsigned int wireType)
+	{
+		WriteVarint(out, ((static_cast<unsigned long long>(field) << 3) | wireType) & 0xFFFFFFFF);
+	}
+
+	void WriteLengthDelimited(string& out, unsigned int field, const string& body)
+	{
+		WriteTag(out, field, 2);
+		WriteVarint(out, body.size());
+		out += body;
+	}
+
+	/**
+	 * \brief 무작위 문자열을 만드는 함수
+	 * \details 올바른 UTF-8과 함께 잘린 시퀀스, 과잉 표현, 서로게이트, 범위를 넘는 코드 포인트를 섞습니다.
+	 */
+	string RandomString()
+	{
+		static const char* pieces[] = {
+			"a", "hello", "\xEC\x95\x88", "\xF0\x9F\x98\x80", "\xC3\xA9", "\xEF\xBF\xBF", "\xF4\x8F\xBF\xBF", "\xED\x9F\xBF",
+			"\xEE\x80\x80", "\x00", // 올바른 UTF-8
+			"\xED\xA0\x80", "\xC0\xAF", "\xE0\x80\xAF", "\xF4\x90\x80\x80", "\xFF", "\x80", "\xE2\x82", "\xF0\x9F\x98",
+			"\xF5\x80\x80\x80", // 올바르지 않은 UTF-8
+		};
+
+		string out;
+		unsigned long long length = R.Below(6);
+		if (R.OneIn(50))
+		{
+			length = 200 + R.Below(3000);
+		}
+
+		for (unsigned long long i = 0; i < length; i++)
+		{
+			if (R.OneIn(10))
+			{
+				const char* piece = pieces[R.Below(size(pieces))];
+				out.append(piece, max<size_t>(strlen(piece), 1));
+			}
+			else if (R.OneIn(30))
+			{
+				out += static_cast<char>(R.Below(256));
+			}
+			else
+			{
+				out += static_cast<char>('a' + R.Below(26));
+			}
+		}
+		return out;
+	}
+
+	/**
+	 * \brief 올바른 UTF-8 문자열을 무작위로 만드는 함수, 1 / 5 확률로 빈 문자열
+	 */
+	string RandomUtf8String()
+	{
+		string out;
+		do
+		{
+			out = R.OneIn(5) ? "" : RandomString();
+		}
+		while (Protocol::User().ParseFromString(PacketCodec::EncodeUser(0, out)) == false);
+		return out;
+	}
+
+	void RandomField(string& out, int depth, bool inUser);
+
+	string RandomUser(int depth)
+	{
+		string user;
+		const unsigned long long count = R.Below(4);
+		for (unsigned long long i = 0; i < count; i++)
+		{
+			switch (R.Below(5))
+			{
+			case 0:
+				WriteLengthDelimited(user, 1, RandomString());
+				break;
+			case 1:
+				WriteTag(user, 2, 0);
+				WriteVarint(user, R.OneIn(3) ? R.Next() : R.Below(1000));
+				break;
+			default:
+				RandomField(user, depth + 1, true);
+				break;
+			}
+		}
+		return user;
+	}
+
+	/**
+	 * \brief C_CHAT 또는 User 안에 올 수 있는 필드 하나를 무작위로 쓰는 함수
+	 * \details 알려진 필드와 알 수 없는 필드, 모든 와이어 타입, 그룹, 잘린 varint와 길이를 만듭니다.
+	 */
+	void RandomField(string& out, int depth, bool inUser)
+	{
+		unsigned int field = 1 + static_cast<unsigned int>(R.Below(4));
+		if (R.OneIn(5))
+		{
+			field = static_cast<unsigned int>(R.Below(6));
+		}
+		else if (R.OneIn(4))
+		{
+			field = R.Next() & 0x1FFFFFFF;
+		}
+
+		switch (R.Below(14))
+		{
+		case 0:
+		case 1:
+			WriteLengthDelimited(out, inUser ? 1 : 2, RandomString());
+			break;
+		case 2:
+			if (inUser == false && depth < 3)
+			{
+				WriteLengthDelimited(out, 1, RandomUser(depth));
+			}
+			break;
+		case 3:
+			{
+				// 10 바이트를 넘을 수 있는 varint
+				WriteTag(out, field, 0);
+				const unsigned long long length = R.Below(12);
+				for (unsigned long long i = 0; i < length; i++)
+				{
+					out += static_cast<char>(0x80 | R.Below(128));
+				}
+				out += static_cast<char>(R.Below(128));
+			}
+			break;
+		case 4:
+			WriteTag(out, field, 1);
+			out += string(8, 'x');
+			break;
+		case 5:
+			WriteTag(out, field, 5);
+			out += string(4, 'y');
+			break;
+		case 6:
+			WriteLengthDelimited(out, field, RandomString());
+			break;
+		case 7:
+			if (depth < MAX_GROUP_DEPTH)
+			{
+				// 짝이 맞지 않는 그룹 끝 태그도 만듦
+				WriteTag(out, field, 3);
+				const unsigned long long count = R.Below(3);
+				for (unsigned long long i = 0; i < count; i++)
+				{
+					RandomField(out, depth + 1, inUser);
+				}
+				WriteTag(out, R.OneIn(5) ? field + 1 : field, 4);
+			}
+			break;
+		case 8:
+			WriteTag(out, field, static_cast<unsigned int>(R.Below(8)));
+			break;
+		case 9:
+			WriteVarint(out, R.Next() & 0xFFFFFFFF);
+			break;
+		case 10:
+			out += '\0';
+			break;
+		case 11:
+			WriteTag(out, R.OneIn(2) ? 1 : 2, static_cast<unsigned int>(R.Below(8)));
+			WriteLengthDelimited(out, 2, "");
+			break;
+		case 12:
+			{
+				// 5 바이트 이상의 길이
+				WriteTag(out, 2, 2);
+				const unsigned long long length = 5 + R.Below(2);
+				for (unsigned long long i = 0; i + 1 < length; i++)
+				{
+					out += static_cast<char>(0x80 | R.Below(128));
+				}
+				out += static_cast<char>(R.Below(16));
+			}
+			break;
+		case 13:
+			// INT_MAX 근처의 길이
+			WriteTag(out, R.OneIn(2) ? 1 : 2, 2);
+			out += "\x80\x80\x80\x80";
+			out += static_cast<char>(R.Below(16));
+			out += "abc";
+			break;
+		}
+	}
+
+	string Mutate(string in)
+	{
+		const unsigned long long count = R.Below(4);
+		for (unsigned long long i = 0; i < count; i++)
+		{
+			switch (R.Below(4))
+			{
+			case 0:
+				if (in.empty() == false)
+				{
+					in[R.Below(in.size())] ^= static_cast<char>(1 << R.Below(8));
+				}
+				break;
+			case 1:
+				if (in.empty() == false)
+				{
+					in.resize(R.Below(in.size()));
+				}
+				break;
+			case 2:
+				in.insert(in.begin() + R.Below(in.size() + 1), static_cast<char>(R.Below(256)));
+				break;
+			case 3:
+				if (in.empty() == false)
+				{
+					in.erase(in.begin() + R.Below(in.size()));
+				}
+				break;
+			}
+		}
+		return in;
+	}
+
+	string NestedGroups(int levels, bool closed)
+	{
+		string out;
+		for (int i = 0; i < levels; i++)
+		{
+			WriteTag(out, 5, 3);
+		}
+		for (int i = 0; closed && i < levels; i++)
+		{
+			WriteTag(out, 5, 4);
+		}
+		return out;
+	}
+
+	/**
+	 * \brief 입력 하나를 두 파서에 넣고 결과를 비교하는 함수
+	 * \return 생성 코드가 수락했는지 여부
+	 */
+	bool CheckDecode(const string& in)
+	{
+		Protocol::C_CHAT expected;
+		C_CHAT_View actual;
+		const bool expectedOk = expected.ParseFromArray(in.data(), static_cast<int>(in.size()));
+		const bool actualOk = actual.ParseFromArray(in.data(), static_cast<int>(in.size()));
+		TEST_CHECK(expectedOk == actualOk);
+
+		if (expectedOk)
+		{
+			TEST_CHECK(actual.msg == expected.msg());
+			TEST_CHECK(actual.hasUser == expected.has_user());
+			TEST_CHECK(actual.userId == expected.user().id());
+			TEST_CHECK(actual.nickname == expected.user().nickname());
+		}
+		return expectedOk;
+	}
+
+	void TestDecoder()
+	{
+		// protobuf 파서의 그룹 중첩 제한 경계
+		for (int levels = 95; levels <= 102; levels++)
+		{
+			CheckDecode(NestedGroups(levels, true));
+
+			string nested;
+			WriteLengthDelimited(nested, 1, NestedGroups(levels, true));
+			CheckDecode(nested);
+		}
+
+		int accepted = 0;
+		for (int i = 0; i < DECODE_ITERATIONS; i++)
+		{
+			string in;
+			if (R.OneIn(3))
+			{
+				// 올바른 패킷 뒤에 필드를 덧붙임
+				Protocol::C_CHAT pkt;
+				if (R.OneIn(2))
+				{
+					pkt.mutable_user()->set_nickname("nick\xEC\x95\x88");
+					pkt.mutable_user()->set_id(R.Next());
+				}
+				pkt.set_msg(string(R.Below(300), 'm'));
+				in = pkt.SerializeAsString();
+			}
+
+			const unsigned long long count = R.Below(6);
+			for (unsigned long long k = 0; k < count; k++)
+			{
+				RandomField(in, 0, false);
+			}
+
+			if (R.OneIn(2))
+			{
+				in = Mutate(move(in));
+			}
+
+			accepted += CheckDecode(in) ? 1 : 0;
+		}
+
+		// 수락과 거부가 모두 충분히 나와야 비교에 의미가 있음
+		TEST_CHECK(accepted > DECODE_ITERATIONS / 10);
+		TEST_CHECK(accepted < DECODE_ITERATIONS - DECODE_ITERATIONS / 10);
+		printf("decoder : %d inputs, %d accepted\n", DECODE_ITERATIONS, accepted);
+	}
+
+	/**
+	 * \brief 패킷 버퍼의 헤더 뒤 내용을 파싱하여 다시 직렬화한 것과 같은지 확인하는 함수
+	 */
+	void CheckRoundTrip(const string& packet, unsigned short pktId)
+	{
+		const PacketHeader* header = reinterpret_cast<const PacketHeader*>(packet.data());
+		const size_t headerSize = header->size == 0 ? sizeof(PacketHeaderV2) : sizeof(PacketHeader);
+		TEST_CHECK(header->id == pktId);
+
+		Protocol::S_CHAT pkt;
+		TEST_CHECK(pkt.ParseFromArray(packet.data() + headerSize, static_cast<int>(packet.size() - headerSize)));
+		TEST_CHECK(pkt.SerializeAsString() == packet.substr(headerSize));
+	}
+
+	double RandomTimestamp()
+	{
+		switch (R.Below(5))
+		{
+		case 0:
+			return 0.0;
+		case 1:
+			return -0.0;
+		case 2:
+			return static_cast<double>(R.Below(2000000000));
+		case 3:
+			{
+				const unsigned long long bits = R.Next();
+				double value;
+				memcpy(&value, &bits, sizeof(value));
+				return value;
+			}
+		default:
+			return 1.5;
+		}
+	}
+
+	void TestEncoder()
+	{
+		int chains = 0;
+		for (int i = 0; i < ENCODE_ITERATIONS; i++)
+		{
+			const unsigned long long userId = R.OneIn(4) ? 0 : (R.OneIn(2) ? R.Below(300) : R.Next());
+
+			// 닉네임은 C_LOGIN에서, 채팅은 C_CHAT_View에서 검사하므로 항상 올바른 UTF-8
+			const string nickname = RandomUtf8String();
+			string msg = RandomUtf8String();
+			if (R.OneIn(200))
+			{
+				// 한 청크 경계 근처
+				msg = string(SendBufferManager::MAX_BUFFER_SIZE - 10 - R.Below(40), 'z');
+			}
+			else if (R.OneIn(500))
+			{
+				// 64KB를 넘는 v2 프레임
+				msg = string(70000 + R.Below(100000), 'q');
+			}
+			const double timestamp = RandomTimestamp();
+
+			Protocol::User user;
+			user.set_id(userId);
+			user.set_nickname(nickname);
+			const string encodedUser = PacketCodec::EncodeUser(userId, nickname);
+			TEST_CHECK(encodedUser == user.SerializeAsString());
+
+			// 닉네임을 담은 S_CHAT
+			Protocol::S_CHAT chat;
+			*chat.mutable_user() = user;
+			chat.set_msg(msg);
+			chat.set_timestamp(timestamp);
+			SendBufferRef expected = PacketHandler::MakeBuffer_S_CHAT(chat);
+			SendBufferRef actual = PacketCodec::MakeBuffer_S_CHAT(encodedUser, msg, timestamp);
+			TEST_CHECK((expected == nullptr) == (actual == nullptr));
+			if (actual == nullptr)
+			{
+				continue;
+			}
+			TEST_CHECK(Flatten(actual) == Flatten(expected));
+			CheckRoundTrip(Flatten(actual), Protocol::PACKET_ID_S_CHAT);
+			chains += actual->Next() != nullptr ? 1 : 0;
+
+			// userId만 담은 S_CHAT
+			Protocol::S_CHAT compact;
+			compact.set_userid(userId);
+			compact.set_msg(msg);
+			compact.set_timestamp(timestamp);
+			SendBufferRef compactExpected = PacketHandler::MakeBuffer_S_CHAT(compact);
+			SendBufferRef compactActual = PacketCodec::MakeBuffer_S_CHAT_UserId(userId, msg, timestamp);
+			TEST_CHECK(Flatten(compactActual) == Flatten(compactExpected));
+			CheckRoundTrip(Flatten(compactActual), Protocol::PACKET_ID_S_CHAT);
+
+			// User를 붙여 쓰는 나머지 패킷
+			Protocol::S_OTHER_ENTER enter;
+			*enter.mutable_user() = user;
+			enter.set_timestamp(timestamp);
+			TEST_CHECK(Flatten(PacketCodec::MakeBuffer_S_OTHER_ENTER(encodedUser, timestamp)) ==
+				Flatten(PacketHandler::MakeBuffer_S_OTHER_ENTER(enter)));
+
+			Protocol::S_OTHER_LEAVE leave;
+			*leave.mutable_user() = user;
+			leave.set_timestamp(timestamp);
+			TEST_CHECK(Flatten(PacketCodec::MakeBuffer_S_OTHER_LEAVE(encodedUser, timestamp)) ==
+				Flatten(PacketHandler::MakeBuffer_S_OTHER_LEAVE(leave)));
+
+			Protocol::S_USER_DICTIONARY dictionary;
+			*dictionary.add_users() = user;
+			TEST_CHECK(Flatten(PacketCodec::MakeBuffer_S_USER_DICTIONARY(encodedUser)) ==
+				Flatten(PacketHandler::MakeBuffer_S_USER_DICTIONARY(dictionary)));
+		}
+
+		TEST_CHECK(chains > 0);
+		printf("encoder : %d packets, %d chained\n", ENCODE_ITERATIONS, chains);
+	}
+}
+
+
+int main()
+{
+	// 올바르지 않은 UTF-8을 거부할 때마다 남기는 protobuf 로그를 끔
+	google::protobuf::SetLogHandler(nullptr);
+
+	TestDecoder();
+	TestEncoder();
+	return 0;
+}
@@ -0,0 +1,461 @@
+﻿#include "pch.h"
+#include "PacketCompressor.h"
+#include "Protocol.pb.h"
+#include "TestUtils.h"
+#include <cstring>
+
+/*
+ * PacketCompressor 테스트
+ * 압축한 블록이 원본으로 풀리는지, 받은 블록의 잘못된 길이와 오프셋을 거부하는지 확인합니다.
+ * Decompress는 HandleCompressedPacket을 통해 클라이언트가 보낸 바이트를 그대로 읽습니다.
+ */
+
+namespace
+{
+	enum
+	{
+		ROUND_TRIP_ITERATIONS = 3000,
+		MUTATION_ITERATIONS = 20000,
+	};
+
+	TestRandom R(0xC0DEC);
+
+	using Bytes = vector<BYTE>;
+
+	Bytes RandomData(unsigned int size)
+	{
+		static const char* words[] = {"alice", "bob", "room ", "hello ", "\x1a\x0b\x0a\x05", "\x20\x64\x28\x01\x12"};
+
+		Bytes out;
+		out.reserve(size);
+		const unsigned long long kind = R.Below(5);
+		while (out.size() < size)
+		{
+			switch (kind)
+			{
+			case 0:
+				// 압축되지 않는 데이터
+				out.push_back(static_cast<BYTE>(R.Below(256)));
+				break;
+			case 1:
+				{
+					const char* word = words[R.Below(std::size(words))];
+					out.insert(out.end(), word, word + strlen(word));
+				}
+				break;
+			case 2:
+				// 매치가 짧고 자주 끊기는 데이터
+				out.push_back(static_cast<BYTE>('a' + R.Below(3)));
+				break;
+			case 3:
+				// 긴 반복, 추가 길이 바이트와 겹치는 매치
+				out.insert(out.end(), R.Below(600), static_cast<BYTE>(R.Below(256)));
+				break;
+			default:
+				// 앞부분을 다시 복사한 데이터, 먼 오프셋의 매치
+				if (out.size() > 8 && R.OneIn(4))
+				{
+					const size_t from = R.Below(out.size() - 4);
+					const size_t length = min<size_t>(4 + R.Below(300), out.size() - from);
+					Bytes copy(out.begin() + from, out.begin() + from + length);
+					out.insert(out.end(), copy.begin(), copy.end());
+				}
+				else
+				{
+					out.push_back(static_cast<BYTE>(R.Below(256)));
+				}
+				break;
+			}
+		}
+		out.resize(size);
+		return out;
+	}
+
+	Bytes Compress(const Bytes& data)
+	{
+		Bytes block(PacketCompressor::CompressBound(static_cast<unsigned int>(data.size())));
+		const unsigned int blockSize = PacketCompressor::CompressBlock(data.data(), static_cast<unsigned int>(data.size()), block.data());
+		TEST_CHECK(blockSize <= block.size());
+		block.resize(blockSize);
+		return block;
+	}
+
+	/**
+	 * \brief 블록을 dstSize 크기로 푸는 함수
+	 * \details 풀 공간 뒤에 표식을 두어 dstSize를 넘어 쓰지 않는지도 확인합니다.
+	 */
+	bool Decompress(const Bytes& block, unsigned int dstSize, Bytes* out = nullptr)
+	{
+		Bytes dst(dstSize + 16, 0xCD);
+		const bool ok = PacketCompressor::Decompress(block.data(), static_cast<unsigned int>(block.size()), dst.data(), dstSize);
+		for (unsigned int i = dstSize; i < dst.size(); i++)
+		{
+			TEST_CHECK(dst[i] == 0xCD);
+		}
+
+		if (out != nullptr)
+		{
+			dst.resize(dstSize);
+			*out = move(dst);
+		}
+		return ok;
+	}
+
+	void CheckRoundTrip(const Bytes& data)
+	{
+		const Bytes block = Compress(data);
+		Bytes out;
+		TEST_CHECK(Decompress(block, static_cast<unsigned int>(data.size()), &out));
+		TEST_CHECK(out == data);
+
+		// 풀린 크기는 정확히 같아야 함
+		TEST_CHECK(Decompress(block, static_cast<unsigned int>(data.size()) + 1) == false);
+		if (data.empty() == false)
+		{
+			TEST_CHECK(Decompress(block, static_cast<unsigned int>(data.size()) - 1) == false);
+		}
+	}
+
+	/** \brief 토큰 4비트를 넘는 길이의 추가 바이트 */
+	void AppendLength(Bytes& out, unsigned int length)
+	{
+		for (; length >= 0xFF; length -= 0xFF)
+		{
+			out.push_back(0xFF);
+		}
+		out.push_back(static_cast<BYTE>(length));
+	}
+
+	/**
+	 * \brief 시퀀스 하나를 쓰는 함수
+	 * \param offset 0이라면 리터럴만 담은 마지막 시퀀스
+	 */
+	void AppendSequence(Bytes& out, const string& literal, unsigned int offset, unsigned int matchLength)
+	{
+		const unsigned int literalLength = static_cast<unsigned int>(literal.size());
+		const unsigned int matchCode = offset == 0 ? 0 : matchLength - PacketCompressor::MIN_MATCH;
+		out.push_back(static_cast<BYTE>((min(literalLength, 15u) << 4) | min(matchCode, 15u)));
+		if (literalLength >= 15)
+		{
+			AppendLength(out, literalLength - 15);
+		}
+		out.insert(out.end(), literal.begin(), literal.end());
+		if (offset == 0)
+		{
+			return;
+		}
+
+		out.push_back(static_cast<BYTE>(offset));
+		out.push_back(static_cast<BYTE>(offset >> 8));
+		if (matchCode >= 15)
+		{
+			AppendLength(out, matchCode - 15);
+		}
+	}
+
+	/**
+	 * \brief 블록의 기대 결과를 프리셋 사전 뒤에 이어 쓰며 만드는 함수
+	 * \details 프리셋 사전은 첫 매치로 통째로 복사하여 얻습니다.
+	 */
+	Bytes PresetDictionary()
+	{
+		const unsigned int dictionarySize = PacketCompressor::PresetDictionarySize();
+		Bytes block;
+		AppendSequence(block, "", dictionarySize, dictionarySize);
+		AppendSequence(block, "", 0, 0);
+
+		Bytes dictionary;
+		TEST_CHECK(Decompress(block, dictionarySize, &dictionary));
+		return dictionary;
+	}
+
+	void TestRoundTrip()
+	{
+		CheckRoundTrip(Bytes());
+		CheckRoundTrip(Bytes(1, 'x'));
+		CheckRoundTrip(Bytes(100000, 'x'));
+
+		// 프리셋 사전과 같은 데이터는 사전 매치로 줄어듦
+		const Bytes dictionary = PresetDictionary();
+		CheckRoundTrip(dictionary);
+		TEST_CHECK(Compress(dictionary).size() < dictionary.size() / 4);
+
+		// 64KB 창을 넘는 반복은 매치가 되지 않아야 함
+		Bytes far = RandomData(0x10000 + 100);
+		copy(far.begin(), far.begin() + 100, far.end() - 100);
+		CheckRoundTrip(far);
+
+		unsigned long long totalSize = 0;
+		unsigned long long totalBlock = 0;
+		for (int i = 0; i < ROUND_TRIP_ITERATIONS; i++)
+		{
+			const unsigned int size = static_cast<unsigned int>(R.OneIn(20) ? R.Below(200000) : R.Below(4000));
+			const Bytes data = RandomData(size);
+			CheckRoundTrip(data);
+			totalSize += data.size();
+			totalBlock += Compress(data).size();
+		}
+		printf("round trip : %d blocks, %llu -> %llu bytes\n", ROUND_TRIP_ITERATIONS, totalSize, totalBlock);
+	}
+
+	void TestHandmadeBlocks()
+	{
+		const unsigned int dictionarySize = PacketCompressor::PresetDictionarySize();
+		const Bytes dictionary = PresetDictionary();
+		Bytes out;
+
+		// 리터럴 뒤 오프셋 1, 2의 겹치는 매치
+		{
+			Bytes block;
+			AppendSequence(block, "ab", 2, 10);
+			AppendSequence(block, "c", 1, 300);
+			AppendSequence(block, "", 0, 0);
+			TEST_CHECK(Decompress(block, 313, &out));
+			TEST_CHECK(string(out.begin(), out.begin() + 12) == "abababababab");
+			TEST_CHECK(out[12] == 'c' && count(out.begin() + 12, out.end(), 'c') == 301);
+		}
+
+		// 프리셋 사전에서 시작하여 풀린 데이터로 이어지는 매치
+		{
+			Bytes block;
+			AppendSequence(block, "xy", dictionarySize + 2, dictionarySize + 6);
+			AppendSequence(block, "", 0, 0);
+			TEST_CHECK(Decompress(block, dictionarySize + 8, &out));
+
+			Bytes expected = dictionary;
+			expected.push_back('x');
+			expected.push_back('y');
+			for (unsigned int i = 0; i < dictionarySize + 6; i++)
+			{
+				expected.push_back(expected[expected.size() - (dictionarySize + 2)]);
+			}
+			TEST_CHECK(out == Bytes(expected.begin() + dictionarySize, expected.end()));
+		}
+
+		// 긴 리터럴
+		{
+			Bytes block;
+			AppendSequence(block, string(15 + 255 * 2, 'L'), 0, 0);
+			TEST_CHECK(Decompress(block, 15 + 255 * 2, &out));
+			TEST_CHECK(out == Bytes(15 + 255 * 2, 'L'));
+		}
+	}
+
+	void TestInvalidBlocks()
+	{
+		const unsigned int dictionarySize = PacketCompressor::PresetDictionarySize();
+
+		// 빈 블록
+		TEST_CHECK(Decompress(Bytes(), 0) == false);
+
+		// 리터럴이 잘림
+		TEST_CHECK(Decompress(Bytes{0x50, 'a', 'b', 'c'}, 5) == false);
+
+		// 리터럴 추가 길이 바이트가 잘림
+		TEST_CHECK(Decompress(Bytes{0xF0}, 15) == false);
+		TEST_CHECK(Decompress(Bytes{0xF0, 0xFF}, 15 + 255) == false);
+
+		// 오프셋이 잘림
+		TEST_CHECK(Decompress(Bytes{0x10, 'a', 0x01}, 5) == false);
+
+		// 매치 추가 길이 바이트가 잘림
+		TEST_CHECK(Decompress(Bytes{0x1F, 'a', 0x01, 0x00}, 100) == false);
+
+		// 오프셋 0
+		{
+			Bytes block;
+			AppendSequence(block, "abcd", 0, 0);
+			block[0] = 0x40;
+			block.insert(block.end(), {0x00, 0x00});
+			AppendSequence(block, "", 0, 0);
+			TEST_CHECK(Decompress(block, 8) == false);
+		}
+
+		// 풀린 크기와 프리셋 사전을 넘어 거슬러 오르는 오프셋, 경계는 허용
+		{
+			Bytes valid;
+			AppendSequence(valid, "abcd", 4 + dictionarySize, 4);
+			AppendSequence(valid, "", 0, 0);
+			TEST_CHECK(Decompress(valid, 8));
+
+			Bytes invalid;
+			AppendSequence(invalid, "abcd", 4 + dictionarySize + 1, 4);
+			AppendSequence(invalid, "", 0, 0);
+			TEST_CHECK(Decompress(invalid, 8) == false);
+
+			Bytes first;
+			AppendSequence(first, "", dictionarySize + 1, 4);
+			AppendSequence(first, "", 0, 0);
+			TEST_CHECK(Decompress(first, 4) == false);
+		}
+
+		// 원본 크기를 넘는 리터럴과 매치 길이
+		{
+			Bytes literal;
+			AppendSequence(literal, string(100, 'a'), 0, 0);
+			TEST_CHECK(Decompress(literal, 99) == false);
+
+			Bytes match;
+			AppendSequence(match, "a", 1, 100);
+			AppendSequence(match, "", 0, 0);
+			TEST_CHECK(Decompress(match, 100) == false);
+		}
+
+		// 원본 크기를 한참 넘는 추가 길이 바이트, 길이를 더하다 넘치지 않아야 함
+		{
+			Bytes literal{0xF0};
+			literal.insert(literal.end(), 0x20000, 0xFF);
+			literal.push_back(0x00);
+			TEST_CHECK(Decompress(literal, 0x100) == false);
+
+			Bytes match{0x1F, 'a', 0x01, 0x00};
+			match.insert(match.end(), 0x20000, 0xFF);
+			match.push_back(0x00);
+			TEST_CHECK(Decompress(match, 0x100) == false);
+		}
+
+		// 마지막 시퀀스가 없어 원본 크기보다 적게 풀림
+		{
+			Bytes block;
+			AppendSequence(block, "abcd", 0, 0);
+			TEST_CHECK(Decompress(block, 5) == false);
+		}
+	}
+
+	/**
+	 * \brief 올바른 블록을 변형하여 푸는 함수
+	 * \details 성공 여부와 상관없이 dstSize를 넘어 쓰지 않아야 합니다. ASan 빌드에서는 범위 밖 읽기도 확인됩니다.
+	 */
+	void TestMutatedBlocks()
+	{
+		int accepted = 0;
+		for (int i = 0; i < MUTATION_ITERATIONS; i++)
+		{
+			const Bytes data = RandomData(static_cast<unsigned int>(R.Below(2000)));
+			Bytes block = Compress(data);
+			if (block.empty())
+			{
+				continue;
+			}
+
+			const unsigned long long count = 1 + R.Below(3);
+			for (unsigned long long k = 0; k < count; k++)
+			{
+				switch (R.Below(3))
+				{
+				case 0:
+					if (block.empty() == false)
+					{
+						block[R.Below(block.size())] ^= static_cast<BYTE>(1 << R.Below(8));
+					}
+					break;
+				case 1:
+					block.resize(R.Below(block.size() + 1));
+					break;
+				default:
+					block.insert(block.begin() + R.Below(block.size() + 1), static_cast<BYTE>(R.Below(256)));
+					break;
+				}
+			}
+
+			const unsigned int dstSize = R.OneIn(2) ? static_cast<unsigned int>(data.size()) : static_cast<unsigned int>(R.Below(4000));
+			accepted += Decompress(block, dstSize) ? 1 : 0;
+		}
+		printf("mutation : %d blocks, %d still decoded\n", MUTATION_ITERATIONS, accepted);
+	}
+
+	/**
+	 * \brief 패킷 단위 압축을 확인하는 함수
+	 * \details 헤더 id의 압축 표시, 원본 데이터 크기, 체인과 v2 헤더를 확인합니다.
+	 */
+	void TestCompressPacket()
+	{
+		const unsigned int sizes[] = {PacketCompressor::COMPRESS_THRESHOLD, 0x1000, SendBufferManager::MAX_BUFFER_SIZE * 3, 0x30000};
+		for (unsigned int dataSize : sizes)
+		{
+			Bytes data = RandomData(dataSize);
+			for (size_t i = 0; i < data.size(); i += 32)
+			{
+				// 작아지도록 반복을 섞음
+				fill(data.begin() + i, data.begin() + min(i + 16, data.size()), 'r');
+			}
+
+			const unsigned int headerSize = dataSize + sizeof(PacketHeader) > 0xFFFF ? sizeof(PacketHeaderV2) : sizeof(PacketHeader);
+			const unsigned int packetSize = headerSize + dataSize;
+			SendBufferRef sendBuffer = packetSize <= SendBufferManager::MAX_BUFFER_SIZE
+				? GSendBufferManager->Open(packetSize) : GSendBufferManager->OpenChain(packetSize);
+			Bytes packet(packetSize);
+			if (headerSize == sizeof(PacketHeader))
+			{
+				PacketHeader header = {static_cast<unsigned short>(packetSize), Protocol::PACKET_ID_S_ROOM_LIST};
+				memcpy(packet.data(), &header, sizeof(header));
+			}
+			else
+			{
+				PacketHeaderV2 header = {0, Protocol::PACKET_ID_S_ROOM_LIST, packetSize};
+				memcpy(packet.data(), &header, sizeof(header));
+			}
+			copy(data.begin(), data.end(), packet.begin() + headerSize);
+
+			const BYTE* read = packet.data();
+			if (packetSize <= SendBufferManager::MAX_BUFFER_SIZE)
+			{
+				memcpy(sendBuffer->Buffer(), read, packetSize);
+				sendBuffer->Close(packetSize);
+			}
+			else
+			{
+				for (SendBuffer* segment = sendBuffer.get(); segment != nullptr; segment = segment->Next())
+				{
+					memcpy(segment->Buffer(), read, segment->WriteSize());
+					read += segment->WriteSize();
+				}
+			}
+
+			TEST_CHECK(PacketCompressor::ShouldCompress(sendBuffer));
+			SendBufferRef compressed = PacketCompressor::Compress(sendBuffer);
+			TEST_CHECK(compressed != nullptr);
+			TEST_CHECK(PacketCompressor::ShouldCompress(compressed) == false);
+
+			const string wire = Flatten(compressed);
+			TEST_CHECK(wire.size() == compressed->PacketSize() && wire.size() < packetSize);
+
+			PacketHeader header;
+			memcpy(&header, wire.data(), sizeof(header));
+			TEST_CHECK(header.id == (Protocol::PACKET_ID_S_ROOM_LIST | PACKET_ID_COMPRESSED_FLAG));
+			const unsigned int compressedHeaderSize = header.size == 0 ? sizeof(PacketHeaderV2) : sizeof(PacketHeader);
+
+			unsigned int rawSize;
+			memcpy(&rawSize, wire.data() + compressedHeaderSize, sizeof(rawSize));
+			TEST_CHECK(rawSize == dataSize);
+
+			const Bytes block(wire.begin() + compressedHeaderSize + sizeof(rawSize), wire.end());
+			Bytes out;
+			TEST_CHECK(Decompress(block, rawSize, &out));
+			TEST_CHECK(out == data);
+		}
+
+		// 작아지지 않는 패킷은 압축하지 않음
+		const unsigned int packetSize = 0x400;
+		SendBufferRef noise = GSendBufferManager->Open(packetSize);
+		PacketHeader header = {static_cast<unsigned short>(packetSize), Protocol::PACKET_ID_S_CHAT};
+		memcpy(noise->Buffer(), &header, sizeof(header));
+		for (unsigned int i = sizeof(header); i < packetSize; i++)
+		{
+			noise->Buffer()[i] = static_cast<BYTE>(R.Below(256));
+		}
+		noise->Close(packetSize);
+		TEST_CHECK(PacketCompressor::Compress(noise) == nullptr);
+	}
+}
+
+
+int main()
+{
+	TestRoundTrip();
+	TestHandmadeBlocks();
+	TestInvalidBlocks();
+	TestMutatedBlocks();
+	TestCompressPacket();
+	return 0;
+}
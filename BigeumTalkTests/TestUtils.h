@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+/*
+ * 테스트 공용 도구
+ * 테스트는 프레임워크 없이 실행 파일 하나로 동작하며, 실패하면 위치를 출력하고 1로 종료합니다.
+ */
+
+#define TEST_CHECK(expr)																\
+{																						\
+	if (!(expr))																		\
+	{																					\
+		std::fprintf(stderr, "%s:%d: TEST_CHECK(%s) failed\n", __FILE__, __LINE__, #expr);	\
+		std::exit(1);																	\
+	}																					\
+}
+
+
+/**
+ * \brief 테스트용 난수 생성기
+ * \details 실패를 재현할 수 있도록 고정된 시드로 시작합니다.
+ */
+class TestRandom
+{
+public:
+	explicit TestRandom(unsigned long long seed) : _engine(seed)
+	{
+	}
+
+	/** \brief 64비트 난수를 반환하는 함수 */
+	unsigned long long Next() { return _engine(); }
+
+	/** \brief [0, bound) 범위의 난수를 반환하는 함수 */
+	unsigned long long Below(unsigned long long bound) { return _engine() % bound; }
+
+	/** \brief 1 / n 확률로 참을 반환하는 함수 */
+	bool OneIn(unsigned long long n) { return Below(n) == 0; }
+
+private:
+	std::mt19937_64 _engine;
+};
+
+
+/**
+ * \brief SendBuffer 체인 전체를 이어 붙여 반환하는 함수
+ * \param sendBuffer 체인의 첫 버퍼
+ * \return 송신될 바이트열
+ */
+inline std::string Flatten(const SendBufferRef& sendBuffer)
+{
+	std::string out;
+	for (SendBuffer* segment = sendBuffer.get(); segment != nullptr; segment = segment->Next())
+	{
+		out.append(reinterpret_cast<const char*>(segment->Buffer()), segment->WriteSize());
+	}
+	return out;
+}
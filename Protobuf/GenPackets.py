@@ -0,0 +1,140 @@
+"""
+패킷 코드 생성기
+
+Protocol.proto의 PacketId enum을 읽어 서버의 패킷 처리 코드를 생성합니다.
+  - PACKET_ID_C_XXX : Handle_C_XXX 선언과 디스패치 테이블 항목
+  - PACKET_ID_S_XXX : PacketHandler::MakeBuffer_S_XXX
+
+VIEW_TYPES에 등록한 클라이언트 패킷은 protobuf 메시지 대신 PacketCodec.h의 뷰 타입으로 파싱합니다.
+
+사용법 : python GenPackets.py [proto 경로] [출력 경로]
+"""
+
+import os
+import re
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_PROTO = os.path.join(SCRIPT_DIR, 'Protocol.proto')
+DEFAULT_OUTPUT = os.path.join(SCRIPT_DIR, '..', 'BigeumTalkServer', 'GenPackets.h')
+
+ID_PREFIX = 'PACKET_ID_'
+
+# 직접 읽는 클라이언트 패킷과 뷰 타입 (PacketCodec.h)
+VIEW_TYPES = {
+    'C_CHAT': 'C_CHAT_View',
+}
+
+
+def parse_proto(text):
+    """PacketId enum 항목 (이름, 값) 목록과 정의된 message 이름 집합을 반환"""
+    text = re.sub(r'//.*', '', text)
+
+    enum = re.search(r'enum\s+PacketId\s*\{(.*?)\}', text, re.S)
+    if enum is None:
+        raise ValueError('PacketId enum not found')
+
+    ids = [(name, int(value)) for name, value in re.findall(r'(\w+)\s*=\s*(\d+)\s*;', enum.group(1))]
+    messages = set(re.findall(r'message\s+(\w+)', text))
+    return ids, messages
+
+
+def collect(ids, messages):
+    """클라이언트 패킷과 서버 패킷 이름 목록을 반환"""
+    client, server = [], []
+    for name, value in ids:
+        if not name.startswith(ID_PREFIX):
+            raise ValueError(f'{name} does not start with {ID_PREFIX}')
+
+        packet = name[len(ID_PREFIX):]
+        if packet == 'NONE':
+            continue
+        if value >= 0x8000:
+            raise ValueError(f'{name} = {value} overlaps the compressed flag and framing ids')
+        if packet not in messages:
+            raise ValueError(f'message {packet} for {name} not found')
+
+        if packet.startswith('C_'):
+            client.append(packet)
+        elif packet.startswith('S_'):
+            server.append(packet)
+        else:
+            raise ValueError(f'{name} must be C_ or S_ packet')
+    return client, server
+
+
+def packet_type(packet):
+    """처리 함수가 받을 패킷 타입"""
+    return VIEW_TYPES.get(packet, f'Protocol::{packet}')
+
+
+def generate(client, server):
+    out = []
+    out.append('#pragma once')
+    out.append('')
+    out.append('/*')
+    out.append(' * 자동 생성 파일입니다. 직접 수정하지 말고 Protobuf/GenPackets.py를 실행하세요.')
+    out.append(' * Protocol.proto의 PacketId로부터 패킷 처리 함수 선언, 디스패치 테이블 항목, MakeBuffer 함수를 만듭니다.')
+    out.append(' */')
+    out.append('')
+    out.append('class Session;')
+    out.append('')
+    out.append('/* 패킷 처리 함수, PacketHandler.cpp에 정의 */')
+    for packet in client:
+        out.append(f'bool Handle_{packet}(shared_ptr<Session>& session, {packet_type(packet)}& pkt);')
+    out.append('')
+    out.append('')
+    out.append('/**')
+    out.append(' * \\brief 패킷 처리 함수 목록')
+    out.append(' * \\details 프로토콜 ID, 패킷, 처리 함수 항목으로 디스패치 테이블을 만듭니다.')
+    out.append(' * \\tparam Entry 항목 템플릿 (PacketHandlerEntry)')
+    out.append(' * \\tparam Table 테이블 템플릿 (PacketHandlerTable)')
+    out.append(' */')
+    out.append('template <template <unsigned short, typename, auto> class Entry, template <typename...> class Table>')
+    out.append('using GenPacketHandlerList = Table<')
+    for i, packet in enumerate(client):
+        comma = ',' if i + 1 < len(client) else ''
+        out.append(f'\tEntry<Protocol::{ID_PREFIX}{packet}, {packet_type(packet)}, Handle_{packet}>{comma}')
+    out.append('>;')
+    out.append('')
+    out.append('')
+    out.append('/**')
+    out.append(' * \\brief 서버 패킷 직렬화 함수 목록')
+    out.append(' * \\details PacketHandler가 상속하여 PacketHandler::MakeBuffer_S_로 사용합니다.')
+    out.append(' * \\tparam Handler MakeSendBuffer를 가진 클래스 (PacketHandler)')
+    out.append(' */')
+    out.append('template <typename Handler>')
+    out.append('class GenPacketMaker')
+    out.append('{')
+    out.append('public:')
+    for i, packet in enumerate(server):
+        out.append(f'\tstatic SendBufferRef MakeBuffer_{packet}(Protocol::{packet}& pkt)')
+        out.append('\t{')
+        out.append(f'\t\treturn Handler::MakeSendBuffer(pkt, Protocol::{ID_PREFIX}{packet});')
+        out.append('\t}')
+        if i + 1 < len(server):
+            out.append('')
+    out.append('};')
+    out.append('')
+    return '\n'.join(out)
+
+
+def main():
+    proto = sys.argv[1] if len(sys.argv) > 1 else DEFAULT_PROTO
+    output = sys.argv[2] if len(sys.argv) > 2 else DEFAULT_OUTPUT
+
+    with open(proto, encoding='utf-8') as f:
+        ids, messages = parse_proto(f.read())
+
+    client, server = collect(ids, messages)
+    code = generate(client, server)
+
+    # 저장소의 다른 소스와 같이 BOM이 있는 UTF-8, LF로 저장
+    with open(output, 'w', encoding='utf-8-sig', newline='\n') as f:
+        f.write(code)
+
+    print(f'{output} : {len(client)} handlers, {len(server)} makers')
+
+
+if __name__ == '__main__':
+    main()
@@ -7,6 +7,8 @@ protoc.exe --js_out=import_style=commonjs,binary:. ./Protocol.proto
 XCOPY /Y Protocol.pb.cc "../BigeumTalkServer"
 XCOPY /Y Protocol.pb.h "../BigeumTalkServer"
 
+python GenPackets.py
+
 DEL /Q /F *.pb.h
 DEL /Q /F *pb.cc
 
@@ -0,0 +1,16 @@
+#!/bin/sh
+# GenProtocol.bat과 같은 작업을 하는 스크립트, 설치된 protoc와 python3를 사용
+set -e
+cd "$(dirname "$0")"
+
+protoc -I=./ --cpp_out=./ ./Protocol.proto
+if command -v protoc-gen-js > /dev/null; then
+	protoc --js_out=import_style=commonjs,binary:. ./Protocol.proto
+fi
+
+cp -f Protocol.pb.cc ../BigeumTalkServer/
+cp -f Protocol.pb.h ../BigeumTalkServer/
+
+python3 GenPackets.py
+
+rm -f ./*.pb.h ./*.pb.cc